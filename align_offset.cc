@@ -1,4 +1,5 @@
 #include <iostream>
+#include "layout.h"
 
 using namespace std;
 
@@ -13,11 +14,22 @@ struct alignas(8) node
     uint16_t e; // 10
 };
 
+// 把上面注释里的偏移写成编译期断言，改动结构体导致布局变化时编译失败（见 layout.h）
+LAYOUT_OFFSET(node, a, 0);
+LAYOUT_OFFSET(node, b, 2);
+LAYOUT_OFFSET(node, c, 4);
+LAYOUT_OFFSET(node, d, 8);
+LAYOUT_OFFSET(node, e, 10);
+LAYOUT_SIZE(node, 16);                                                   // 字段只用到 12 字节，alignas(8) 补齐到 16
+LAYOUT_PADDING(node, 6, &node::a, &node::b, &node::c, &node::d, &node::e); // 1 + 2 + 4 + 1 + 2 = 10，其余 6 字节是填充
+
 int main(int argc, char const *argv[])
 {
     // offset 可以返回某个成员相对于结构体起始地址的偏移量（字节）
     cout << sizeof(node) << " " << alignof(node) << endl
          << offsetof(node, a) << " " << offsetof(node, b) << " "
          << offsetof(node, c) << " " << offsetof(node, d) << " " << offsetof(node, e) << endl;
+    print_layout<node>("node", {LAYOUT_FIELD(node, a), LAYOUT_FIELD(node, b), LAYOUT_FIELD(node, c),
+                                LAYOUT_FIELD(node, d), LAYOUT_FIELD(node, e)});
     return 0;
 }
\ No newline at end of file
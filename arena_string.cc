@@ -0,0 +1,99 @@
+#include <iostream>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <unordered_set>
+#include "arena_string.h"
+using namespace std;
+
+// 对比 std::string 与 arena_string 拼接缓存 key 的堆分配次数与吞吐量
+// 编译：g++ -std=c++17 -O2 arena_string.cc -o arena_string
+
+// 统计全局 operator new 的调用次数
+static atomic<long> allocations(0);
+void *operator new(size_t size)
+{
+    allocations.fetch_add(1, memory_order_relaxed);
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+static volatile size_t sink;
+
+// 每个请求拼接 keysPerRequest 个形如 prefix + id + ":" + field 的 key，并计算哈希
+template <typename BuildRequest>
+void run(const char *name, long requests, BuildRequest build)
+{
+    long before = allocations.load();
+    auto begin = chrono::steady_clock::now();
+    size_t h = 0;
+    for (long r = 0; r < requests; r++)
+        h += build(r);
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count();
+    sink = h;
+    cout << "  " << name << "\t" << ns / requests << " ns/request\t" << double(allocations.load() - before) / requests
+         << " allocations/request" << endl;
+}
+
+int main(int argc, char const *argv[])
+{
+    const long requests = 200000;
+    const int keysPerRequest = 16;
+    const char *fields[] = {"name", "email", "last_login", "preferences"};
+
+    // 三种存储方式对应 string_literal.cc 中的栈数组、.rodata 字面值与堆
+    StringArena demoArena;
+    arena_string inlined("Hello World", demoArena);
+    arena_string literal = arena_string::from_literal("Hello World");
+    arena_string spilled("Hello World, this does not fit inline", demoArena);
+    cout << "sizeof(arena_string) " << sizeof(arena_string) << ", sizeof(std::string) " << sizeof(string) << endl;
+    cout << "inline:  " << (const void *)inlined.c_str() << " (object at " << (const void *)&inlined << ")" << endl;
+    cout << "literal: " << (const void *)literal.c_str() << " (\"Hello World\" at " << (const void *)"Hello World"
+         << ")" << endl;
+    cout << "arena:   " << (const void *)spilled.c_str() << " " << spilled << endl;
+
+    for (const char *prefix : {"u:", "session:user_profile:"})
+    {
+        cout << "prefix \"" << prefix << "\"" << endl;
+        string_view pre(prefix);
+
+        run("std::string", requests, [&](long r)
+            {
+            size_t h = 0;
+            for (int k = 0; k < keysPerRequest; k++)
+            {
+                string key = prefix + to_string(r * keysPerRequest + k) + ":" + fields[k % 4];
+                h += hash<string>()(key);
+            }
+            return h; });
+
+        // 请求级 arena 以栈上的缓冲区为第一块，请求结束 reset
+        run("arena_string", requests, [&](long r)
+            {
+            char buffer[1024];
+            StringArena arena(buffer, sizeof(buffer));
+            size_t h = 0;
+            for (int k = 0; k < keysPerRequest; k++)
+            {
+                char digits[24];
+                char *end = to_chars(digits, digits + sizeof(digits), r * keysPerRequest + k).ptr;
+                arena_string key = arena_string::join(arena, {pre, string_view(digits, end - digits), ":", fields[k % 4]});
+                h += hash<arena_string>()(key);
+            }
+            return h; });
+    }
+
+    // 作为容器的 key
+    StringArena arena;
+    unordered_set<arena_string> seen;
+    seen.insert(arena_string::from_literal("u:1:name"));
+    seen.insert(arena_string::join(arena, {"u:", "1", ":", "name"}));
+    seen.insert(arena_string::join(arena, {"session:user_profile:", "1", ":", "preferences"}));
+    cout << "distinct keys in set: " << seen.size() << ", arena bytes used: " << arena.bytesUsed() << endl;
+    return 0;
+}
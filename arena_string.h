@@ -0,0 +1,204 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+/** 请求级的字符串 arena
+ *
+ * 只做指针递增，不单独释放；请求结束时 reset() 一次性回收。
+ * 可以传入调用方的缓冲区（通常是栈上的数组）作为第一块，够用时整个请求不调用一次 malloc；
+ * 不够时按块向堆申请，reset() 之后保留第一块堆内存，下一个请求直接复用。
+ */
+class StringArena
+{
+public:
+    explicit StringArena(size_t chunkSize = 4096) : chunkSize(chunkSize) {}
+    StringArena(char *buffer, size_t size, size_t chunkSize = 4096)
+        : initial(buffer), initialSize(size), cursor(buffer), left(size), chunkSize(chunkSize) {}
+    StringArena(const StringArena &) = delete;
+    StringArena &operator=(const StringArena &) = delete;
+
+    char *allocate(size_t n)
+    {
+        if (n > left)
+            grow(n);
+        char *p = cursor;
+        cursor += n;
+        left -= n;
+        used += n;
+        return p;
+    }
+
+    // 之前分配的字符串全部失效
+    void reset()
+    {
+        if (chunks.size() > 1)
+            chunks.resize(1);
+        if (initial)
+            cursor = initial, left = initialSize;
+        else if (!chunks.empty())
+            cursor = chunks[0].get(), left = chunkSize;
+        else
+            cursor = nullptr, left = 0;
+        nextChunk = initial ? 0 : chunks.size();
+        used = 0;
+    }
+
+    size_t bytesUsed() const { return used; }
+    size_t heapChunks() const { return chunks.size(); }
+
+private:
+    void grow(size_t n)
+    {
+        // reset 之后保留下来的那一块先复用
+        if (nextChunk < chunks.size() && n <= chunkSize)
+        {
+            cursor = chunks[nextChunk++].get();
+            left = chunkSize;
+            return;
+        }
+        size_t size = n > chunkSize ? n : chunkSize; // 超大的字符串单独占一块
+        chunks.emplace_back(new char[size]);
+        nextChunk = chunks.size();
+        cursor = chunks.back().get();
+        left = size;
+    }
+
+    char *initial = nullptr;
+    size_t initialSize = 0;
+    char *cursor = nullptr;
+    size_t left = 0;
+    size_t used = 0;
+    size_t chunkSize;
+    size_t nextChunk = 0;
+    std::vector<std::unique_ptr<char[]>> chunks;
+};
+
+/** 热路径上用作 key 的 24 字节字符串
+ *
+ * 对照 string_literal.cc 中的三种存储方式：
+ *      内联     长度 <= 23 时字符直接放在对象里，与栈上的 char a[] 一样，不涉及任何堆内存；
+ *      字面值   from_literal("...") 只记下 .rodata 中的地址和长度，与 const char *f 一样不复制；
+ *      arena    更长的字符串复制到调用方提供的 StringArena 中。
+ * 三种方式都以 '\0' 结尾，c_str() 可以直接交给 C 接口。
+ *
+ * 内联布局：buf[23] 存 23 - size，长度恰好为 23 时这个字节是 0，同时充当结尾的 '\0'；
+ * 非内联时 buf[23] 是 LITERAL / ARENA 标记，前 16 字节为指针和长度。
+ * 对象可以随意按位复制；arena 模式下的副本与原对象共享字符，有效期到 arena reset 为止。
+ */
+class arena_string
+{
+public:
+    static constexpr size_t INLINE_CAPACITY = 23;
+
+    arena_string() { setInline(0); }
+
+    // 短字符串内联，长字符串复制进 arena
+    arena_string(std::string_view s, StringArena &arena)
+    {
+        if (s.size() <= INLINE_CAPACITY)
+        {
+            memcpy(buf, s.data(), s.size());
+            setInline(s.size());
+        }
+        else
+        {
+            char *p = arena.allocate(s.size() + 1);
+            memcpy(p, s.data(), s.size());
+            p[s.size()] = '\0';
+            setExternal(p, s.size(), ARENA);
+        }
+    }
+
+    // 只接受字符数组，字面值的生命周期是整个程序，因此可以直接引用而不复制；
+    // 栈上的 char a[] 同样能匹配，这种用法要由调用方保证生命周期
+    template <size_t N>
+    static arena_string from_literal(const char (&literal)[N])
+    {
+        arena_string s;
+        s.setExternal(literal, N - 1, LITERAL);
+        return s;
+    }
+
+    // 拼接多个片段：总长度 <= 23 时直接在对象内拼接，否则在 arena 中只分配一次
+    static arena_string join(StringArena &arena, std::initializer_list<std::string_view> parts)
+    {
+        size_t total = 0;
+        for (std::string_view part : parts)
+            total += part.size();
+        arena_string s;
+        char *p = s.buf;
+        if (total > INLINE_CAPACITY)
+        {
+            p = arena.allocate(total + 1);
+            s.setExternal(p, total, ARENA);
+        }
+        for (std::string_view part : parts)
+        {
+            memcpy(p, part.data(), part.size());
+            p += part.size();
+        }
+        if (total > INLINE_CAPACITY)
+            *p = '\0';
+        else
+            s.setInline(total);
+        return s;
+    }
+
+    bool isInline() const { return (uint8_t)buf[INLINE_CAPACITY] <= INLINE_CAPACITY; }
+    bool isLiteral() const { return (uint8_t)buf[INLINE_CAPACITY] == LITERAL; }
+
+    const char *data() const { return isInline() ? buf : external.ptr; }
+    const char *c_str() const { return data(); }
+    size_t size() const { return isInline() ? INLINE_CAPACITY - buf[INLINE_CAPACITY] : external.len; }
+    bool empty() const { return size() == 0; }
+    std::string_view view() const { return std::string_view(data(), size()); }
+    operator std::string_view() const { return view(); }
+
+    bool operator==(const arena_string &other) const { return view() == other.view(); }
+    bool operator!=(const arena_string &other) const { return view() != other.view(); }
+    bool operator<(const arena_string &other) const { return view() < other.view(); }
+
+    friend std::ostream &operator<<(std::ostream &os, const arena_string &s) { return os << s.view(); }
+
+private:
+    static constexpr uint8_t LITERAL = 0x80, ARENA = 0x81;
+
+    void setInline(size_t n)
+    {
+        buf[n] = '\0';
+        buf[INLINE_CAPACITY] = char(INLINE_CAPACITY - n);
+    }
+    void setExternal(const char *p, size_t n, uint8_t tag)
+    {
+        external.ptr = p;
+        external.len = n;
+        buf[INLINE_CAPACITY] = char(tag);
+    }
+
+    union
+    {
+        char buf[INLINE_CAPACITY + 1];
+        struct
+        {
+            const char *ptr;
+            size_t len;
+        } external;
+    };
+};
+
+static_assert(sizeof(arena_string) == 24, "arena_string must stay at 24 bytes");
+
+namespace std
+{
+    template <>
+    struct hash<arena_string>
+    {
+        size_t operator()(const arena_string &s) const { return hash<string_view>()(s.view()); }
+    };
+} // namespace std
@@ -0,0 +1,462 @@
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <variant>
+#include "bench.h"
+#include "fast_cast.h"
+#include "lockfree_queue.h"
+#include "lru_cache.h"
+#include "segment_tree.h"
+#include "static_dispatch.h"
+#include "thread_pool.h"
+#include "timer_wheel.h"
+using namespace std;
+
+// 各模块的基准套件，框架见 bench.h
+// 编译：make bench（或 g++ -std=c++20 -O2 -pthread bench.cc -o bench）
+// 运行：./bench [--filter=lru] [--scale=0.1] [--out=results.jsonl]
+// 对比：./bench --compare base.jsonl new.jsonl [--threshold=10]
+
+#pragma region LRU_Cache
+static const int LRU_KEYS = 100000;
+
+// 80% 的访问落在 20% 的 key 上
+static vector<int> skewedKeys(long n, int keys)
+{
+    mt19937 rng(1);
+    vector<int> out(n);
+    for (auto &k : out)
+        k = rng() % 5 ? rng() % (keys / 5) : rng() % keys;
+    return out;
+}
+
+BENCHMARK(lru, get_hit)
+{
+    LRU_Cache<int, long> cache(LRU_KEYS);
+    for (int k = 0; k < LRU_KEYS; k++)
+        cache.put(k, make_shared<long>(k));
+    vector<int> keys = skewedKeys(1 << 20, LRU_KEYS);
+    ctx.run(2000000, [&](long i)
+            { do_not_optimize(cache.get(keys[i & (keys.size() - 1)])); });
+}
+
+BENCHMARK(lru, put_evict)
+{
+    LRU_Cache<int, long> cache(LRU_KEYS / 10);
+    auto value = make_shared<long>(0);
+    ctx.run(1000000, [&](long i)
+            { cache.put(int(i % LRU_KEYS), value); });
+}
+
+// 读多写少：未命中时回填
+BENCHMARK(lru, mixed_90_10)
+{
+    LRU_Cache<int, long> cache(LRU_KEYS / 4);
+    vector<int> keys = skewedKeys(1 << 20, LRU_KEYS);
+    auto value = make_shared<long>(0);
+    ctx.run(2000000, [&](long i)
+            {
+        int k = keys[i & (keys.size() - 1)];
+        if (!cache.get(k))
+            cache.put(k, value); });
+}
+#pragma endregion
+
+#pragma region ThreadPool
+// 提交一个任务并等待结果：端到端延迟
+template <typename Pool>
+static void poolRoundTrip(BenchContext &ctx)
+{
+    Pool pool(2);
+    ctx.run(20000, [&](long i)
+            { pool.enqueue([]() {}).wait(); }, 1);
+}
+
+// 一次提交一批任务再全部等待：吞吐量
+template <typename Pool>
+static void poolThroughput(BenchContext &ctx)
+{
+    Pool pool(4);
+    const long tasks = ctx.scaled(200000), batch = 1000;
+    vector<future<void>> results;
+    results.reserve(batch);
+    ctx.begin();
+    for (long done = 0; done < tasks; done += batch)
+    {
+        auto t0 = chrono::steady_clock::now();
+        for (long i = 0; i < batch; i++)
+            results.push_back(pool.enqueue([]() {}));
+        for (auto &r : results)
+            r.wait();
+        results.clear();
+        ctx.record(chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / batch);
+    }
+    ctx.finish(tasks);
+}
+
+typedef BasicThreadPool<SharedTaskAlloc, LockFreeTaskQueue> LockFreeThreadPool;
+
+BENCHMARK(thread_pool, round_trip) { poolRoundTrip<ThreadPool>(ctx); }
+BENCHMARK(thread_pool, round_trip_lockfree) { poolRoundTrip<LockFreeThreadPool>(ctx); }
+BENCHMARK(thread_pool, throughput) { poolThroughput<ThreadPool>(ctx); }
+BENCHMARK(thread_pool, throughput_lockfree) { poolThroughput<LockFreeThreadPool>(ctx); }
+#pragma endregion
+
+#pragma region 时间轮
+// 稳态：轮中常驻 64K 个定时器，每次操作插入一个、取消一个较早插入的
+BENCHMARK(timer_wheel, insert_cancel)
+{
+    TimerWheel wheel;
+    mt19937_64 rng(11);
+    vector<TimerId> ids(1 << 16);
+    for (auto &id : ids)
+        id = wheel.insert(1 + rng() % (1 << 20), []() {});
+    ctx.run(1000000, [&](long i)
+            {
+        TimerId &id = ids[i & 0xffff];
+        wheel.cancel(id);
+        id = wheel.insert(1 + rng() % (1 << 20), []() {}); });
+}
+// 每次操作推进一个 tick，平均每个 tick 有 1 个定时器到期并重新插入
+BENCHMARK(timer_wheel, advance)
+{
+    TimerWheel wheel;
+    mt19937_64 rng(12);
+    const uint64_t SPAN = 1 << 16;
+    for (uint64_t i = 0; i < SPAN; i++)
+        wheel.insert(1 + rng() % SPAN, []() {}, SPAN);
+    vector<TimerWheel::Callback> due;
+    ctx.run(1000000, [&](long i)
+            {
+        wheel.advance(i + 1, due);
+        due.clear(); });
+}
+#pragma endregion
+
+#pragma region 线段树
+static const int TREE_N = 1 << 20;
+
+static vector<RangeOp> randomRanges(long count, int maxVal, unsigned seed)
+{
+    mt19937 rng(seed);
+    vector<RangeOp> ops(count);
+    for (auto &op : ops)
+    {
+        int a = rng() % TREE_N, b = rng() % TREE_N;
+        op = {min(a, b), max(a, b), int(rng() % maxVal)};
+    }
+    return ops;
+}
+
+static Node *randomTree()
+{
+    mt19937 rng(42);
+    vector<int> arr(TREE_N);
+    for (auto &v : arr)
+        v = rng() % 1000;
+    return build(arr);
+}
+
+BENCHMARK(segment_tree, update)
+{
+    unique_ptr<Node> root(randomTree());
+    vector<RangeOp> ops = randomRanges(1 << 16, 100, 7);
+    ctx.run(200000, [&](long i)
+            {
+        const RangeOp &op = ops[i & 0xffff];
+        update(root.get(), op.l, op.r, op.val); });
+}
+
+BENCHMARK(segment_tree, query)
+{
+    unique_ptr<Node> root(randomTree());
+    vector<RangeOp> qs = randomRanges(1 << 16, 1, 8);
+    ctx.run(200000, [&](long i)
+            {
+        const RangeOp &q = qs[i & 0xffff];
+        do_not_optimize(query(root.get(), q.l, q.r)); });
+}
+
+// 批量更新：按操作数计吞吐，延迟样本为每批的平均值
+BENCHMARK(segment_tree, batch_update)
+{
+    unique_ptr<Node> root(randomTree());
+    const long count = ctx.scaled(200000), batch = 20000;
+    vector<RangeOp> ops = randomRanges(count, 100, 9);
+    ctx.begin();
+    for (long i = 0; i < count; i += batch)
+    {
+        vector<RangeOp> chunk(ops.begin() + i, ops.begin() + min(count, i + batch));
+        sort(chunk.begin(), chunk.end(), [](const RangeOp &x, const RangeOp &y)
+             { return x.l < y.l; });
+        auto t0 = chrono::steady_clock::now();
+        batchUpdate(root.get(), chunk);
+        ctx.record(chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / chunk.size());
+    }
+    ctx.finish(count);
+}
+#pragma endregion
+
+#pragma region UDP（signal_driven_io.cc 的 SIGIO 回显）
+static int echoFd = -1;
+
+// 与 signal_driven_io.cc 的 do_sometime 相同，只是读到 EAGAIN 为止：多个数据报可能只产生一次 SIGIO
+static void echoOnSigio(int)
+{
+    int saved = errno;
+    char buffer[256];
+    sockaddr_in client;
+    socklen_t len = sizeof(client);
+    ssize_t n;
+    while ((n = recvfrom(echoFd, buffer, sizeof(buffer), 0, (sockaddr *)&client, &len)) >= 0)
+    {
+        sendto(echoFd, buffer, n, 0, (sockaddr *)&client, len);
+        len = sizeof(client);
+    }
+    errno = saved;
+}
+
+BENCHMARK(udp, sigio_echo_rtt)
+{
+    echoFd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    bind(echoFd, (sockaddr *)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(echoFd, (sockaddr *)&addr, &len);
+
+    struct sigaction act, old;
+    memset(&act, 0, sizeof(act));
+    act.sa_handler = echoOnSigio;
+    act.sa_flags = SA_RESTART; // 客户端阻塞在 recv 上时被信号打断后自动重启
+    sigaction(SIGIO, &act, &old);
+    fcntl(echoFd, F_SETOWN, getpid());
+    fcntl(echoFd, F_SETFL, fcntl(echoFd, F_GETFL, 0) | O_NONBLOCK | O_ASYNC);
+
+    int client = socket(AF_INET, SOCK_DGRAM, 0);
+    connect(client, (sockaddr *)&addr, sizeof(addr));
+    timeval timeout{1, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    char msg[64] = "ping", reply[64];
+    long lost = 0;
+    ctx.run(20000, [&](long i)
+            {
+        send(client, msg, sizeof(msg), 0);
+        if (recv(client, reply, sizeof(reply), 0) < 0)
+            lost++; }, 1);
+    if (lost)
+        cerr << "udp/sigio_echo_rtt: " << lost << " replies lost" << endl;
+
+    close(client);
+    sigaction(SIGIO, &old, nullptr);
+    close(echoFd);
+}
+#pragma endregion
+
+#pragma region 虚函数分发与类型转换
+struct Shape
+{
+    FAST_CAST_ROOT(Shape)
+    virtual ~Shape() {}
+    virtual double area() const = 0;
+    double size = 1.5;
+};
+
+template <int K>
+struct ShapeK : Shape
+{
+    FAST_CAST_CLASS(ShapeK<K>, Shape)
+    double area() const override { return size * (K + 1); }
+};
+
+template <int K>
+struct PlainShape
+{
+    double size = 1.5;
+    double area() const { return size * (K + 1); }
+};
+
+static const int SHAPES = 4096;
+
+// 四种类型交错排列，虚调用的目标每次都变
+static vector<unique_ptr<Shape>> shapes()
+{
+    mt19937 rng(5);
+    vector<unique_ptr<Shape>> out;
+    for (int i = 0; i < SHAPES; i++)
+        switch (rng() % 4)
+        {
+        case 0:
+            out.emplace_back(new ShapeK<0>());
+            break;
+        case 1:
+            out.emplace_back(new ShapeK<1>());
+            break;
+        case 2:
+            out.emplace_back(new ShapeK<2>());
+            break;
+        default:
+            out.emplace_back(new ShapeK<3>());
+        }
+    return out;
+}
+
+BENCHMARK(dispatch, virtual_mixed)
+{
+    auto owned = shapes();
+    vector<Shape *> objs;
+    for (auto &p : owned)
+        objs.push_back(p.get());
+    ctx.run(20000000, [&](long i)
+            { do_not_optimize(objs[i & (SHAPES - 1)]->area()); }, 4096);
+}
+
+BENCHMARK(dispatch, virtual_sorted)
+{
+    auto owned = shapes();
+    vector<Shape *> objs;
+    for (auto &p : owned)
+        objs.push_back(p.get());
+    sort_by_dynamic_type(objs);
+    ctx.run(20000000, [&](long i)
+            { do_not_optimize(objs[i & (SHAPES - 1)]->area()); }, 4096);
+}
+
+BENCHMARK(dispatch, variant_jump)
+{
+    typedef variant<PlainShape<0>, PlainShape<1>, PlainShape<2>, PlainShape<3>> V;
+    mt19937 rng(5);
+    vector<V> objs;
+    for (int i = 0; i < SHAPES; i++)
+        switch (rng() % 4)
+        {
+        case 0:
+            objs.emplace_back(PlainShape<0>());
+            break;
+        case 1:
+            objs.emplace_back(PlainShape<1>());
+            break;
+        case 2:
+            objs.emplace_back(PlainShape<2>());
+            break;
+        default:
+            objs.emplace_back(PlainShape<3>());
+        }
+    ctx.run(20000000, [&](long i)
+            { do_not_optimize(jump_visit([](const auto &s)
+                                         { return s.area(); },
+                                         objs[i & (SHAPES - 1)])); },
+            4096);
+}
+
+// 每次操作遍历整个集合，按元素数计
+BENCHMARK(dispatch, poly_collection)
+{
+    poly_collection<PlainShape<0>, PlainShape<1>, PlainShape<2>, PlainShape<3>> objs;
+    for (int i = 0; i < SHAPES / 4; i++)
+    {
+        objs.insert(PlainShape<0>());
+        objs.insert(PlainShape<1>());
+        objs.insert(PlainShape<2>());
+        objs.insert(PlainShape<3>());
+    }
+    const long rounds = ctx.scaled(20000000) / SHAPES + 1;
+    ctx.begin();
+    for (long r = 0; r < rounds; r++)
+    {
+        auto t0 = chrono::steady_clock::now();
+        double sum = 0;
+        objs.for_each([&](const auto &s)
+                      { sum += s.area(); });
+        do_not_optimize(sum);
+        ctx.record(chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / SHAPES);
+    }
+    ctx.finish(rounds * SHAPES);
+}
+
+BENCHMARK(cast, dynamic_cast)
+{
+    auto owned = shapes();
+    ctx.run(20000000, [&](long i)
+            { do_not_optimize(dynamic_cast<ShapeK<2> *>(owned[i & (SHAPES - 1)].get())); }, 4096);
+}
+
+BENCHMARK(cast, fast_cast)
+{
+    auto owned = shapes();
+    ctx.run(20000000, [&](long i)
+            { do_not_optimize(fast_cast<ShapeK<2> *>(owned[i & (SHAPES - 1)].get())); }, 4096);
+}
+#pragma endregion
+
+static void usage()
+{
+    cerr << "usage: bench [--filter=SUBSTR] [--scale=X] [--out=FILE]\n"
+            "       bench --compare BASE NEW [--threshold=PERCENT]\n"
+            "       bench --list"
+         << endl;
+}
+
+int main(int argc, char const *argv[])
+{
+    string filter, out;
+    double scale = 1, threshold = 10;
+    vector<string> compare;
+    bool comparing = false;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg.rfind("--filter=", 0) == 0)
+            filter = arg.substr(9);
+        else if (arg.rfind("--scale=", 0) == 0)
+            scale = stod(arg.substr(8));
+        else if (arg.rfind("--out=", 0) == 0)
+            out = arg.substr(6);
+        else if (arg.rfind("--threshold=", 0) == 0)
+            threshold = stod(arg.substr(12));
+        else if (arg == "--compare")
+            comparing = true;
+        else if (arg == "--list")
+        {
+            for (const string &name : BenchRegistry::instance().names())
+                cout << name << endl;
+            return 0;
+        }
+        else if (comparing && arg[0] != '-')
+            compare.push_back(arg);
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    if (comparing)
+    {
+        if (compare.size() != 2)
+        {
+            usage();
+            return 2;
+        }
+        int regressions = BenchRegistry::compare(BenchRegistry::load(compare[0]), BenchRegistry::load(compare[1]),
+                                                 threshold);
+        cout << regressions << " regression(s) beyond " << threshold << "%" << endl;
+        return regressions ? 1 : 0;
+    }
+
+    ofstream file;
+    if (!out.empty())
+        file.open(out);
+    BenchRegistry::instance().runAll(filter, scale, out.empty() ? nullptr : &file);
+    return 0;
+}
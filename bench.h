@@ -0,0 +1,292 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "perf_counter.h"
+
+/** 基准框架，各模块的基准见 bench.cc，构建与运行见 Makefile
+ *
+ *      BENCHMARK(group, name) { ... ctx.run(ops, body, batch); }
+ *
+ * 每个基准得到一个 BenchContext：
+ *      run(ops, body, batch)   调用 body(i) 共 ops 次，每 batch 次记一次耗时，batch 次的平均值作为一次延迟样本；
+ *                              微基准取较大的 batch 以摊薄计时开销，端到端的基准取 batch = 1；
+ *      record / finish         多线程或自己计时的基准手动记录延迟样本与总操作数。
+ * 计时区间内打开 cycles / instructions / cache-misses / branch-misses 四个计数器（含子线程），
+ * perf_event_open 不可用时这些字段输出为 null。
+ *
+ * 结果每个基准一行 JSON（JSON Lines），--compare 读取两次运行的结果，按吞吐量变化判断是否退化。
+ */
+
+struct BenchResult
+{
+    std::string name;
+    long ops = 0;
+    double seconds = 0;
+    double p50 = 0, p90 = 0, p99 = 0, p999 = 0; // 每次操作的纳秒数
+    bool countersValid = false;
+    uint64_t cycles = 0, instructions = 0, cacheMisses = 0, branchMisses = 0;
+
+    double opsPerSec() const { return seconds > 0 ? ops / seconds : 0; }
+
+    std::string json() const
+    {
+        std::ostringstream os;
+        os << std::setprecision(6) << "{\"name\":\"" << name << "\",\"ops\":" << ops << ",\"seconds\":" << seconds
+           << ",\"ops_per_sec\":" << opsPerSec() << ",\"p50_ns\":" << p50 << ",\"p90_ns\":" << p90
+           << ",\"p99_ns\":" << p99 << ",\"p999_ns\":" << p999;
+        for (auto &kv : counters())
+        {
+            os << ",\"" << kv.first << "\":";
+            if (countersValid)
+                os << kv.second;
+            else
+                os << "null";
+        }
+        os << "}";
+        return os.str();
+    }
+
+    // 只解析 json() 写出的格式：字段都是数字或 null，只有 name 是字符串
+    static bool parse(const std::string &line, BenchResult &r)
+    {
+        auto field = [&](const std::string &key) -> std::string
+        {
+            size_t pos = line.find("\"" + key + "\":");
+            if (pos == std::string::npos)
+                return "";
+            pos += key.size() + 3;
+            size_t end = line[pos] == '"' ? line.find('"', pos + 1) + 1 : line.find_first_of(",}", pos);
+            return line.substr(pos, end - pos);
+        };
+        std::string name = field("name");
+        if (name.size() < 2)
+            return false;
+        r.name = name.substr(1, name.size() - 2);
+        r.ops = std::stol(field("ops"));
+        r.seconds = std::stod(field("seconds"));
+        r.p50 = std::stod(field("p50_ns"));
+        r.p90 = std::stod(field("p90_ns"));
+        r.p99 = std::stod(field("p99_ns"));
+        r.p999 = std::stod(field("p999_ns"));
+        std::string cycles = field("cycles");
+        r.countersValid = !cycles.empty() && cycles != "null";
+        if (r.countersValid)
+        {
+            r.cycles = std::stoull(cycles);
+            r.instructions = std::stoull(field("instructions"));
+            r.cacheMisses = std::stoull(field("cache_misses"));
+            r.branchMisses = std::stoull(field("branch_misses"));
+        }
+        return true;
+    }
+
+    std::vector<std::pair<const char *, uint64_t>> counters() const
+    {
+        return {{"cycles", cycles}, {"instructions", instructions}, {"cache_misses", cacheMisses},
+                {"branch_misses", branchMisses}};
+    }
+};
+
+class BenchContext
+{
+public:
+    explicit BenchContext(const std::string &name, double scale) : scale(scale) { result.name = name; }
+
+    // 操作数按 --scale 缩放，便于快速冒烟或长时间稳定测量
+    long scaled(long ops) const { return std::max(1L, long(ops * scale)); }
+
+    template <typename Body>
+    void run(long ops, Body body, long batch = 64)
+    {
+        ops = scaled(ops);
+        batch = std::max(1L, std::min(batch, ops));
+        samples.reserve(ops / batch + 1);
+        begin();
+        for (long i = 0; i < ops;)
+        {
+            long n = std::min(batch, ops - i);
+            auto t0 = std::chrono::steady_clock::now();
+            for (long end = i + n; i < end; i++)
+                body(i);
+            record(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n);
+        }
+        finish(ops);
+    }
+
+    // 手动计时：begin() 与 finish() 之间为计时区间，期间用 record 记录每次操作的延迟
+    void begin()
+    {
+        for (PerfCounter &c : counters)
+            c.start();
+        start = std::chrono::steady_clock::now();
+    }
+    void record(double ns) { samples.push_back(ns); }
+    void finish(long ops)
+    {
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for (PerfCounter &c : counters)
+            c.stop();
+        result.ops = ops;
+        result.countersValid = counters[0].valid();
+        result.cycles = counters[0].value();
+        result.instructions = counters[1].value();
+        result.cacheMisses = counters[2].value();
+        result.branchMisses = counters[3].value();
+        // 没有记录延迟样本时，用平均值代替
+        if (samples.empty())
+            samples.push_back(result.seconds * 1e9 / std::max(1L, ops));
+        std::sort(samples.begin(), samples.end());
+        auto pct = [&](double p)
+        { return samples[size_t(p * (samples.size() - 1))]; };
+        result.p50 = pct(0.5);
+        result.p90 = pct(0.9);
+        result.p99 = pct(0.99);
+        result.p999 = pct(0.999);
+    }
+
+    const BenchResult &get() const { return result; }
+
+private:
+    double scale;
+    BenchResult result;
+    std::vector<double> samples;
+    std::chrono::steady_clock::time_point start;
+    PerfCounter counters[4] = {PerfCounter::cycles(true), PerfCounter::instructions(true),
+                               PerfCounter::cacheMisses(true), PerfCounter::branchMisses(true)};
+};
+
+class BenchRegistry
+{
+public:
+    typedef std::function<void(BenchContext &)> Fn;
+
+    static BenchRegistry &instance()
+    {
+        static BenchRegistry registry;
+        return registry;
+    }
+
+    bool add(const std::string &name, Fn fn)
+    {
+        benches.emplace_back(name, std::move(fn));
+        return true;
+    }
+
+    std::vector<std::string> names() const
+    {
+        std::vector<std::string> out;
+        for (auto &b : benches)
+            out.push_back(b.first);
+        return out;
+    }
+
+    // 名字中包含 filter 的基准依次运行，结果写到 out（若非空）
+    std::vector<BenchResult> runAll(const std::string &filter, double scale, std::ostream *out)
+    {
+        std::vector<BenchResult> results;
+        printHeader();
+        for (auto &b : benches)
+        {
+            if (b.first.find(filter) == std::string::npos)
+                continue;
+            BenchContext ctx(b.first, scale);
+            b.second(ctx);
+            results.push_back(ctx.get());
+            print(results.back());
+            if (out)
+                *out << results.back().json() << std::endl;
+        }
+        return results;
+    }
+
+    static std::vector<BenchResult> load(const std::string &path)
+    {
+        std::vector<BenchResult> results;
+        std::ifstream in(path);
+        std::string line;
+        BenchResult r;
+        while (std::getline(in, line))
+            if (BenchResult::parse(line, r))
+                results.push_back(r);
+        return results;
+    }
+
+    // 吞吐量下降超过 threshold（百分比）视为退化，返回退化的个数
+    static int compare(const std::vector<BenchResult> &base, const std::vector<BenchResult> &next, double threshold)
+    {
+        std::map<std::string, const BenchResult *> old;
+        for (auto &r : base)
+            old[r.name] = &r;
+        int regressions = 0;
+        std::cout << std::left << std::setw(32) << "benchmark" << std::right << std::setw(14) << "base ops/s"
+                  << std::setw(14) << "new ops/s" << std::setw(10) << "change" << std::setw(12) << "p99 change"
+                  << std::endl;
+        for (auto &r : next)
+        {
+            auto it = old.find(r.name);
+            if (it == old.end())
+            {
+                std::cout << std::left << std::setw(32) << r.name << std::right << "  (new)" << std::endl;
+                continue;
+            }
+            const BenchResult &b = *it->second;
+            double change = (r.opsPerSec() / b.opsPerSec() - 1) * 100;
+            double p99 = b.p99 > 0 ? (r.p99 / b.p99 - 1) * 100 : 0;
+            bool regressed = change < -threshold;
+            regressions += regressed;
+            std::cout << std::left << std::setw(32) << r.name << std::right << std::fixed << std::setprecision(0)
+                      << std::setw(14) << b.opsPerSec() << std::setw(14) << r.opsPerSec() << std::setprecision(1)
+                      << std::setw(9) << std::showpos << change << "%" << std::setw(11) << p99 << "%"
+                      << std::noshowpos << std::defaultfloat << std::setprecision(6)
+                      << (regressed ? "  REGRESSION" : "") << std::endl;
+        }
+        return regressions;
+    }
+
+private:
+    static void printHeader()
+    {
+        std::cout << std::left << std::setw(32) << "benchmark" << std::right << std::setw(14) << "ops/s"
+                  << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns" << std::setw(10) << "p99.9 ns"
+                  << std::setw(8) << "IPC" << std::setw(12) << "llc-miss/op" << std::setw(12) << "br-miss/op"
+                  << std::endl;
+    }
+
+    static void print(const BenchResult &r)
+    {
+        std::cout << std::left << std::setw(32) << r.name << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(14) << r.opsPerSec() << std::setprecision(1) << std::setw(10) << r.p50 << std::setw(10)
+                  << r.p99 << std::setw(10) << r.p999;
+        if (r.countersValid && r.cycles)
+            std::cout << std::setprecision(2) << std::setw(8) << double(r.instructions) / r.cycles
+                      << std::setprecision(3) << std::setw(12) << double(r.cacheMisses) / r.ops << std::setw(12)
+                      << double(r.branchMisses) / r.ops;
+        else
+            std::cout << std::setw(8) << "n/a" << std::setw(12) << "n/a" << std::setw(12) << "n/a";
+        std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+    }
+
+    std::vector<std::pair<std::string, Fn>> benches;
+};
+
+#define BENCHMARK(group, name)                                                                       \
+    static void bench_##group##_##name(BenchContext &ctx);                                           \
+    static bool bench_registered_##group##_##name =                                                  \
+        BenchRegistry::instance().add(#group "/" #name, bench_##group##_##name);                     \
+    static void bench_##group##_##name(BenchContext &ctx)
+
+// 防止被测的计算被优化掉
+template <typename T>
+inline void do_not_optimize(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
@@ -0,0 +1,163 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cache_node.h"
+using namespace std;
+
+// 本机 UDP 缓存节点的压测：每个数据报一个操作与批量打包多个操作时的吞吐量和延迟，不依赖任何外部服务
+// 编译：g++ -std=c++17 -O2 -pthread cache_node.cc -o cache_node
+
+static const size_t KEYS = 200000;
+static const size_t CAPACITY = 100000; // 所有分片合计，约一半的 key 放得下
+static const size_t VALUE_BYTES = 64;
+static const int CLIENTS = 2;
+static const size_t OPS_PER_CLIENT = 200000;
+static const double SET_RATIO = 0.1;
+
+static string keyOf(size_t k) { return "key:" + to_string(k); }
+
+struct Result
+{
+    double opsPerSec;
+    double p50, p99, p999; // 每次请求（一个批次）的往返时间，微秒
+    double hitRate;
+    double datagramsPerWakeup;
+};
+
+// 每个客户端线程独立地发 OPS_PER_CLIENT 个操作，每 batch 个打成一次 execute；长尾分布 key = KEYS * u^3
+static Result run(CacheNode &node, size_t batch)
+{
+    CacheNode::Stats before = node.stats();
+    vector<vector<float>> latencies(CLIENTS);
+    vector<long> hits(CLIENTS), gets(CLIENTS);
+    auto start = chrono::steady_clock::now();
+    vector<thread> clients;
+    for (int c = 0; c < CLIENTS; c++)
+        clients.emplace_back([&, c]()
+                             {
+            CacheClient client(node.ports());
+            mt19937_64 rng(c + 1);
+            uniform_real_distribution<double> u(0, 1);
+            string value(VALUE_BYTES, char('a' + c));
+            vector<CacheClient::Op> ops(batch);
+            vector<CacheClient::Result> results;
+            latencies[c].reserve(OPS_PER_CLIENT / batch + 1);
+            for (size_t done = 0; done < OPS_PER_CLIENT; done += batch)
+            {
+                for (auto &op : ops)
+                {
+                    op.key = keyOf(size_t(KEYS * pow(u(rng), 3)));
+                    bool write = u(rng) < SET_RATIO;
+                    op.op = write ? cache_proto::SET : cache_proto::GET;
+                    op.value = write ? value : string();
+                }
+                auto t0 = chrono::steady_clock::now();
+                client.execute(ops, results);
+                latencies[c].push_back(chrono::duration<float, micro>(chrono::steady_clock::now() - t0).count());
+                for (size_t i = 0; i < batch; i++)
+                    if (ops[i].op == cache_proto::GET)
+                    {
+                        gets[c]++;
+                        hits[c] += results[i].status == cache_proto::OK;
+                    }
+            } });
+    for (auto &t : clients)
+        t.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    CacheNode::Stats after = node.stats();
+
+    vector<float> all;
+    long h = 0, g = 0;
+    for (int c = 0; c < CLIENTS; c++)
+    {
+        all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+        h += hits[c];
+        g += gets[c];
+    }
+    sort(all.begin(), all.end());
+    auto pct = [&](double p)
+    { return all[size_t(p * (all.size() - 1))]; };
+    Result r;
+    r.opsPerSec = CLIENTS * OPS_PER_CLIENT / seconds;
+    r.p50 = pct(0.5);
+    r.p99 = pct(0.99);
+    r.p999 = pct(0.999);
+    r.hitRate = double(h) / max(1l, g);
+    r.datagramsPerWakeup = double(after.datagrams - before.datagrams) / max<uint64_t>(1, after.wakeups - before.wakeups);
+    return r;
+}
+
+int main()
+{
+    size_t shards = min(4u, max(2u, thread::hardware_concurrency()));
+    CacheNode node(shards, CAPACITY / shards);
+    cout << shards << " shards on ports";
+    for (uint16_t p : node.ports())
+        cout << " " << p;
+    cout << ", " << CLIENTS << " client threads, " << KEYS << " keys, capacity " << CAPACITY << ", "
+         << SET_RATIO * 100 << "% SET" << endl;
+
+    // 预热：批量写入所有 key，较冷的一半随后会被淘汰
+    {
+        CacheClient client(node.ports());
+        vector<CacheClient::Op> ops;
+        vector<CacheClient::Result> results;
+        string value(VALUE_BYTES, 'w');
+        for (size_t k = KEYS; k-- > 0;)
+        {
+            ops.push_back({cache_proto::SET, keyOf(k), value});
+            if (ops.size() == 256 || k == 0)
+            {
+                client.execute(ops, results);
+                ops.clear();
+            }
+        }
+    }
+
+    cout << setw(8) << "batch" << setw(12) << "ops/s" << setw(12) << "p50 us" << setw(12) << "p99 us" << setw(12)
+         << "p99.9 us" << setw(10) << "hit rate" << setw(14) << "dgrams/recv" << endl;
+    for (size_t batch : {1, 4, 16, 64})
+    {
+        Result r = run(node, batch);
+        cout << setw(8) << batch << fixed << setprecision(0) << setw(12) << r.opsPerSec << setprecision(1) << setw(12)
+             << r.p50 << setw(12) << r.p99 << setw(12) << r.p999 << setprecision(3) << setw(10) << r.hitRate
+             << setprecision(2) << setw(14) << r.datagramsPerWakeup << defaultfloat << endl;
+    }
+
+    // 协议的边界情况
+    CacheClient client(node.ports());
+    string v;
+    client.set("hello", "world");
+    bool found = client.get("hello", v);
+    bool deleted = client.del("hello");
+    bool again = client.get("hello", v);
+    cout << endl
+         << "get after set: " << (found ? v : "<miss>") << ", del: " << deleted << ", get after del: " << again
+         << endl;
+
+    // 最长的 key 配最长的 value 仍能一个数据报往返；再长一个字节在发送前就被拒绝
+    string longKey(cache_proto::MAX_KEY, 'k'), big(cache_proto::MAX_VALUE, 'v');
+    client.set(longKey, big);
+    bool bigOk = client.get(longKey, v) && v == big;
+    bool rejected = false;
+    try
+    {
+        client.set("hello", big + "v");
+    }
+    catch (const invalid_argument &)
+    {
+        rejected = true;
+    }
+    cout << "max value " << cache_proto::MAX_VALUE << " bytes round trip: " << (bigOk ? "yes" : "NO")
+         << ", one byte more rejected: " << (rejected ? "yes" : "NO") << endl;
+
+    CacheNode::Stats s = node.stats();
+    cout << "node: " << s.ops << " ops in " << s.datagrams << " datagrams, " << s.wakeups << " recvmmsg calls" << endl;
+    return 0;
+}
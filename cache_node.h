@@ -0,0 +1,542 @@
+#pragma once
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "lru_cache.h"
+
+/** 以 UDP 提供服务的本机缓存节点，用法与压测见 cache_node.cc
+ *
+ * 分片：每个分片一个 LRU_Cache、一个 UDP 套接字（端口 basePort + i）、一个绑定到 CPU i 的 I/O 线程，
+ * 分片只被自己的线程访问，LRU_Cache 用 null_mutex，请求路径上没有锁。
+ * key 属于哪个分片由客户端按 shard_of(key) 计算（与 memcached 客户端一样在客户端分片），发错分片的操作返回 WRONG_SHARD。
+ * I/O 线程用 recvmmsg 一次收最多 RECV_BATCH 个数据报，逐个处理后用 sendmmsg 一次发回。
+ *
+ * 协议：主机字节序、只用于本机，一个数据报（不超过 MAX_DATAGRAM 字节）装任意多个操作
+ *      请求    u32 id, u32 count, count 个操作：
+ *                  u8 op (GET / SET / DEL), u8 keyLen, u16 valueLen（只有 SET 非 0）, key 字节, value 字节
+ *      回复    u32 id, u32 count, count 个结果，与请求中的操作一一对应：
+ *                  u8 status，GET 成功时后跟 u16 valueLen 与 value 字节
+ * 回复中放不下的 GET 结果返回 TOO_BIG；请求格式错误时从出错的操作开始截断，count 为已处理的个数加一，最后一个为 BAD_REQUEST。
+ */
+namespace cache_proto
+{
+    enum Op : uint8_t
+    {
+        GET = 1,
+        SET = 2,
+        DEL = 3,
+    };
+
+    enum Status : uint8_t
+    {
+        OK = 0,
+        NOT_FOUND = 1,
+        WRONG_SHARD = 2,
+        TOO_BIG = 3,
+        BAD_REQUEST = 4,
+    };
+
+    constexpr size_t MAX_DATAGRAM = 65507; // IPv4 UDP 的最大载荷
+    constexpr size_t HEADER = 8;
+    constexpr size_t OP_HEADER = 4;
+    constexpr size_t MAX_KEY = 255;
+    // 任意 key 的 SET 单独一个数据报时放得下；GET 的回复（状态、u16 长度、value）也就放得下
+    constexpr size_t MAX_VALUE = MAX_DATAGRAM - HEADER - OP_HEADER - MAX_KEY;
+    static_assert(HEADER + 3 + MAX_VALUE <= MAX_DATAGRAM && MAX_VALUE <= UINT16_MAX, "value must fit in one datagram");
+
+    inline size_t shard_of(const std::string &key, size_t shards) { return std::hash<std::string>()(key) % shards; }
+
+    inline size_t encoded_size(const std::string &key, const std::string &value) { return OP_HEADER + key.size() + value.size(); }
+
+    inline void put_header(char *p, uint32_t id, uint32_t count)
+    {
+        std::memcpy(p, &id, 4);
+        std::memcpy(p + 4, &count, 4);
+    }
+
+    // 追加一个操作，调用方保证 key / value 不超过上限
+    inline void append_op(std::string &out, Op op, const std::string &key, const std::string &value)
+    {
+        char h[OP_HEADER];
+        uint16_t valueLen = uint16_t(value.size());
+        h[0] = char(op);
+        h[1] = char(uint8_t(key.size()));
+        std::memcpy(h + 2, &valueLen, 2);
+        out.append(h, OP_HEADER);
+        out += key;
+        out += value;
+    }
+}
+
+#pragma region CacheNode
+class CacheNode
+{
+public:
+    typedef LRU_Cache<std::string, std::string, std::shared_ptr<std::string>, null_mutex> Cache;
+
+    static constexpr int RECV_BATCH = 32;
+
+    struct Stats
+    {
+        uint64_t datagrams = 0, ops = 0, hits = 0, misses = 0;
+        uint64_t wakeups = 0; // recvmmsg 返回的次数，datagrams / wakeups 为每次系统调用处理的数据报数
+    };
+
+    // basePort 为 0 时每个分片绑定一个临时端口，用 ports() 取得
+    CacheNode(size_t shards, size_t capacityPerShard, uint16_t basePort = 0) : shardCount(shards)
+    {
+        if (shards == 0)
+            throw std::invalid_argument("CacheNode: no shards");
+        unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < shards; i++)
+        {
+            std::unique_ptr<Shard> s(new Shard(capacityPerShard));
+            s->index = i;
+            s->fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(basePort ? uint16_t(basePort + i) : 0);
+            socklen_t len = sizeof(addr);
+            if (s->fd < 0 || bind(s->fd, (sockaddr *)&addr, sizeof(addr)) < 0 || getsockname(s->fd, (sockaddr *)&addr, &len) < 0)
+            {
+                if (s->fd >= 0)
+                    close(s->fd);
+                stopAll();
+                throw std::runtime_error("CacheNode: cannot bind shard " + std::to_string(i));
+            }
+            int buf = 4 << 20;
+            setsockopt(s->fd, SOL_SOCKET, SO_RCVBUF, &buf, sizeof(buf));
+            setsockopt(s->fd, SOL_SOCKET, SO_SNDBUF, &buf, sizeof(buf));
+            _ports.push_back(ntohs(addr.sin_port));
+            Shard *raw = s.get();
+            s->thread = std::thread([this, raw, cpu = i % cpus]()
+                                    { serve(*raw, cpu); });
+            _shards.push_back(std::move(s));
+        }
+    }
+
+    ~CacheNode() { stopAll(); }
+
+    const std::vector<uint16_t> &ports() const { return _ports; }
+    size_t shards() const { return shardCount; }
+
+    // 各分片的计数之和，分片线程用 relaxed 原子量写，读到的是近似值
+    Stats stats() const
+    {
+        Stats s;
+        for (auto &shard : _shards)
+        {
+            s.datagrams += shard->datagrams.load(std::memory_order_relaxed);
+            s.ops += shard->ops.load(std::memory_order_relaxed);
+            s.hits += shard->hits.load(std::memory_order_relaxed);
+            s.misses += shard->misses.load(std::memory_order_relaxed);
+            s.wakeups += shard->wakeups.load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+
+private:
+    struct Shard
+    {
+        explicit Shard(size_t capacity) : cache(int(capacity)) {}
+        size_t index = 0;
+        int fd = -1;
+        Cache cache;
+        std::thread thread;
+        std::atomic<uint64_t> datagrams{0}, ops{0}, hits{0}, misses{0}, wakeups{0};
+        std::atomic<bool> exited{false};
+    };
+
+    void serve(Shard &s, unsigned cpu)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+        std::vector<char> in(RECV_BATCH * cache_proto::MAX_DATAGRAM), out(RECV_BATCH * cache_proto::MAX_DATAGRAM);
+        mmsghdr requests[RECV_BATCH], replies[RECV_BATCH];
+        iovec inVec[RECV_BATCH], outVec[RECV_BATCH];
+        sockaddr_in peers[RECV_BATCH];
+        uint64_t hits = 0, misses = 0, ops = 0;
+        while (!stopping.load(std::memory_order_acquire))
+        {
+            for (int i = 0; i < RECV_BATCH; i++)
+            {
+                inVec[i] = {&in[i * cache_proto::MAX_DATAGRAM], cache_proto::MAX_DATAGRAM};
+                std::memset(&requests[i].msg_hdr, 0, sizeof(msghdr));
+                requests[i].msg_hdr.msg_iov = &inVec[i];
+                requests[i].msg_hdr.msg_iovlen = 1;
+                requests[i].msg_hdr.msg_name = &peers[i];
+                requests[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            }
+            // 阻塞到至少一个数据报，然后把已经到达的都取走
+            int n = recvmmsg(s.fd, requests, RECV_BATCH, MSG_WAITFORONE, nullptr);
+            if (n <= 0)
+                continue;
+            int m = 0;
+            for (int i = 0; i < n; i++)
+            {
+                char *reply = &out[m * cache_proto::MAX_DATAGRAM];
+                size_t len = handle(s, &in[i * cache_proto::MAX_DATAGRAM], requests[i].msg_len, reply, hits, misses, ops);
+                if (!len)
+                    continue;
+                outVec[m] = {reply, len};
+                std::memset(&replies[m].msg_hdr, 0, sizeof(msghdr));
+                replies[m].msg_hdr.msg_iov = &outVec[m];
+                replies[m].msg_hdr.msg_iovlen = 1;
+                replies[m].msg_hdr.msg_name = &peers[i];
+                replies[m].msg_hdr.msg_namelen = requests[i].msg_hdr.msg_namelen;
+                m++;
+            }
+            for (int sent = 0; sent < m;)
+            {
+                int r = sendmmsg(s.fd, replies + sent, m - sent, 0);
+                if (r <= 0)
+                    break; // 对端已关闭等，UDP 丢了就丢了，由客户端超时重发
+                sent += r;
+            }
+            s.wakeups.fetch_add(1, std::memory_order_relaxed);
+            s.datagrams.fetch_add(n, std::memory_order_relaxed);
+            s.ops.store(ops, std::memory_order_relaxed);
+            s.hits.store(hits, std::memory_order_relaxed);
+            s.misses.store(misses, std::memory_order_relaxed);
+        }
+        s.exited.store(true, std::memory_order_release);
+    }
+
+    // 处理一个请求数据报，返回回复的长度，0 表示不回复（连头部都不完整）
+    size_t handle(Shard &s, const char *p, size_t len, char *out, uint64_t &hits, uint64_t &misses, uint64_t &ops)
+    {
+        using namespace cache_proto;
+        if (len < HEADER)
+            return 0;
+        uint32_t id, count;
+        std::memcpy(&id, p, 4);
+        std::memcpy(&count, p + 4, 4);
+        size_t in = HEADER, o = HEADER;
+        uint32_t done = 0;
+        std::string key;
+        for (; done < count; done++)
+        {
+            if (o + 1 > MAX_DATAGRAM)
+                break;
+            if (in + OP_HEADER > len)
+            {
+                out[o++] = BAD_REQUEST;
+                done++;
+                break;
+            }
+            uint8_t op = uint8_t(p[in]), keyLen = uint8_t(p[in + 1]);
+            uint16_t valueLen;
+            std::memcpy(&valueLen, p + in + 2, 2);
+            if (in + OP_HEADER + keyLen + valueLen > len || op < GET || op > DEL)
+            {
+                out[o++] = BAD_REQUEST;
+                done++;
+                break;
+            }
+            key.assign(p + in + OP_HEADER, keyLen);
+            const char *value = p + in + OP_HEADER + keyLen;
+            in += OP_HEADER + keyLen + valueLen;
+            ops++;
+            if (shard_of(key, shardCount) != s.index)
+            {
+                out[o++] = WRONG_SHARD;
+                continue;
+            }
+            if (op == SET)
+            {
+                s.cache.put(key, std::make_shared<std::string>(value, valueLen));
+                out[o++] = OK;
+            }
+            else if (op == DEL)
+                out[o++] = s.cache.erase(key) ? OK : NOT_FOUND;
+            else if (auto v = s.cache.get(key))
+            {
+                hits++;
+                if (o + 3 + v->size() > MAX_DATAGRAM)
+                {
+                    out[o++] = TOO_BIG;
+                    continue;
+                }
+                uint16_t n = uint16_t(v->size());
+                out[o++] = OK;
+                std::memcpy(out + o, &n, 2);
+                std::memcpy(out + o + 2, v->data(), n);
+                o += 2 + n;
+            }
+            else
+            {
+                misses++;
+                out[o++] = NOT_FOUND;
+            }
+        }
+        put_header(out, id, done);
+        return o;
+    }
+
+    // 置停止标志后给每个分片发一个空数据报，把阻塞在 recvmmsg 上的线程唤醒
+    void stopAll()
+    {
+        stopping.store(true, std::memory_order_release);
+        int waker = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        for (size_t i = 0; i < _shards.size(); i++)
+        {
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(_ports[i]);
+            // 唤醒包可能因接收缓冲区满被丢弃，线程退出前重复发送
+            for (int spin = 0; !_shards[i]->exited.load(std::memory_order_acquire); spin++)
+            {
+                if (spin % 100 == 0)
+                    sendto(waker, "", 0, 0, (sockaddr *)&addr, sizeof(addr));
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            _shards[i]->thread.join();
+            close(_shards[i]->fd);
+        }
+        if (waker >= 0)
+            close(waker);
+        _shards.clear();
+    }
+
+    size_t shardCount;
+    std::atomic<bool> stopping{false};
+    std::vector<std::unique_ptr<Shard>> _shards;
+    std::vector<uint16_t> _ports;
+};
+#pragma endregion
+
+#pragma region CacheClient
+/**
+ * 客户端：一个未连接的 UDP 套接字，按 shard_of 把每个操作发往所属分片的端口，回复按 id 匹配。
+ *      get / set / del     单个操作，一个数据报一次往返
+ *      execute             批量：按分片分组，每组按 MAX_DATAGRAM 打包成一个或几个数据报，全部发出后再收齐回复
+ * key 超过 MAX_KEY 或 value 超过 MAX_VALUE 时在发送前抛出 invalid_argument；sendto 失败抛出 runtime_error。
+ * 超时（timeoutMs）未收到回复的数据报整体重发，重发 retries 次仍没有回复抛出 runtime_error。
+ * 重发可能使 SET / DEL 执行两次：SET 幂等，DEL 第二次返回 NOT_FOUND。不是线程安全的，每个线程一个客户端。
+ */
+class CacheClient
+{
+public:
+    struct Op
+    {
+        cache_proto::Op op;
+        std::string key, value;
+    };
+
+    struct Result
+    {
+        cache_proto::Status status;
+        std::string value;
+    };
+
+    CacheClient(const std::vector<uint16_t> &ports, int timeoutMs = 200, int retries = 5) : retries(retries)
+    {
+        if (ports.empty())
+            throw std::invalid_argument("CacheClient: no shards");
+        fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            throw std::runtime_error("CacheClient: socket failed");
+        timeval timeout{timeoutMs / 1000, timeoutMs % 1000 * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        for (uint16_t port : ports)
+        {
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(port);
+            shards.push_back(addr);
+        }
+        buffer.resize(cache_proto::MAX_DATAGRAM);
+    }
+
+    ~CacheClient() { close(fd); }
+
+    CacheClient(const CacheClient &) = delete;
+    CacheClient &operator=(const CacheClient &) = delete;
+
+    bool get(const std::string &key, std::string &value)
+    {
+        single(cache_proto::GET, key, std::string());
+        if (one[0].status != cache_proto::OK)
+            return false;
+        value.swap(one[0].value);
+        return true;
+    }
+
+    void set(const std::string &key, const std::string &value) { single(cache_proto::SET, key, value); }
+
+    bool del(const std::string &key) { return single(cache_proto::DEL, key, std::string()) == cache_proto::OK; }
+
+    // results[i] 对应 ops[i]
+    void execute(const std::vector<Op> &ops, std::vector<Result> &results)
+    {
+        using namespace cache_proto;
+        for (const Op &op : ops)
+            if (op.key.size() > MAX_KEY || op.value.size() > MAX_VALUE)
+                throw std::invalid_argument("CacheClient: key or value too long");
+        results.resize(ops.size());
+        groups.resize(shards.size());
+        for (auto &g : groups)
+            g.clear();
+        for (size_t i = 0; i < ops.size(); i++)
+            groups[shard_of(ops[i].key, shards.size())].push_back(i);
+
+        uint32_t firstId = nextId;
+        used = 0;
+        for (size_t s = 0; s < groups.size(); s++)
+        {
+            Request *r = nullptr;
+            for (size_t i : groups[s])
+            {
+                size_t size = encoded_size(ops[i].key, ops[i].value);
+                if (!r || r->datagram.size() + size > MAX_DATAGRAM)
+                    r = &start(s, nextId++);
+                append_op(r->datagram, ops[i].op, ops[i].key, ops[i].value);
+                r->index.push_back(i);
+            }
+        }
+        for (size_t j = 0; j < used; j++)
+            send(pending[j]);
+
+        size_t left = used;
+        for (int attempt = 0; left;)
+        {
+            ssize_t n = recv(fd, &buffer[0], buffer.size(), 0);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if ((errno != EAGAIN && errno != EWOULDBLOCK) || ++attempt > retries)
+                    throw std::runtime_error("CacheClient: no reply from cache node");
+                for (size_t j = 0; j < used; j++)
+                    if (!pending[j].done)
+                        send(pending[j]);
+                continue;
+            }
+            uint32_t id, count;
+            if (size_t(n) < HEADER)
+                continue;
+            std::memcpy(&id, &buffer[0], 4);
+            std::memcpy(&count, &buffer[4], 4);
+            // 之前某次调用超时后迟到的回复，id 不在本次范围内
+            if (id - firstId >= used || pending[id - firstId].done)
+                continue;
+            Request &r = pending[id - firstId];
+            if (!parse(r, ops, results, size_t(n), count))
+                continue;
+            r.done = true;
+            left--;
+        }
+    }
+
+private:
+    struct Request
+    {
+        size_t shard;
+        uint32_t id;
+        std::vector<size_t> index; // 每个操作在 ops 中的下标
+        std::string datagram;
+        bool done;
+    };
+
+    cache_proto::Status single(cache_proto::Op op, const std::string &key, const std::string &value)
+    {
+        if (ones.empty())
+            ones.resize(1);
+        ones[0].op = op;
+        ones[0].key = key;
+        ones[0].value = value;
+        execute(ones, one);
+        return one[0].status;
+    }
+
+    Request &start(size_t shard, uint32_t id)
+    {
+        if (used == pending.size())
+            pending.emplace_back();
+        Request &r = pending[used++];
+        r.shard = shard;
+        r.index.clear();
+        r.datagram.assign(cache_proto::HEADER, '\0');
+        r.done = false;
+        r.id = id;
+        return r;
+    }
+
+    void send(Request &r)
+    {
+        cache_proto::put_header(&r.datagram[0], r.id, uint32_t(r.index.size()));
+        ssize_t n;
+        do
+            n = sendto(fd, r.datagram.data(), r.datagram.size(), 0, (sockaddr *)&shards[r.shard], sizeof(sockaddr_in));
+        while (n < 0 && errno == EINTR);
+        if (n != ssize_t(r.datagram.size()))
+            throw std::runtime_error(std::string("CacheClient: sendto failed: ") + std::strerror(errno));
+    }
+
+    // 回复不完整（格式错误）返回 false，当作没收到
+    bool parse(const Request &r, const std::vector<Op> &ops, std::vector<Result> &results, size_t n, uint32_t count)
+    {
+        using namespace cache_proto;
+        if (count > r.index.size())
+            return false;
+        size_t p = HEADER;
+        for (uint32_t k = 0; k < count; k++)
+        {
+            if (p + 1 > n)
+                return false;
+            Result &res = results[r.index[k]];
+            res.status = Status(buffer[p++]);
+            res.value.clear();
+            if (ops[r.index[k]].op == GET && res.status == OK)
+            {
+                uint16_t len;
+                if (p + 2 > n)
+                    return false;
+                std::memcpy(&len, &buffer[p], 2);
+                if (p + 2 + len > n)
+                    return false;
+                res.value.assign(&buffer[p + 2], len);
+                p += 2 + len;
+            }
+        }
+        // 服务端因格式错误截断时，其余的操作没有执行
+        for (size_t k = count; k < r.index.size(); k++)
+            results[r.index[k]].status = BAD_REQUEST;
+        return true;
+    }
+
+    int fd;
+    int retries;
+    std::vector<sockaddr_in> shards;
+    uint32_t nextId = 1;
+    std::vector<std::vector<size_t>> groups;
+    std::vector<Request> pending; // 前 used 个是本次 execute 的请求，id 依次为 firstId, firstId + 1, ...
+    size_t used = 0;
+    std::vector<char> buffer;
+    std::vector<Op> ones;
+    std::vector<Result> one;
+};
+#pragma endregion
@@ -0,0 +1,109 @@
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "concurrent_ptr.h"
+using namespace std;
+
+// 对比 std::shared_ptr 与 concurrent_ptr.h 中几种指针在多线程下的拷贝/读取开销
+// 编译：g++ -std=c++17 -O2 -pthread concurrent_ptr.cc -o concurrent_ptr
+
+struct Config
+{
+    long version;
+    long payload[7];
+    Config(long v) : version(v), payload{} {}
+};
+
+// 各线程的结果最后汇总到这里，防止读取被编译器优化掉；每个线程只写一次，不影响测量
+static atomic<long> sink(0);
+
+// threads 个线程各自执行 iters 次 body(i)，返回每次操作的平均纳秒数；body 的返回值累加在线程内
+template <typename Body>
+double perOp(int threads, long iters, Body body)
+{
+    vector<thread> workers;
+    auto begin = chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++)
+        workers.emplace_back([&]()
+                             {
+            long local = 0;
+            for (long i = 0; i < iters; i++)
+                local += body(i);
+            sink += local; });
+    for (auto &w : workers)
+        w.join();
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count();
+    return ns / iters;
+}
+
+int main(int argc, char const *argv[])
+{
+    const long iters = 2000000;
+    int maxThreads = max(4u, thread::hardware_concurrency());
+
+    // 单线程拷贝：local_shared_ptr 没有原子操作
+    {
+        auto sp = make_shared<Config>(1);
+        auto lp = make_local_shared<Config>(1);
+        auto cp = make_counted<Config>(1);
+        cout << "copy+destroy, 1 thread (ns/op)" << endl;
+        cout << "  std::shared_ptr:  " << perOp(1, iters, [&](long)
+                                                   { shared_ptr<Config> c(sp); return c->version; })
+             << endl;
+        cout << "  counted_ptr:      " << perOp(1, iters, [&](long)
+                                                   { counted_ptr<Config> c(cp); return c->version; })
+             << endl;
+        cout << "  local_shared_ptr: " << perOp(1, iters, [&](long)
+                                                   { local_shared_ptr<Config> c(lp); return c->version; })
+             << endl;
+    }
+
+    // 多线程读取一个偶尔被替换的共享配置，每 1024 次读有一次写
+    cout << "load shared config with 1/1024 writes (ns/op per thread)" << endl;
+    cout << "threads\tatomic_load(shared_ptr)\tatomic_counted_ptr\trcu_ptr" << endl;
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        shared_ptr<Config> sp = make_shared<Config>(0);
+        atomic_counted_ptr<Config> acp(make_counted<Config>(0));
+        rcu_ptr<Config> rp(new Config(0));
+
+        double a = perOp(threads, iters, [&](long i)
+                         {
+            if ((i & 1023) == 0)
+            {
+                atomic_store(&sp, make_shared<Config>(i));
+                return 0L;
+            }
+            return atomic_load(&sp)->version; });
+        double b = perOp(threads, iters, [&](long i)
+                         {
+            if ((i & 1023) == 0)
+            {
+                acp.store(make_counted<Config>(i));
+                return 0L;
+            }
+            return acp.load()->version; });
+        double c = perOp(threads, iters, [&](long i)
+                         {
+            if ((i & 1023) == 0)
+            {
+                rp.store(new Config(i));
+                return 0L;
+            }
+            return rp.read()->version; });
+        cout << threads << "\t" << a << "\t\t\t" << b << "\t\t\t" << c << endl;
+    }
+
+    // 正确性：交换出去的对象只有在最后一个持有者释放后才析构
+    {
+        atomic_counted_ptr<Config> acp(make_counted<Config>(1));
+        counted_ptr<Config> held = acp.load();
+        counted_ptr<Config> expected = held;
+        bool swapped = acp.compare_exchange_strong(expected, make_counted<Config>(2));
+        cout << "cas " << (swapped ? "ok" : "failed") << ", old use_count " << held.use_count()
+             << ", new version " << acp.load()->version << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,393 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+// 面向并发场景的几种引用计数指针，用法与测试见 concurrent_ptr.cc
+//
+//      local_shared_ptr<T>    非原子引用计数，只能在单个线程内使用，拷贝没有任何原子操作
+//      counted_ptr<T>         原子引用计数，相当于 shared_ptr，但对象与计数一次分配
+//      atomic_counted_ptr<T>  counted_ptr 的无锁原子容器，相当于 atomic<shared_ptr<T>>
+//      rcu_ptr<T>             读多写少的数据，读者只写一次本线程的 epoch 槽位，旧对象延迟回收
+
+#pragma region local_shared_ptr
+/**
+ * shared_ptr 的每次拷贝/析构都是一次 lock 前缀的原子 RMW，即使对象从来不跨线程。
+ * local_shared_ptr 把计数改成普通整数，对象与计数放在同一个块中，适合线程私有的数据。
+ */
+template <typename T>
+class local_shared_ptr
+{
+public:
+    local_shared_ptr() : block(nullptr) {}
+    local_shared_ptr(const local_shared_ptr &other) : block(other.block)
+    {
+        if (block)
+            block->refs++;
+    }
+    local_shared_ptr(local_shared_ptr &&other) noexcept : block(other.block) { other.block = nullptr; }
+    local_shared_ptr &operator=(local_shared_ptr other) noexcept
+    {
+        std::swap(block, other.block);
+        return *this;
+    }
+    ~local_shared_ptr()
+    {
+        if (block && --block->refs == 0)
+            delete block;
+    }
+
+    T *get() const { return block ? &block->value : nullptr; }
+    T &operator*() const { return block->value; }
+    T *operator->() const { return &block->value; }
+    explicit operator bool() const { return block != nullptr; }
+    long use_count() const { return block ? block->refs : 0; }
+
+    template <typename U, typename... Args>
+    friend local_shared_ptr<U> make_local_shared(Args &&...args);
+
+private:
+    struct Block
+    {
+        long refs;
+        T value;
+        template <typename... Args>
+        Block(Args &&...args) : refs(1), value(std::forward<Args>(args)...) {}
+    };
+    explicit local_shared_ptr(Block *b) : block(b) {}
+    Block *block;
+};
+
+template <typename T, typename... Args>
+local_shared_ptr<T> make_local_shared(Args &&...args)
+{
+    return local_shared_ptr<T>(new typename local_shared_ptr<T>::Block(std::forward<Args>(args)...));
+}
+#pragma endregion
+
+#pragma region counted_ptr / atomic_counted_ptr
+template <typename T>
+class atomic_counted_ptr;
+
+template <typename T>
+class counted_ptr
+{
+public:
+    counted_ptr() : block(nullptr) {}
+    counted_ptr(const counted_ptr &other) : block(other.block)
+    {
+        if (block)
+            block->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    counted_ptr(counted_ptr &&other) noexcept : block(other.block) { other.block = nullptr; }
+    counted_ptr &operator=(counted_ptr other) noexcept
+    {
+        std::swap(block, other.block);
+        return *this;
+    }
+    ~counted_ptr() { release(block, 1); }
+
+    T *get() const { return block ? &block->value : nullptr; }
+    T &operator*() const { return block->value; }
+    T *operator->() const { return &block->value; }
+    explicit operator bool() const { return block != nullptr; }
+    long use_count() const { return block ? block->refs.load(std::memory_order_relaxed) : 0; }
+
+    template <typename U, typename... Args>
+    friend counted_ptr<U> make_counted(Args &&...args);
+    friend class atomic_counted_ptr<T>;
+
+private:
+    struct Block
+    {
+        std::atomic<long> refs;
+        T value;
+        template <typename... Args>
+        Block(Args &&...args) : refs(1), value(std::forward<Args>(args)...) {}
+    };
+    explicit counted_ptr(Block *b) : block(b) {}
+
+    static void release(Block *b, long n)
+    {
+        // 与 shared_ptr 一样：释放用 release，最后一个持有者用 acquire 看到所有写入后再析构
+        if (b && b->refs.fetch_sub(n, std::memory_order_release) == n)
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            delete b;
+        }
+    }
+
+    Block *block;
+};
+
+template <typename T, typename... Args>
+counted_ptr<T> make_counted(Args &&...args)
+{
+    return counted_ptr<T>(new typename counted_ptr<T>::Block(std::forward<Args>(args)...));
+}
+
+/** 无锁的 atomic<shared_ptr>
+ *
+ * libstdc++ 的 atomic_load(shared_ptr*) 是用一组全局自旋锁实现的，读者之间也会互相阻塞。
+ * 难点在于：读者拿到块指针与给块的计数加一是两步，中间块可能被写者释放。
+ *
+ * 这里使用“分离引用计数”：把块指针（低 48 位）和一个本地计数（高 16 位）打包到一个 64 位字中，
+ *      load：    先对整个字 fetch_add 一个本地计数，相当于给当前块“钉”住一次，块不会被释放；
+ *                再给块的全局计数加一，然后尝试把本地计数还回去（CAS 减一）；
+ *                如果字里的指针已经变了，说明写者已经把本地计数折算进了全局计数，改为全局计数减一。
+ *      exchange：交换出旧字后，把旧字里的本地计数加到旧块的全局计数上，完成折算。
+ * 本地计数是可互换的，因此即使同一个块被换出又换回（ABA），总数依然正确。
+ * 要求同时处于 load 中的线程不超过 65535 个。
+ */
+template <typename T>
+class atomic_counted_ptr
+{
+    typedef typename counted_ptr<T>::Block Block;
+    static_assert(sizeof(void *) == 8, "atomic_counted_ptr packs a 48-bit pointer into 64 bits");
+    static const uint64_t PTR_MASK = (uint64_t(1) << 48) - 1;
+    static const uint64_t ONE_LOCAL = uint64_t(1) << 48;
+
+public:
+    atomic_counted_ptr() : word(0) {}
+    explicit atomic_counted_ptr(counted_ptr<T> p) : word(pack(take(p))) {}
+    atomic_counted_ptr(const atomic_counted_ptr &) = delete;
+    atomic_counted_ptr &operator=(const atomic_counted_ptr &) = delete;
+    ~atomic_counted_ptr() { counted_ptr<T>::release(unpack(word.load()), 1); }
+
+    counted_ptr<T> load() const
+    {
+        uint64_t old = word.fetch_add(ONE_LOCAL, std::memory_order_acquire);
+        Block *b = unpack(old);
+        if (b)
+            b->refs.fetch_add(1, std::memory_order_relaxed);
+        uint64_t cur = old + ONE_LOCAL;
+        for (;;)
+        {
+            if (unpack(cur) != b || (cur >> 48) == 0)
+            {
+                // 本地计数已被写者折算进全局计数
+                if (b)
+                    b->refs.fetch_sub(1, std::memory_order_relaxed);
+                break;
+            }
+            if (word.compare_exchange_weak(cur, cur - ONE_LOCAL, std::memory_order_relaxed))
+                break;
+        }
+        return counted_ptr<T>(b);
+    }
+
+    counted_ptr<T> exchange(counted_ptr<T> p)
+    {
+        uint64_t old = word.exchange(pack(take(p)), std::memory_order_acq_rel);
+        return counted_ptr<T>(settle(old));
+    }
+
+    void store(counted_ptr<T> p) { exchange(std::move(p)); }
+
+    // 只比较块指针，与 atomic<shared_ptr>::compare_exchange_strong 语义一致
+    bool compare_exchange_strong(counted_ptr<T> &expected, counted_ptr<T> desired)
+    {
+        uint64_t cur = word.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            if (unpack(cur) != expected.block)
+            {
+                expected = load();
+                return false;
+            }
+            if (word.compare_exchange_weak(cur, pack(desired.block), std::memory_order_acq_rel))
+            {
+                desired.block = nullptr; // 所有权转移给 word
+                counted_ptr<T>::release(settle(cur), 1);
+                return true;
+            }
+        }
+    }
+
+private:
+    static uint64_t pack(Block *b) { return (uint64_t)b; }
+    static Block *unpack(uint64_t w) { return (Block *)(w & PTR_MASK); }
+    static Block *take(counted_ptr<T> &p)
+    {
+        Block *b = p.block;
+        p.block = nullptr;
+        return b;
+    }
+    // 把旧字中的本地计数折算到全局计数，返回旧块（带着 word 原来持有的那一份计数）
+    static Block *settle(uint64_t old)
+    {
+        Block *b = unpack(old);
+        if (b && (old >> 48))
+            b->refs.fetch_add(long(old >> 48), std::memory_order_relaxed);
+        return b;
+    }
+
+    mutable std::atomic<uint64_t> word;
+};
+#pragma endregion
+
+#pragma region rcu_ptr
+/** epoch 槽位
+ *
+ * 每个线程在第一次读时认领一个独占 cache line 的槽位，线程退出时归还。
+ * 槽位在所有 rcu_ptr（以及 concurrent_segment_tree.cc 中的树）之间共享，同一线程不能嵌套持有两个 read_guard；
+ * 不同对象的 epoch 混在一起扫描只会让回收更保守。
+ * 槽位按块分配，块串成只增不减的链表：注册时找不到空槽位就用 CAS 追加一块，块直到进程退出都不释放，
+ * 因此扫描槽位的写者和注册中的读者都不需要加锁，读者线程数也没有上限。
+ */
+struct EpochSlots
+{
+    static const int SLOTS_PER_BLOCK = 64;
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> epoch{0}; // 0 表示不在读临界区内
+        std::atomic<bool> used{false};
+    };
+
+    struct Block
+    {
+        Slot slots[SLOTS_PER_BLOCK];
+        std::atomic<Block *> next{nullptr};
+    };
+
+    static Block *blocks()
+    {
+        static Block head;
+        return &head;
+    }
+
+    static Slot &mine()
+    {
+        struct Registration
+        {
+            Slot *slot = nullptr;
+            Registration()
+            {
+                for (Block *block = blocks();;)
+                {
+                    for (Slot &s : block->slots)
+                    {
+                        bool expect = false;
+                        if (s.used.compare_exchange_strong(expect, true))
+                        {
+                            slot = &s;
+                            return;
+                        }
+                    }
+                    Block *next = block->next.load();
+                    if (!next)
+                    {
+                        Block *fresh = new Block;
+                        if (block->next.compare_exchange_strong(next, fresh))
+                            next = fresh;
+                        else
+                            delete fresh; // 别的线程先追加了，next 已是它的块
+                    }
+                    block = next;
+                }
+            }
+            ~Registration() { slot->used.store(false); }
+        };
+        thread_local Registration registration;
+        return *registration.slot;
+    }
+
+    static uint64_t minActive()
+    {
+        uint64_t res = UINT64_MAX;
+        for (Block *block = blocks(); block; block = block->next.load())
+            for (Slot &s : block->slots)
+            {
+                uint64_t e = s.epoch.load();
+                if (e && e < res)
+                    res = e;
+            }
+        return res;
+    }
+};
+
+/** rcu_ptr
+ *
+ * 读者：read() 把全局 epoch 写入本线程槽位，读取指针，read_guard 析构时清零，全程没有 RMW；
+ * 写者：store() 交换指针，旧对象挂到当前 epoch 的回收队列上，并推进 epoch；
+ *      所有活跃读者的 epoch 都大于旧对象的 epoch 时，旧对象才会被 delete。
+ * 适合配置、路由表这类读远多于写的数据，写者之间用互斥锁串行化。
+ */
+template <typename T>
+class rcu_ptr
+{
+public:
+    class read_guard
+    {
+    public:
+        read_guard(EpochSlots::Slot *s, const T *p) : slot(s), ptr(p) {}
+        read_guard(read_guard &&other) noexcept : slot(other.slot), ptr(other.ptr) { other.slot = nullptr; }
+        read_guard(const read_guard &) = delete;
+        ~read_guard()
+        {
+            if (slot)
+                slot->epoch.store(0, std::memory_order_release);
+        }
+        const T *get() const { return ptr; }
+        const T &operator*() const { return *ptr; }
+        const T *operator->() const { return ptr; }
+        explicit operator bool() const { return ptr != nullptr; }
+
+    private:
+        EpochSlots::Slot *slot;
+        const T *ptr;
+    };
+
+    explicit rcu_ptr(T *p = nullptr) : ptr(p), epoch(1) {}
+    rcu_ptr(const rcu_ptr &) = delete;
+    rcu_ptr &operator=(const rcu_ptr &) = delete;
+    ~rcu_ptr()
+    {
+        delete ptr.load();
+        for (auto &r : retired)
+            delete r.second;
+    }
+
+    read_guard read() const
+    {
+        EpochSlots::Slot &slot = EpochSlots::mine();
+        slot.epoch.store(epoch.load());
+        return read_guard(&slot, ptr.load());
+    }
+
+    void store(T *p)
+    {
+        std::lock_guard<std::mutex> guard(writer);
+        T *old = ptr.exchange(p);
+        if (old)
+            retired.emplace_back(epoch.fetch_add(1), old);
+        reclaimLocked();
+    }
+
+    // 回收所有已经没有读者的旧对象，返回仍在等待的数量
+    size_t reclaim()
+    {
+        std::lock_guard<std::mutex> guard(writer);
+        return reclaimLocked();
+    }
+
+private:
+    size_t reclaimLocked()
+    {
+        uint64_t minActive = EpochSlots::minActive();
+        while (!retired.empty() && retired.front().first < minActive)
+        {
+            delete retired.front().second;
+            retired.pop_front();
+        }
+        return retired.size();
+    }
+
+    std::atomic<T *> ptr;
+    mutable std::atomic<uint64_t> epoch;
+    std::mutex writer;
+    std::deque<std::pair<uint64_t, T *>> retired;
+};
+#pragma endregion
@@ -0,0 +1,234 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <deque>
+#include "concurrent_ptr.h"
+#include "segment_tree.h"
+using namespace std;
+
+// 读友好的并发线段树（区间加、区间最大值）
+// 编译：g++ -std=c++17 -O2 -pthread concurrent_segment_tree.cc -o concurrent_segment_tree
+
+/** 为什么原来的线段树只能加全局锁？
+ *
+ * segment_tree.h 中的 query 会调用 addChild 和 pushDown，读操作也在修改树，
+ * 所以即使是读写锁也不行，所有读者只能被一把互斥锁串行化。
+ */
+
+/** RCU 式的写时复制
+ *
+ * 节点一旦发布就不再修改：
+ *      写者（互斥锁串行化）用路径复制生成新的 O(log n) 个节点，其余子树与旧版本共享，
+ *      然后原子地把 root 指向新根，旧路径上被替换下来的节点交给 epoch 回收；
+ *      读者不加锁，原子地读取 root 后在不可变的树上查询，mask 不下放，沿路径累加（标记永久化）。
+ *
+ * epoch 回收：
+ *      读者进入时把当前全局 epoch 写入自己的槽位（concurrent_ptr.h 的 EpochSlots，每个槽位独占一个 cache line），退出时清零；
+ *      写者发布新根后把旧节点挂到 epoch = R 的回收批次上，并把全局 epoch 加一；
+ *      当所有活跃读者的 epoch 都大于 R 时，它们读到的一定是新根，R 批次的节点可以安全释放。
+ * 所有相关原子操作都使用 seq_cst，保证“写槽位 -> 读 root”与“写 root -> 扫描槽位”不会重排。
+ */
+class ConcurrentSegmentTree
+{
+public:
+    ConcurrentSegmentTree(int lo, int hi) : lo(lo), hi(hi), root(nullptr), globalEpoch(1) {}
+    ConcurrentSegmentTree(const ConcurrentSegmentTree &) = delete;
+    ConcurrentSegmentTree &operator=(const ConcurrentSegmentTree &) = delete;
+    ~ConcurrentSegmentTree()
+    {
+        freeTree(root.load());
+        for (auto &batch : retired)
+            for (CNode *node : batch.second)
+                delete node;
+    }
+
+    // 无锁读，不修改任何共享节点
+    int query(int l, int r)
+    {
+        EpochSlots::Slot &slot = EpochSlots::mine();
+        slot.epoch.store(globalEpoch.load());
+        int res = query(root.load(), lo, hi, l, r, 0);
+        slot.epoch.store(0, memory_order_release);
+        return res;
+    }
+
+    // 写者之间串行化
+    void update(int l, int r, int val)
+    {
+        lock_guard<mutex> guard(writer);
+        vector<CNode *> replaced;
+        CNode *newRoot = update(root.load(memory_order_relaxed), lo, hi, l, r, val, replaced);
+        root.store(newRoot);
+        retired.emplace_back(globalEpoch.fetch_add(1), move(replaced));
+        reclaim();
+    }
+
+private:
+    struct CNode
+    {
+        int data, mask;
+        CNode *lchild, *rchild; // 空孩子表示整段都是 0
+    };
+
+    static int dataOf(const CNode *node) { return node ? node->data : 0; }
+
+    static void freeTree(CNode *node)
+    {
+        if (!node)
+            return;
+        freeTree(node->lchild);
+        freeTree(node->rchild);
+        delete node;
+    }
+
+    CNode *update(CNode *old, int nl, int nr, int l, int r, int val, vector<CNode *> &replaced)
+    {
+        CNode *node = old ? new CNode(*old) : new CNode{0, 0, nullptr, nullptr};
+        if (old)
+            replaced.push_back(old);
+        if (l <= nl && r >= nr)
+        {
+            node->data += val;
+            node->mask += val;
+            return node;
+        }
+        int mid = nl + (nr - nl) / 2;
+        if (l <= mid)
+            node->lchild = update(node->lchild, nl, mid, l, r, val, replaced);
+        if (r > mid)
+            node->rchild = update(node->rchild, mid + 1, nr, l, r, val, replaced);
+        node->data = max(dataOf(node->lchild), dataOf(node->rchild)) + node->mask;
+        return node;
+    }
+
+    int query(const CNode *node, int nl, int nr, int l, int r, int add) const
+    {
+        if (!node)
+            return add;
+        if (l <= nl && r >= nr)
+            return node->data + add;
+        int mid = nl + (nr - nl) / 2;
+        int res = INT_MIN;
+        if (l <= mid)
+            res = max(res, query(node->lchild, nl, mid, l, r, add + node->mask));
+        if (r > mid)
+            res = max(res, query(node->rchild, mid + 1, nr, l, r, add + node->mask));
+        return res;
+    }
+
+    // 持有 writer 锁时调用
+    void reclaim()
+    {
+        uint64_t minActive = EpochSlots::minActive();
+        while (!retired.empty() && retired.front().first < minActive)
+        {
+            for (CNode *node : retired.front().second)
+                delete node;
+            retired.pop_front();
+        }
+    }
+
+private:
+    int lo, hi;
+    atomic<CNode *> root;
+    atomic<uint64_t> globalEpoch;
+    mutex writer;
+    deque<pair<uint64_t, vector<CNode *>>> retired;
+};
+
+// 对照组：原来的线段树只能用一把全局锁保护
+class LockedSegmentTree
+{
+public:
+    LockedSegmentTree(int lo, int hi) : root(new Node(lo, hi)) {}
+    ~LockedSegmentTree() { delete root; }
+    int query(int l, int r)
+    {
+        lock_guard<mutex> guard(mutex_t);
+        return ::query(root, l, r);
+    }
+    void update(int l, int r, int val)
+    {
+        lock_guard<mutex> guard(mutex_t);
+        ::update(root, l, r, val);
+    }
+
+private:
+    Node *root;
+    mutex mutex_t;
+};
+
+template <typename Tree>
+double run(Tree &tree, int n, int threads, int opsPerThread, int writePermille)
+{
+    vector<thread> workers;
+    atomic<bool> go(false);
+    atomic<long> sink(0); // 防止查询结果被编译器优化掉
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]()
+                             {
+            mt19937 rng(t + 1);
+            while (!go.load())
+                this_thread::yield();
+            long local = 0;
+            for (int i = 0; i < opsPerThread; i++)
+            {
+                int l = rng() % n, r = rng() % n;
+                if (l > r)
+                    swap(l, r);
+                if ((int)(rng() % 1000) < writePermille)
+                    tree.update(l, r, rng() % 100);
+                else
+                    local += tree.query(l, r);
+            }
+            sink += local; });
+    }
+    auto begin = chrono::steady_clock::now();
+    go.store(true);
+    for (auto &w : workers)
+        w.join();
+    double t = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    return threads * (double)opsPerThread / t;
+}
+
+int main(int argc, char const *argv[])
+{
+    const int n = 1 << 20, opsPerThread = 200000, writePermille = 10; // 1% 写
+    int maxThreads = max(4u, thread::hardware_concurrency());
+
+    // 先做一次单线程正确性校验
+    {
+        ConcurrentSegmentTree a(0, n - 1);
+        LockedSegmentTree b(0, n - 1);
+        mt19937 rng(1);
+        bool ok = true;
+        for (int i = 0; i < 100000 && ok; i++)
+        {
+            int l = rng() % n, r = rng() % n;
+            if (l > r)
+                swap(l, r);
+            if (i % 3 == 0)
+            {
+                int v = rng() % 100;
+                a.update(l, r, v);
+                b.update(l, r, v);
+            }
+            else
+                ok = a.query(l, r) == b.query(l, r);
+        }
+        cout << (ok ? "results match" : "results MISMATCH") << endl;
+    }
+
+    cout << "threads\tglobal-lock ops/s\tlock-free-read ops/s" << endl;
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        LockedSegmentTree locked(0, n - 1);
+        ConcurrentSegmentTree rcu(0, n - 1);
+        double a = run(locked, n, threads, opsPerThread, writePermille);
+        double b = run(rcu, n, threads, opsPerThread, writePermille);
+        cout << threads << "\t" << a << "\t\t" << b << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,212 @@
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "fast_cast.h"
+using namespace std;
+
+// 对比 dynamic_cast 与 fast_cast 在不同继承深度、多继承、虚继承下的下行转换开销
+// 编译：g++ -std=c++17 -O2 fast_cast.cc -o fast_cast
+
+#pragma region 单继承链 Chain<0> <- Chain<1> <- ... <- Chain<8>
+template <int N>
+struct Chain;
+
+template <>
+struct Chain<0>
+{
+    FAST_CAST_ROOT(Chain<0>)
+    virtual ~Chain() {}
+    int level = 0;
+};
+
+template <int N>
+struct Chain : Chain<N - 1>
+{
+    FAST_CAST_CLASS(Chain<N>, Chain<N - 1>)
+};
+
+// 与 Chain<1> 平级的另一个分支，用于测试失败的转换
+struct Sibling : Chain<0>
+{
+    FAST_CAST_CLASS(Sibling, Chain<0>)
+};
+#pragma endregion
+
+#pragma region 多继承，对应 vtable.cc 中的 Derived_multi_override
+struct Base1
+{
+    FAST_CAST_ROOT(Base1)
+    virtual ~Base1() {}
+    int b1 = 1;
+};
+struct Base2
+{
+    FAST_CAST_ROOT(Base2)
+    virtual ~Base2() {}
+    int b2 = 2;
+};
+struct Base3
+{
+    FAST_CAST_ROOT(Base3)
+    virtual ~Base3() {}
+    int b3 = 3;
+};
+struct MultiDerived : Base1, Base2, Base3
+{
+    FAST_CAST_CLASS(MultiDerived, Base1, Base2, Base3)
+    int d = 4;
+};
+#pragma endregion
+
+#pragma region 菱形虚继承，对应 VDerived
+struct VBase
+{
+    FAST_CAST_ROOT(VBase)
+    virtual ~VBase() {}
+    int a = 1;
+};
+struct VBase1 : virtual VBase
+{
+    FAST_CAST_CLASS(VBase1, VBase)
+    int v1 = 1;
+};
+struct VBase2 : virtual VBase
+{
+    FAST_CAST_CLASS(VBase2, VBase)
+    int v2 = 2;
+};
+struct VDerived : VBase1, VBase2
+{
+    FAST_CAST_CLASS(VDerived, VBase1, VBase2)
+    int d = 3;
+};
+#pragma endregion
+
+#pragma region 重复的非虚基类：RMulti 中有两个 RRoot 子对象
+struct RRoot
+{
+    FAST_CAST_ROOT(RRoot)
+    virtual ~RRoot() {}
+    int r = 0;
+};
+struct RLeft : RRoot
+{
+    FAST_CAST_CLASS(RLeft, RRoot)
+    int l = 1;
+};
+struct RRight : RRoot
+{
+    FAST_CAST_CLASS(RRight, RRoot)
+    int r2 = 2;
+};
+struct RMulti : RLeft, RRight
+{
+    FAST_CAST_CLASS(RMulti, RLeft, RRight)
+    int m = 3;
+};
+#pragma endregion
+
+static volatile long sink;
+
+// 对 objs 中每个对象做 rounds 轮转换，返回每次转换的纳秒数
+template <typename Cast, typename From>
+double timeCast(const vector<From *> &objs, int rounds, Cast cast)
+{
+    long hits = 0;
+    auto begin = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++)
+        for (From *p : objs)
+            hits += cast(p) != nullptr;
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count();
+    sink = hits;
+    return ns / (double(objs.size()) * rounds);
+}
+
+template <typename To, typename From>
+void compare(const string &name, const vector<From *> &objs, int rounds)
+{
+    bool same = true;
+    for (From *p : objs)
+        same = same && fast_cast<To *>(p) == dynamic_cast<To *>(p);
+    double d = timeCast(objs, rounds, [](From *p)
+                        { return dynamic_cast<To *>(p); });
+    double f = timeCast(objs, rounds, [](From *p)
+                        { return fast_cast<To *>(p); });
+    cout << name << "\tdynamic_cast " << d << " ns\tfast_cast " << f << " ns"
+         << (same ? "" : "\tresults MISMATCH") << endl;
+}
+
+template <int Target>
+void compareDepth(const vector<Chain<0> *> &objs, int rounds)
+{
+    compare<Chain<Target>>("Chain<0>* -> Chain<" + to_string(Target) + ">*", objs, rounds);
+}
+
+int main(int argc, char const *argv[])
+{
+    const int n = 4096, rounds = 500;
+
+    // 动态类型都是最深的 Chain<8>，目标深度越浅，dynamic_cast 要走的路径越长
+    vector<unique_ptr<Chain<0>>> owned;
+    vector<Chain<0> *> deep;
+    for (int i = 0; i < n; i++)
+    {
+        owned.emplace_back(new Chain<8>());
+        deep.push_back(owned.back().get());
+    }
+    compareDepth<1>(deep, rounds);
+    compareDepth<4>(deep, rounds);
+    compareDepth<8>(deep, rounds);
+
+    // 一半对象转换失败
+    vector<Chain<0> *> mixed;
+    for (int i = 0; i < n; i++)
+    {
+        owned.emplace_back(i % 2 ? (Chain<0> *)new Sibling() : (Chain<0> *)new Chain<4>());
+        mixed.push_back(owned.back().get());
+    }
+    compare<Chain<4>>("mixed 50% fail -> Chain<4>*", mixed, rounds);
+
+    // 多继承：从第二个基类向下转换需要调整 this，交叉转换走 dynamic_cast 回退
+    vector<unique_ptr<MultiDerived>> multi;
+    vector<Base2 *> viaBase2;
+    for (int i = 0; i < n; i++)
+    {
+        multi.emplace_back(new MultiDerived());
+        viaBase2.push_back(multi.back().get());
+    }
+    compare<MultiDerived>("Base2* -> MultiDerived*", viaBase2, rounds);
+    compare<Base3>("Base2* -> Base3* (cross)", viaBase2, rounds);
+
+    // 虚继承：从虚基类向下只能 dynamic_cast，fast_cast 先做 O(1) 检查再回退
+    vector<unique_ptr<VBase>> vowned;
+    vector<VBase *> viaVBase;
+    for (int i = 0; i < n; i++)
+    {
+        vowned.emplace_back(i % 2 ? (VBase *)new VDerived() : (VBase *)new VBase1());
+        viaVBase.push_back(vowned.back().get());
+    }
+    compare<VDerived>("VBase* -> VDerived* (virtual)", viaVBase, rounds);
+    vector<VBase1 *> viaVBase1;
+    for (auto &p : vowned)
+        viaVBase1.push_back(dynamic_cast<VBase1 *>(p.get()));
+    compare<VDerived>("VBase1* -> VDerived*", viaVBase1, rounds);
+
+    // 重复基类：RRoot* 指向哪一个 RRoot 子对象决定了结果，不能 static_cast
+    vector<unique_ptr<RMulti>> rowned;
+    vector<RRoot *> viaLeft, viaRight;
+    for (int i = 0; i < n; i++)
+    {
+        rowned.emplace_back(new RMulti());
+        viaLeft.push_back(static_cast<RLeft *>(rowned.back().get()));
+        viaRight.push_back(static_cast<RRight *>(rowned.back().get()));
+    }
+    compare<RRight>("RRoot*(in RLeft) -> RRight* (repeated)", viaLeft, rounds);
+    compare<RLeft>("RRoot*(in RRight) -> RLeft* (repeated)", viaRight, rounds);
+    compare<RLeft>("RRoot*(in RLeft) -> RLeft* (repeated)", viaLeft, rounds);
+    compare<RMulti>("RRoot*(in RRight) -> RMulti* (repeated)", viaRight, rounds);
+    return 0;
+}
@@ -0,0 +1,243 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+/** fast_cast：O(1) 的带类型检查下行转换
+ *
+ * four_cast.cc 中的 dynamic_cast 在运行时要比较 type_info、遍历 __class_type_info 描述的继承图，
+ * 多继承和虚继承（vtable.cc 中的 Derived_multi_override、VDerived）时遍历的路径更长。
+ *
+ * 这里使用 Cohen 的 display 编码：
+ *      每个类在编译期得到一个唯一的地址作为类型 ID（fast_cast_traits<T>::tag 的地址），
+ *      以及沿“主基类链”从根到自己的 ID 数组 display，深度为 depth；
+ *      判断动态类型 X 是否是 T 的子类，只需要检查 X.depth >= T.depth && X.display[T.depth] == T.tag。
+ * 多继承时，非主基类一侧的祖先放在 secondary 数组中，主链检查失败后再线性扫描（通常只有几个）。
+ *
+ * 检查通过后：
+ *      在主链上命中、且能用 static_cast 完成的下行转换（包括多继承时的 this 调整）直接 static_cast；
+ *      从虚基类向下转换、兄弟类之间的交叉转换，static_cast 不合法，退回 dynamic_cast，结果依然正确；
+ *      在 secondary 中命中，或源类型、目标类型在动态类型的祖先中出现不止一次（重复的非虚基类，
+ *      如 Root <- A、Root <- B、M : A, B 中的 Root），指针指向的是哪一个子对象只有 dynamic_cast 知道，也退回。
+ * 检查失败返回 nullptr，语义与 dynamic_cast 指针版本相同。
+ *
+ * 用法（opt-in，只对声明了的类生效）：
+ *      struct Root { FAST_CAST_ROOT(Root) virtual ~Root() {} };
+ *      struct A : Root { FAST_CAST_CLASS(A, Root) };                 // 第一个基类为主基类
+ *      struct M : A, Other { FAST_CAST_CLASS(M, A, Other) };        // 其余为次基类
+ *      A *a = fast_cast<A *>(root);
+ */
+
+struct fast_cast_info
+{
+    size_t depth;
+    const void *const *display;
+    size_t nsecondary;
+    const void *const *secondary;
+    size_t nrepeated; // display 与 secondary 中出现不止一次的 ID，绝大多数类为 0 个
+    const void *const *repeated;
+};
+
+template <typename T>
+struct fast_cast_traits;
+
+namespace fast_cast_detail
+{
+    template <typename... Ts>
+    struct type_list
+    {
+    };
+
+    template <size_t N, size_t M>
+    constexpr std::array<const void *, N + M> concat(const std::array<const void *, N> &a,
+                                                     const std::array<const void *, M> &b)
+    {
+        std::array<const void *, N + M> res{};
+        for (size_t i = 0; i < N; i++)
+            res[i] = a[i];
+        for (size_t i = 0; i < M; i++)
+            res[N + i] = b[i];
+        return res;
+    }
+
+    constexpr std::array<const void *, 0> concat_all() { return {}; }
+
+    template <size_t N, typename... Rest>
+    constexpr auto concat_all(const std::array<const void *, N> &first, const Rest &...rest)
+    {
+        return concat(first, concat_all(rest...));
+    }
+
+    // 一个类的全部祖先（主链 + 次基类两侧），作为子类 secondary 的来源
+    template <typename T>
+    constexpr auto all_ancestors() { return concat(fast_cast_traits<T>::display, fast_cast_traits<T>::secondary); }
+
+    template <size_t N>
+    constexpr bool is_repeated(const std::array<const void *, N> &a, size_t i)
+    {
+        for (size_t j = 0; j < N; j++)
+            if (j != i && a[j] == a[i])
+                return j > i; // 只在第一次出现的位置计数
+        return false;
+    }
+
+    template <size_t N>
+    constexpr size_t count_repeated(const std::array<const void *, N> &a)
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < N; i++)
+            n += is_repeated(a, i);
+        return n;
+    }
+
+    template <size_t M, size_t N>
+    constexpr std::array<const void *, M> repeated_of(const std::array<const void *, N> &a)
+    {
+        std::array<const void *, M> res{};
+        for (size_t i = 0, k = 0; i < N; i++)
+            if (is_repeated(a, i))
+                res[k++] = a[i];
+        return res;
+    }
+
+    template <typename List>
+    struct secondary_of;
+    template <typename... S>
+    struct secondary_of<type_list<S...>>
+    {
+        static constexpr auto value = concat_all(all_ancestors<S>()...);
+    };
+
+    template <typename T, typename = void>
+    struct primary_display
+    {
+        static constexpr std::array<const void *, 0> display{};
+        static constexpr std::array<const void *, 0> secondary{};
+    };
+    template <typename T>
+    struct primary_display<T, std::enable_if_t<!std::is_void<T>::value>>
+    {
+        static constexpr auto display = fast_cast_traits<T>::display;
+        static constexpr auto secondary = fast_cast_traits<T>::secondary;
+    };
+
+    template <typename From, typename To, typename = void>
+    struct static_downcastable : std::false_type
+    {
+    };
+    template <typename From, typename To>
+    struct static_downcastable<From, To, std::void_t<decltype(static_cast<To *>(std::declval<From *>()))>>
+        : std::true_type
+    {
+    };
+} // namespace fast_cast_detail
+
+template <typename T>
+struct fast_cast_traits
+{
+    typedef typename T::fast_cast_primary Primary;
+    typedef fast_cast_detail::primary_display<Primary> Parent;
+
+    static constexpr char tag = 0;
+    static constexpr auto display = fast_cast_detail::concat(Parent::display, std::array<const void *, 1>{&tag});
+    static constexpr auto secondary =
+        fast_cast_detail::concat(Parent::secondary,
+                                 fast_cast_detail::secondary_of<typename T::fast_cast_secondary>::value);
+    static constexpr auto ancestors = fast_cast_detail::concat(display, secondary);
+    static constexpr auto repeated =
+        fast_cast_detail::repeated_of<fast_cast_detail::count_repeated(ancestors)>(ancestors);
+    static constexpr fast_cast_info info{display.size() - 1, display.data(), secondary.size(),
+                                         secondary.data(), repeated.size(), repeated.data()};
+};
+
+namespace fast_cast_detail
+{
+    enum match_kind
+    {
+        NO_MATCH,
+        DISPLAY_MATCH,
+        SECONDARY_MATCH,
+    };
+
+    template <typename T>
+    inline match_kind match(const fast_cast_info *info)
+    {
+        typedef fast_cast_traits<T> Traits;
+        const size_t depth = Traits::display.size() - 1;
+        if (info->depth >= depth && info->display[depth] == &Traits::tag)
+            return DISPLAY_MATCH;
+        for (size_t i = 0; i < info->nsecondary; i++)
+            if (info->secondary[i] == &Traits::tag)
+                return SECONDARY_MATCH;
+        return NO_MATCH;
+    }
+
+    template <typename T>
+    inline bool is_repeated_in(const fast_cast_info *info)
+    {
+        for (size_t i = 0; i < info->nrepeated; i++)
+            if (info->repeated[i] == &fast_cast_traits<T>::tag)
+                return true;
+        return false;
+    }
+
+    // From 与 To 在动态类型中各只有一个子对象时，static_cast 的 this 调整才是唯一确定的；
+    // From 没有声明 FAST_CAST_CLASS 时不知道它的 ID，只要有重复的祖先就不用 static_cast
+    template <typename To, typename From>
+    inline bool unique_subobjects(const fast_cast_info *info)
+    {
+        if (info->nrepeated == 0)
+            return true;
+        if constexpr (std::is_same<typename From::fast_cast_self, From>::value)
+            return !is_repeated_in<To>(info) && !is_repeated_in<From>(info);
+        else
+            return false;
+    }
+} // namespace fast_cast_detail
+
+// 动态类型 info 是否是 T 或 T 的子类
+template <typename T>
+inline bool fast_cast_is(const fast_cast_info *info)
+{
+    return fast_cast_detail::match<T>(info) != fast_cast_detail::NO_MATCH;
+}
+
+#define FAST_CAST_ROOT(Self)                                                              \
+public:                                                                                   \
+    typedef Self fast_cast_self;                                                          \
+    typedef void fast_cast_primary;                                                       \
+    typedef fast_cast_detail::type_list<> fast_cast_secondary;                            \
+    virtual const fast_cast_info *fast_cast_type() const { return &fast_cast_traits<Self>::info; }
+
+#define FAST_CAST_CLASS(Self, Primary, ...)                                               \
+public:                                                                                   \
+    typedef Self fast_cast_self;                                                          \
+    typedef Primary fast_cast_primary;                                                    \
+    typedef fast_cast_detail::type_list<__VA_ARGS__> fast_cast_secondary;                 \
+    const fast_cast_info *fast_cast_type() const override { return &fast_cast_traits<Self>::info; }
+
+template <typename ToPtr, typename From>
+ToPtr fast_cast(From *p)
+{
+    static_assert(std::is_pointer<ToPtr>::value, "fast_cast only supports pointer targets");
+    typedef std::remove_cv_t<std::remove_pointer_t<ToPtr>> To;
+    static_assert(std::is_same<typename To::fast_cast_self, To>::value,
+                  "target class must declare FAST_CAST_CLASS");
+    if (!p)
+        return nullptr;
+    if constexpr (std::is_base_of<To, std::remove_cv_t<From>>::value)
+        return p; // 上行转换
+    else
+    {
+        const fast_cast_info *info = p->fast_cast_type();
+        fast_cast_detail::match_kind m = fast_cast_detail::match<To>(info);
+        if (m == fast_cast_detail::NO_MATCH)
+            return nullptr;
+        if constexpr (fast_cast_detail::static_downcastable<From, std::remove_pointer_t<ToPtr>>::value)
+            if (m == fast_cast_detail::DISPLAY_MATCH &&
+                fast_cast_detail::unique_subobjects<To, std::remove_cv_t<From>>(info))
+                return static_cast<ToPtr>(p);
+        return dynamic_cast<ToPtr>(p); // 虚基类向下、交叉转换、重复基类
+    }
+}
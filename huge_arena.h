@@ -0,0 +1,318 @@
+#pragma once
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <vector>
+
+/** 大页支撑的 arena，给大的常驻结构（LRU_Cache 的链表与哈希表节点、稠密线段树的数组）减少 dTLB 缺失，用法与基准见 huge_arena.cc
+ *
+ * 按块映射（chunkBytes，2MB 的整数倍），块内指针递增分配。每块按 Mode 选择映射方式：
+ *      hugetlb       mmap(MAP_HUGETLB)，用预留的 2MB 大页（/proc/sys/vm/nr_hugepages），预留不够时 mmap 直接失败，不会等到缺页时 SIGBUS；
+ *      transparent   2MB 对齐的匿名映射 + madvise(MADV_HUGEPAGE)，缺页时由内核尽量分配透明大页（THP 为 never 时 madvise 失败）；
+ *      small         普通 4KB 页（MADV_NOHUGEPAGE，THP 为 always 时也不换成大页）；
+ *      automatic     依次尝试以上三种，每一块单独回退。
+ * 除 small 与 automatic 外，指定的方式失败时 allocate 抛出 std::bad_alloc。
+ * 透明大页是尽力而为的，实际由大页支撑的字节数看 huge_bytes()。
+ *
+ * 选项：
+ *      node      LOCAL_NODE 为创建 arena 的线程所在的 NUMA 节点，>= 0 为指定节点，NO_NODE 不设策略（首次写入的线程所在节点）；
+ *                用 mbind(MPOL_PREFERRED)，节点内存不足时仍可从其他节点分配；不支持 NUMA 的内核上失败，计入 Stats::numaFailures
+ *      prefault  映射后立即分配物理页（MADV_POPULATE_WRITE，Linux 5.14 之前逐页写一次），缺页不再发生在请求路径上
+ *
+ * deallocate 把内存放回空闲链表，映射只在 arena 析构时整体归还。链表都是侵入式的，存放在空闲块自身之中，deallocate 不分配内存：
+ *      不超过 4KB    按大小（16 字节的倍数）各一个链表，同样大小的分配直接复用；
+ *      超过 4KB      大小向上取整到所在 2 的幂区间 (2^k, 2^(k+1)] 的 1/4 的倍数（浪费不超过 1/4），每个取整后的大小一个链表。
+ *                    不切分、不合并，释放后只被同一档的分配复用，反复分配释放同样大小（vector 增长、哈希表的桶数组）时不会增长。
+ *
+ * 不是线程安全的。LRU_Cache 的链表与哈希表节点只在缓存锁内分配、释放；但用 allocate_shared 放进 arena 的 value
+ * 在最后一个 Ptr 析构时释放，可能发生在任何线程、不持有缓存锁，多线程使用时调用方要给 arena 加锁，或者 value 不放进 arena。
+ */
+class HugePageArena
+{
+public:
+    enum class Mode
+    {
+        automatic,
+        hugetlb,
+        transparent,
+        small,
+    };
+
+    static constexpr size_t HUGE_PAGE = 2 << 20;
+    static constexpr int LOCAL_NODE = -1;
+    static constexpr int NO_NODE = -2;
+
+    struct Options
+    {
+        Mode mode = Mode::automatic;
+        size_t chunkBytes = 64 << 20;
+        int node = NO_NODE;
+        bool prefault = false;
+    };
+
+    struct Stats
+    {
+        size_t used = 0;             // 已分配出去的字节（含对齐，不扣除空闲链表中的）
+        size_t hugetlbBytes = 0;     // 各种方式映射的字节数
+        size_t transparentBytes = 0;
+        size_t smallBytes = 0;
+        size_t numaFailures = 0;     // mbind 失败的块数
+    };
+
+    HugePageArena() : HugePageArena(Options()) {}
+    explicit HugePageArena(const Options &options) : options(options)
+    {
+        this->options.chunkBytes = roundUp(options.chunkBytes ? options.chunkBytes : HUGE_PAGE, HUGE_PAGE);
+        if (options.node == LOCAL_NODE)
+        {
+            unsigned cpu, node;
+            this->options.node = syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 ? int(node) : NO_NODE;
+        }
+    }
+
+    HugePageArena(const HugePageArena &) = delete;
+    HugePageArena &operator=(const HugePageArena &) = delete;
+
+    ~HugePageArena()
+    {
+        for (const Chunk &c : chunks)
+            munmap(c.base, c.size);
+    }
+
+    void *allocate(size_t size, size_t align = alignof(std::max_align_t))
+    {
+        size = blockSize(size);
+        if (align <= MIN_BLOCK)
+        {
+            void *&head = freeList(size);
+            if (head)
+            {
+                void *p = head;
+                head = *static_cast<void **>(p);
+                return p;
+            }
+        }
+        uintptr_t p = roundUp(uintptr_t(cursor), align);
+        if (!cursor || p + size > uintptr_t(end))
+        {
+            map(roundUp(size + align, HUGE_PAGE));
+            p = roundUp(uintptr_t(cursor), align);
+        }
+        counters.used += p + size - uintptr_t(cursor);
+        cursor = reinterpret_cast<char *>(p + size);
+        return reinterpret_cast<void *>(p);
+    }
+
+    // size 与 allocate 时相同
+    void deallocate(void *p, size_t size) noexcept
+    {
+        if (!p)
+            return;
+        void *&head = freeList(blockSize(size));
+        *static_cast<void **>(p) = head;
+        head = p;
+    }
+
+    const Stats &stats() const { return counters; }
+
+    size_t mapped_bytes() const { return counters.hugetlbBytes + counters.transparentBytes + counters.smallBytes; }
+
+    // 由大页支撑的字节数：hugetlb 块全部计入，其余读 /proc/self/smaps 中与各块重叠的映射的 AnonHugePages。
+    // 相邻的、属性相同的匿名映射会被内核合并成一个，此时可能把 arena 之外的透明大页也算进来
+    size_t huge_bytes() const
+    {
+        size_t total = counters.hugetlbBytes;
+        FILE *f = fopen("/proc/self/smaps", "r");
+        if (!f)
+            return total;
+        char line[512];
+        bool ours = false;
+        while (fgets(line, sizeof(line), f))
+        {
+            unsigned long start, stop;
+            size_t kb;
+            if (sscanf(line, "%lx-%lx ", &start, &stop) == 2)
+                ours = overlaps(start, stop);
+            else if (ours && sscanf(line, "AnonHugePages: %zu kB", &kb) == 1)
+                total += kb << 10;
+        }
+        fclose(f);
+        return total;
+    }
+
+    static const char *name(Mode mode)
+    {
+        switch (mode)
+        {
+        case Mode::hugetlb:
+            return "hugetlb";
+        case Mode::transparent:
+            return "transparent";
+        case Mode::small:
+            return "small";
+        default:
+            return "automatic";
+        }
+    }
+
+private:
+    struct Chunk
+    {
+        char *base;
+        size_t size;
+        Mode mode;
+    };
+
+    static constexpr size_t MIN_BLOCK = 16;
+    static constexpr size_t SMALL_LIMIT = 4096; // 不超过它的大小用数组下标找空闲链表
+    static constexpr int POPULATE_WRITE = 23;   // MADV_POPULATE_WRITE，旧的头文件中没有
+    static constexpr int PREFERRED = 1;         // MPOL_PREFERRED
+
+    template <typename T>
+    static T roundUp(T n, size_t align) { return T((n + align - 1) / align * align); }
+
+    static int log2(size_t n) { return 63 - __builtin_clzll(n); }
+
+    // 实际占用的大小，allocate 与 deallocate 按它找同一个链表
+    static size_t blockSize(size_t size)
+    {
+        size = roundUp(size ? size : 1, MIN_BLOCK);
+        return size <= SMALL_LIMIT ? size : roundUp(size, size_t(1) << (log2(size - 1) - 2));
+    }
+
+    // 取整后超过 SMALL_LIMIT 的大小为 2^k * (1 + j/4)（j = 1..4），第 k 组的第 j % 4 个
+    void *&freeList(size_t size)
+    {
+        if (size <= SMALL_LIMIT)
+            return small[size / MIN_BLOCK];
+        int k = log2(size);
+        return large[k * 4 + int((size >> (k - 2)) & 3)];
+    }
+
+    bool overlaps(uintptr_t start, uintptr_t stop) const
+    {
+        for (const Chunk &c : chunks)
+            if (c.mode != Mode::hugetlb && uintptr_t(c.base) < stop && uintptr_t(c.base) + c.size > start)
+                return true;
+        return false;
+    }
+
+    // 新映射一块，当前块剩下的部分不再使用
+    void map(size_t atLeast)
+    {
+        size_t size = std::max(options.chunkBytes, atLeast);
+        Mode modes[3];
+        int n = 0;
+        if (options.mode == Mode::automatic)
+        {
+            modes[n++] = Mode::hugetlb;
+            modes[n++] = Mode::transparent;
+            modes[n++] = Mode::small;
+        }
+        else
+            modes[n++] = options.mode;
+
+        for (int i = 0; i < n; i++)
+        {
+            char *base = mapWith(modes[i], size);
+            if (!base)
+                continue;
+            chunks.push_back({base, size, modes[i]});
+            (modes[i] == Mode::hugetlb ? counters.hugetlbBytes : modes[i] == Mode::transparent ? counters.transparentBytes
+                                                                                                : counters.smallBytes) += size;
+            if (options.node >= 0 && !bind(base, size))
+                counters.numaFailures++;
+            if (options.prefault)
+                populate(base, size);
+            cursor = base;
+            end = base + size;
+            return;
+        }
+        throw std::bad_alloc();
+    }
+
+    static char *mapWith(Mode mode, size_t size)
+    {
+        const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        if (mode == Mode::hugetlb)
+        {
+            void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+            return p == MAP_FAILED ? nullptr : static_cast<char *>(p);
+        }
+        if (mode == Mode::small)
+        {
+            // THP 为 always 时普通映射也可能被换成大页，明确排除
+            void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+            if (p == MAP_FAILED)
+                return nullptr;
+            madvise(p, size, MADV_NOHUGEPAGE);
+            return static_cast<char *>(p);
+        }
+        // 透明大页要求 2MB 对齐：多映射 2MB，截掉首尾
+        void *raw = mmap(nullptr, size + HUGE_PAGE, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (raw == MAP_FAILED)
+            return nullptr;
+        char *r = static_cast<char *>(raw);
+        char *base = reinterpret_cast<char *>(roundUp(uintptr_t(r), HUGE_PAGE));
+        if (base > r)
+            munmap(r, base - r);
+        if (r + HUGE_PAGE > base)
+            munmap(base + size, r + HUGE_PAGE - base);
+        if (madvise(base, size, MADV_HUGEPAGE) != 0)
+        {
+            munmap(base, size);
+            return nullptr;
+        }
+        return base;
+    }
+
+    bool bind(char *base, size_t size)
+    {
+        if (options.node >= int(8 * sizeof(unsigned long)) - 1)
+            return false;
+        unsigned long mask = 1ul << options.node;
+        return syscall(SYS_mbind, base, size, PREFERRED, &mask, 8 * sizeof(mask), 0) == 0;
+    }
+
+    static void populate(char *base, size_t size)
+    {
+        if (madvise(base, size, POPULATE_WRITE) == 0)
+            return;
+        for (size_t off = 0; off < size; off += 4096)
+            static_cast<volatile char *>(base)[off] = 0;
+    }
+
+    Options options;
+    Stats counters;
+    std::vector<Chunk> chunks;
+    char *cursor = nullptr, *end = nullptr;
+    void *small[SMALL_LIMIT / MIN_BLOCK + 1] = {};
+    void *large[64 * 4] = {};
+};
+
+// 从 HugePageArena 分配的标准分配器，同一个 arena 的分配器相等
+template <typename T>
+struct huge_page_allocator
+{
+    typedef T value_type;
+
+    explicit huge_page_allocator(HugePageArena &arena) noexcept : arena(&arena) {}
+    template <typename U>
+    huge_page_allocator(const huge_page_allocator<U> &other) noexcept : arena(other.arena) {}
+
+    T *allocate(size_t n) { return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T *p, size_t n) noexcept { arena->deallocate(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const huge_page_allocator<U> &other) const noexcept { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const huge_page_allocator<U> &other) const noexcept { return arena != other.arena; }
+
+    HugePageArena *arena;
+};
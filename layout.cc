@@ -0,0 +1,116 @@
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include "layout.h"
+using namespace std;
+
+// 伪共享与 AoS/SoA 扫描的微基准
+// 编译：g++ -std=c++17 -O2 -pthread layout.cc -o layout
+
+// 两个线程各自写一个计数器，计数器紧挨着
+struct SharedCounters
+{
+    atomic<long> a;
+    atomic<long> b;
+};
+
+// 每个计数器独占一个 cache line
+struct PaddedCounters
+{
+    cache_padded<atomic<long>> a;
+    cache_padded<atomic<long>> b;
+};
+
+LAYOUT_OFFSET(SharedCounters, b, 8);
+LAYOUT_SEPARATE_LINES(PaddedCounters, a, b);
+LAYOUT_SIZE(PaddedCounters, 2 * CACHE_LINE);
+
+static atomic<long> &counter(atomic<long> &c) { return c; }
+static atomic<long> &counter(cache_padded<atomic<long>> &c) { return *c; }
+
+template <typename Counters>
+double falseSharing(long iters)
+{
+    Counters c;
+    counter(c.a).store(0);
+    counter(c.b).store(0);
+    auto begin = chrono::steady_clock::now();
+    thread t1([&]()
+              { for (long i = 0; i < iters; i++) counter(c.a).fetch_add(1, memory_order_relaxed); });
+    thread t2([&]()
+              { for (long i = 0; i < iters; i++) counter(c.b).fetch_add(1, memory_order_relaxed); });
+    t1.join();
+    t2.join();
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count();
+    return ns / iters;
+}
+
+// 典型的 AoS 记录：扫描时只用到 price 和 quantity
+struct Order
+{
+    long id;
+    double price;
+    int quantity;
+    int flags;
+    char symbol[16];
+    double timestamp;
+    long account;
+};
+
+static volatile double sink;
+
+int main(int argc, char const *argv[])
+{
+    print_layout<Order>("Order", {LAYOUT_FIELD(Order, id), LAYOUT_FIELD(Order, price), LAYOUT_FIELD(Order, quantity),
+                                  LAYOUT_FIELD(Order, flags), LAYOUT_FIELD(Order, symbol),
+                                  LAYOUT_FIELD(Order, timestamp), LAYOUT_FIELD(Order, account)});
+    print_layout<PaddedCounters>("PaddedCounters", {LAYOUT_FIELD(PaddedCounters, a), LAYOUT_FIELD(PaddedCounters, b)});
+
+    const long iters = 20000000;
+    cout << "false sharing, 2 threads: adjacent " << falseSharing<SharedCounters>(iters) << " ns/inc, padded "
+         << falseSharing<PaddedCounters>(iters) << " ns/inc" << endl;
+
+    const size_t n = 1 << 22;
+    const int rounds = 20;
+    mt19937 rng(9);
+    vector<Order> aos(n);
+    soa_vector<long, double, int, int, double, long> soa;
+    soa.reserve(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        Order &o = aos[i];
+        o.id = i;
+        o.price = rng() % 10000 / 100.0;
+        o.quantity = rng() % 100;
+        o.flags = 0;
+        o.timestamp = i;
+        o.account = rng() % 1000;
+        soa.push_back(o.id, o.price, o.quantity, o.flags, o.timestamp, o.account);
+    }
+
+    // 计算总成交额：只读 price 与 quantity
+    auto begin = chrono::steady_clock::now();
+    double total = 0;
+    for (int r = 0; r < rounds; r++)
+        for (size_t i = 0; i < n; i++)
+            total += aos[i].price * aos[i].quantity;
+    double aosTime = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    sink = total;
+
+    begin = chrono::steady_clock::now();
+    total = 0;
+    const double *price = soa.column<1>();
+    const int *quantity = soa.column<2>();
+    for (int r = 0; r < rounds; r++)
+        for (size_t i = 0; i < n; i++)
+            total += price[i] * quantity[i];
+    double soaTime = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    sink = total;
+
+    double rows = double(n) * rounds;
+    cout << "scan price*quantity: AoS " << rows / aosTime / 1e6 << " Mrows/s (" << sizeof(Order)
+         << " B/row), SoA " << rows / soaTime / 1e6 << " Mrows/s (" << sizeof(double) + sizeof(int) << " B/row)"
+         << endl;
+    return 0;
+}
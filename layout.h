@@ -0,0 +1,163 @@
+#pragma once
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 内存布局工具，用法与测试见 layout.cc，布局断言的例子见 align_offset.cc
+//
+//      cache_padded<T>        独占 cache line 的包装，消除相邻变量之间的伪共享
+//      padding_bytes / LAYOUT_* 在编译期检查字段偏移、填充字节数、两个字段是否落在同一 cache line
+//      print_layout           在运行期打印每个字段的偏移、大小、前面的填充以及所在的 cache line
+//      soa_vector<Fields...>  AoS -> SoA，每个字段一段连续数组，只扫描部分字段时不浪费带宽
+
+// x86-64 与大多数 ARM 的 cache line 都是 64 字节；
+// std::hardware_destructive_interference_size 在 GCC 中会随 -mtune 变化并产生警告，这里直接固定
+constexpr size_t CACHE_LINE = 64;
+
+#pragma region cache_padded
+/**
+ * 伪共享：两个线程分别写两个不同的变量，但它们落在同一个 cache line 上，
+ * 每次写都要让对方核上的这一行失效，性能和写同一个变量差不多。
+ * alignas 保证起始地址按 cache line 对齐，同时 sizeof 也会被补齐为 cache line 的整数倍（见 align_offset.cc），
+ * 因此数组中相邻的两个 cache_padded 一定不在同一行。
+ */
+template <typename T>
+struct alignas(CACHE_LINE) cache_padded
+{
+    T value;
+
+    cache_padded() = default;
+    // 只有一个 cache_padded 参数时让给拷贝/移动构造，否则非 const 左值会优先匹配这里
+    template <typename... Args,
+              typename = std::enable_if_t<!(sizeof...(Args) == 1 &&
+                                            std::conjunction_v<std::is_same<std::decay_t<Args>, cache_padded>...>)>>
+    explicit cache_padded(Args &&...args) : value(std::forward<Args>(args)...) {}
+
+    T &get() { return value; }
+    const T &get() const { return value; }
+    T &operator*() { return value; }
+    const T &operator*() const { return value; }
+    T *operator->() { return &value; }
+    const T *operator->() const { return &value; }
+};
+#pragma endregion
+
+#pragma region 编译期布局检查
+// 所有字段的大小之和，参数为成员指针
+template <typename T, typename... M>
+constexpr size_t field_bytes(M T::*...)
+{
+    return (sizeof(M) + ... + size_t(0));
+}
+
+// 结构体中的填充字节数（字段之间的空洞 + 尾部补齐），需要列出全部字段
+template <typename T, typename... M>
+constexpr size_t padding_bytes(M T::*...fields)
+{
+    return sizeof(T) - field_bytes<T>(fields...);
+}
+
+// offsetof 只能以宏的形式使用，所以偏移相关的检查也写成宏
+#define LAYOUT_OFFSET(Type, field, expected) \
+    static_assert(offsetof(Type, field) == (expected), #Type "::" #field " is not at offset " #expected)
+
+#define LAYOUT_PADDING(Type, expected, ...) \
+    static_assert(padding_bytes<Type>(__VA_ARGS__) == (expected), #Type " padding is not " #expected " bytes")
+
+#define LAYOUT_SIZE(Type, expected) \
+    static_assert(sizeof(Type) == (expected), "sizeof(" #Type ") is not " #expected)
+
+// 两个会被不同线程写的字段不能在同一个 cache line 上
+#define LAYOUT_SEPARATE_LINES(Type, a, b)                                  \
+    static_assert(offsetof(Type, a) / CACHE_LINE != offsetof(Type, b) / CACHE_LINE, \
+                  #Type "::" #a " and " #b " share a cache line")
+#pragma endregion
+
+#pragma region 运行期布局报告
+struct field_layout
+{
+    const char *name;
+    size_t offset, size;
+};
+
+#define LAYOUT_FIELD(Type, field) field_layout{#field, offsetof(Type, field), sizeof(((Type *)nullptr)->field)}
+
+// 字段需要按声明顺序给出
+template <typename T>
+void print_layout(const char *name, std::initializer_list<field_layout> fields, std::ostream &os = std::cout)
+{
+    os << name << ": sizeof " << sizeof(T) << ", alignof " << alignof(T) << std::endl;
+    size_t end = 0, padding = 0;
+    for (const field_layout &f : fields)
+    {
+        padding += f.offset - end;
+        os << "  " << std::setw(12) << std::left << f.name << std::right << " offset " << std::setw(4) << f.offset
+           << " size " << std::setw(4) << f.size << " pad-before " << std::setw(3) << f.offset - end
+           << " line " << f.offset / CACHE_LINE << std::endl;
+        end = f.offset + f.size;
+    }
+    padding += sizeof(T) - end;
+    os << "  tail padding " << sizeof(T) - end << ", total padding " << padding << std::endl;
+}
+#pragma endregion
+
+#pragma region soa_vector
+/**
+ * 结构体数组（AoS）在只访问一两个字段时，每个 cache line 中大部分字节都是用不到的其他字段；
+ * 数组结构体（SoA）把每个字段存成独立的连续数组，扫描一个字段时带宽全部有效，也更容易被自动向量化。
+ *
+ *      soa_vector<float, float, int> v;
+ *      v.push_back(1.f, 2.f, 3);
+ *      float *xs = v.column<0>();     // 第 0 个字段的连续数组
+ *      auto [x, y, id] = v[0];        // 按行访问时返回引用组成的 tuple
+ */
+template <typename... Fields>
+class soa_vector
+{
+public:
+    typedef std::tuple<Fields &...> reference;
+    typedef std::tuple<const Fields &...> const_reference;
+
+    size_t size() const { return std::get<0>(columns).size(); }
+    bool empty() const { return size() == 0; }
+
+    void reserve(size_t n)
+    {
+        std::apply([n](auto &...cols)
+                   { (cols.reserve(n), ...); },
+                   columns);
+    }
+
+    void push_back(const Fields &...values) { push_back_impl(std::index_sequence_for<Fields...>{}, values...); }
+
+    reference operator[](size_t i) { return row(i, std::index_sequence_for<Fields...>{}); }
+    const_reference operator[](size_t i) const { return row(i, std::index_sequence_for<Fields...>{}); }
+
+    template <size_t I>
+    auto *column() { return std::get<I>(columns).data(); }
+    template <size_t I>
+    const auto *column() const { return std::get<I>(columns).data(); }
+
+private:
+    template <size_t... I>
+    void push_back_impl(std::index_sequence<I...>, const Fields &...values)
+    {
+        (std::get<I>(columns).push_back(values), ...);
+    }
+
+    template <size_t... I>
+    reference row(size_t i, std::index_sequence<I...>) { return reference(std::get<I>(columns)[i]...); }
+    template <size_t... I>
+    const_reference row(size_t i, std::index_sequence<I...>) const
+    {
+        return const_reference(std::get<I>(columns)[i]...);
+    }
+
+    std::tuple<std::vector<Fields>...> columns;
+};
+#pragma endregion
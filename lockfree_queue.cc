@@ -0,0 +1,129 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <vector>
+#include "lockfree_queue.h"
+#include "thread_pool.h"
+using namespace std;
+
+// 生产者 x 消费者矩阵：互斥锁队列与无锁队列的吞吐量和端到端延迟，以及替换 ThreadPool 的任务队列
+// 编译：g++ -std=c++20 -O2 -pthread lockfree_queue.cc -o lockfree_queue
+
+static uint64_t nowNs()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 把 LockedTaskQueue 包装成同样的阻塞接口，作为基线
+template <typename T>
+struct LockedQueue : LockedTaskQueue<T>
+{
+    explicit LockedQueue(size_t) {}
+};
+
+struct Result
+{
+    double mops;
+    double p50us, p99us;
+};
+
+// 每个元素是入队时的时间戳，消费者出队时计算延迟
+template <typename Queue, typename... Args>
+Result run(int producers, int consumers, long perProducer, Args... args)
+{
+    Queue q(args...);
+    vector<vector<uint64_t>> latencies(consumers);
+    vector<thread> threads;
+    atomic<long> consumed(0);
+    const long total = perProducer * producers;
+    auto begin = chrono::steady_clock::now();
+    for (int c = 0; c < consumers; c++)
+        threads.emplace_back([&, c]()
+                             {
+            uint64_t stamp;
+            long n = 0;
+            while (q.pop(stamp))
+            {
+                if ((++n & 63) == 0)
+                    latencies[c].push_back(nowNs() - stamp);
+                if (consumed.fetch_add(1, memory_order_relaxed) + 1 == total)
+                    q.close();
+            } });
+    for (int p = 0; p < producers; p++)
+        threads.emplace_back([&]()
+                             {
+            for (long i = 0; i < perProducer; i++)
+                q.push(nowNs()); });
+    for (auto &t : threads)
+        t.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    vector<uint64_t> all;
+    for (auto &l : latencies)
+        all.insert(all.end(), l.begin(), l.end());
+    sort(all.begin(), all.end());
+    auto pct = [&](double p)
+    { return all.empty() ? 0.0 : all[size_t(p * (all.size() - 1))] / 1000.0; };
+    return {total / seconds / 1e6, pct(0.5), pct(0.99)};
+}
+
+static void print(const string &name, int p, int c, const Result &r)
+{
+    cout << "  " << left << setw(10) << name << right << p << "x" << c << "\t" << fixed << setprecision(2) << r.mops
+         << " Mops/s\tp50 " << r.p50us << " us\tp99 " << r.p99us << " us" << defaultfloat << endl;
+}
+
+template <template <typename> class TaskQueue>
+double poolThroughput(size_t threads, long tasks)
+{
+    atomic<long> done(0);
+    auto begin = chrono::steady_clock::now();
+    {
+        BasicThreadPool<SharedTaskAlloc, TaskQueue> pool(threads);
+        vector<future<void>> results;
+        results.reserve(tasks);
+        for (long i = 0; i < tasks; i++)
+            results.push_back(pool.enqueue([&]()
+                                           { done.fetch_add(1, memory_order_relaxed); }));
+        for (auto &r : results)
+            r.wait();
+    }
+    return tasks / chrono::duration<double>(chrono::steady_clock::now() - begin).count() / 1e6;
+}
+
+int main(int argc, char const *argv[])
+{
+    const long items = 2000000;
+    const size_t capacity = 1024;
+    cout << "producers x consumers, " << items << " items per row, capacity " << capacity << endl;
+    for (int p : {1, 2, 4})
+        for (int c : {1, 2, 4})
+        {
+            long perProducer = items / p;
+            print("mutex", p, c, run<LockedQueue<uint64_t>>(p, c, perProducer, capacity));
+            print("mpmc", p, c, run<blocking_queue<mpmc_queue<uint64_t>>>(p, c, perProducer, capacity));
+            if (c == 1)
+                print("mpsc", p, c, run<blocking_queue<mpsc_queue<uint64_t>>>(p, c, perProducer));
+            if (p == 1 && c == 1)
+                print("spsc", p, c, run<blocking_queue<spsc_queue<uint64_t>>>(p, c, perProducer, capacity));
+        }
+
+    const long tasks = 500000;
+    for (size_t threads : {1, 4})
+        cout << "ThreadPool(" << threads << ") " << tasks << " tasks: LockedTaskQueue "
+             << poolThroughput<LockedTaskQueue>(threads, tasks) << " Mtasks/s, LockFreeTaskQueue "
+             << poolThroughput<LockFreeTaskQueue>(threads, tasks) << " Mtasks/s" << endl;
+
+    // push 左值时拷贝，try_push 失败时右值参数不被移走
+    {
+        blocking_queue<mpmc_queue<string>> q(2);
+        string kept = "payload", rejected = "rejected", out;
+        bool ok = q.push(kept) && q.try_push(kept) && !q.try_push(std::move(rejected));
+        ok = ok && kept == "payload" && rejected == "rejected" && q.pop(out) && out == "payload";
+        cout << "lvalue push / failed try_push keep the caller's value: " << (ok ? "yes" : "NO") << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,394 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "layout.h"
+
+#if __cplusplus < 202002L
+#error "lockfree_queue.h requires -std=c++20 (std::atomic::wait / notify)"
+#endif
+
+// 无锁队列，用法与基准见 lockfree_queue.cc
+//
+//      mpmc_queue<T>      有界，多生产者多消费者，Vyukov 的每槽序号算法
+//      spsc_queue<T>      有界，单生产者单消费者，头尾分处两个 cache line，各自缓存对方的位置
+//      mpsc_queue<T>      无界，多生产者单消费者，Vyukov 的侵入式链表（带哨兵节点）
+//      blocking_queue<Q>  为上面任一队列加上阻塞的 push / pop 与 close，
+//                         只有在队列空或满时才通过 atomic::wait（Linux 上为 futex）睡眠
+//
+// try_push / try_pop 从不阻塞，失败时返回 false；T 需要可默认构造、可移动赋值。
+
+#pragma region mpmc_queue
+/**
+ * 每个槽位有一个序号 seq：
+ *      seq == pos          槽位空闲，位置为 pos 的生产者可以写入，写完后置为 pos + 1；
+ *      seq == pos + 1      槽位有数据，位置为 pos 的消费者可以读取，读完后置为 pos + capacity，留给下一圈的生产者。
+ * 生产者与消费者各自只在 enqueuePos / dequeuePos 上 CAS 一次，不同槽位之间互不干扰；
+ * 两个位置计数器各占一个 cache line，避免生产者与消费者之间的伪共享。
+ */
+template <typename T>
+class mpmc_queue
+{
+public:
+    typedef T value_type;
+
+    explicit mpmc_queue(size_t capacity = 1024)
+    {
+        if (capacity < 2 || (capacity & (capacity - 1)))
+            throw std::invalid_argument("mpmc_queue capacity must be a power of two >= 2");
+        mask = capacity - 1;
+        cells.reset(new Cell[capacity]);
+        for (size_t i = 0; i < capacity; i++)
+            cells[i].seq.store(i, std::memory_order_relaxed);
+        enqueuePos->store(0, std::memory_order_relaxed);
+        dequeuePos->store(0, std::memory_order_relaxed);
+    }
+
+    bool try_push(T &&value)
+    {
+        size_t pos = enqueuePos->load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = cells[pos & mask];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos);
+            if (diff == 0)
+            {
+                if (enqueuePos->compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.value = std::move(value);
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false; // 满：这个槽位上一圈的数据还没被取走
+            else
+                pos = enqueuePos->load(std::memory_order_relaxed);
+        }
+    }
+
+    bool try_pop(T &out)
+    {
+        size_t pos = dequeuePos->load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = cells[pos & mask];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos + 1);
+            if (diff == 0)
+            {
+                if (dequeuePos->compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    out = std::move(cell.value);
+                    cell.seq.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false; // 空
+            else
+                pos = dequeuePos->load(std::memory_order_relaxed);
+        }
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    cache_padded<std::atomic<size_t>> enqueuePos;
+    cache_padded<std::atomic<size_t>> dequeuePos;
+};
+#pragma endregion
+
+#pragma region spsc_queue
+/**
+ * tail 只由生产者写，head 只由消费者写，两者都不需要 CAS；
+ * 生产者在自己的 cache line 上缓存一份 head，只有缓存显示队列已满时才去读消费者那一行，消费者对 tail 同理，
+ * 队列不空不满时，双方几乎不会读写对方的 cache line。
+ */
+template <typename T>
+class spsc_queue
+{
+public:
+    typedef T value_type;
+
+    explicit spsc_queue(size_t capacity = 1024)
+    {
+        if (capacity < 2 || (capacity & (capacity - 1)))
+            throw std::invalid_argument("spsc_queue capacity must be a power of two >= 2");
+        mask = capacity - 1;
+        slots.reset(new T[capacity]);
+    }
+
+    bool try_push(T &&value)
+    {
+        size_t tail = producer->tail.load(std::memory_order_relaxed);
+        if (tail - producer->cachedHead > mask)
+        {
+            producer->cachedHead = consumer->head.load(std::memory_order_acquire);
+            if (tail - producer->cachedHead > mask)
+                return false;
+        }
+        slots[tail & mask] = std::move(value);
+        producer->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T &out)
+    {
+        size_t head = consumer->head.load(std::memory_order_relaxed);
+        if (head == consumer->cachedTail)
+        {
+            consumer->cachedTail = producer->tail.load(std::memory_order_acquire);
+            if (head == consumer->cachedTail)
+                return false;
+        }
+        out = std::move(slots[head & mask]);
+        consumer->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    struct Producer
+    {
+        std::atomic<size_t> tail{0};
+        size_t cachedHead = 0;
+    };
+    struct Consumer
+    {
+        std::atomic<size_t> head{0};
+        size_t cachedTail = 0;
+    };
+
+    size_t mask;
+    std::unique_ptr<T[]> slots;
+    cache_padded<Producer> producer;
+    cache_padded<Consumer> consumer;
+};
+#pragma endregion
+
+#pragma region mpsc_queue
+/**
+ * 生产者把新节点 exchange 到 head 上，再把旧 head 的 next 指向它，整个 push 只有一次原子交换；
+ * 消费者从 tail（哨兵）沿 next 取数据。两步之间 next 暂时为空，
+ * 此时消费者会看到“队列为空”，稍后重试即可，这也是该算法不是严格 lock-free 的地方。
+ */
+template <typename T>
+class mpsc_queue
+{
+public:
+    typedef T value_type;
+
+    mpsc_queue()
+    {
+        Node *stub = new Node();
+        head->store(stub, std::memory_order_relaxed);
+        tail = stub;
+    }
+    ~mpsc_queue()
+    {
+        while (Node *n = tail)
+        {
+            tail = n->next.load(std::memory_order_relaxed);
+            delete n;
+        }
+    }
+    mpsc_queue(const mpsc_queue &) = delete;
+    mpsc_queue &operator=(const mpsc_queue &) = delete;
+
+    bool try_push(T &&value)
+    {
+        Node *n = new Node();
+        n->value = std::move(value);
+        Node *prev = head->exchange(n, std::memory_order_acq_rel);
+        prev->next.store(n, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T &out)
+    {
+        Node *next = tail->next.load(std::memory_order_acquire);
+        if (!next)
+            return false;
+        out = std::move(next->value);
+        delete tail; // next 成为新的哨兵
+        tail = next;
+        return true;
+    }
+
+private:
+    struct Node
+    {
+        std::atomic<Node *> next{nullptr};
+        T value;
+    };
+
+    cache_padded<std::atomic<Node *>> head; // 生产者
+    alignas(CACHE_LINE) Node *tail;         // 消费者
+};
+#pragma endregion
+
+#pragma region blocking_queue
+/**
+ * 事件计数（eventcount）：
+ *      等待方先读 epoch，再登记 waiters，然后重试一次 try_*，仍然失败才 wait(epoch)；
+ *      通知方在 try_* 成功后，只有看到 waiters > 0 时才把 waiters 清零、递增 epoch 并 notify，
+ *      队列不空不满时 push / pop 不涉及任何系统调用，也没有额外的原子读改写。
+ * 两边都用 seq_cst 保证“登记 waiters / 重试”与“写入数据 / 读取 waiters”不会同时错过对方。
+ * waiters 由通知方清零而不是由等待方醒来后递减：被唤醒的线程真正运行之前（单核上尤其明显），
+ * 后续的 push 不会因为 waiters 仍大于 0 而重复进入 futex；重试成功的等待方不递减，最多导致一次多余的 notify。
+ *
+ * close() 之后 push 返回 false，pop 立即返回 false（与 ThreadPool 停止时的行为一致，未执行的任务被丢弃）。
+ */
+template <typename Q>
+class blocking_queue
+{
+public:
+    template <typename... Args>
+    explicit blocking_queue(Args &&...args) : queue(std::forward<Args>(args)...) {}
+
+    typedef typename Q::value_type value_type;
+
+    // 满时阻塞；队列已关闭时返回 false。左值被拷贝，不会被移走
+    template <typename T>
+    bool push(T &&value)
+    {
+        if constexpr (is_element<T>::value)
+            return pushItem(value);
+        else
+        {
+            value_type item(std::forward<T>(value)); // 只转换一次，重试时不会反复移走同一个参数
+            return pushItem(item);
+        }
+    }
+
+    // 空时阻塞；队列已关闭时返回 false
+    template <typename T>
+    bool pop(T &out)
+    {
+        if (closed.load(std::memory_order_acquire) || !block(notEmpty, [&]()
+                                                             { return queue.try_pop(out); }))
+            return false;
+        wake(notFull);
+        return true;
+    }
+
+    // 失败时右值参数保持原样，调用方可以重试
+    template <typename T>
+    bool try_push(T &&value)
+    {
+        bool ok;
+        if constexpr (is_element<T>::value)
+            ok = queue.try_push(std::move(value));
+        else
+            ok = queue.try_push(value_type(std::forward<T>(value)));
+        if (!ok)
+            return false;
+        wake(notEmpty);
+        return true;
+    }
+
+    template <typename T>
+    bool try_pop(T &out)
+    {
+        if (!queue.try_pop(out))
+            return false;
+        wake(notFull);
+        return true;
+    }
+
+    void close()
+    {
+        closed.store(true, std::memory_order_seq_cst);
+        for (Event *e : {&notEmpty, &notFull})
+        {
+            e->epoch->fetch_add(1, std::memory_order_release);
+            e->epoch->notify_all();
+        }
+    }
+
+    bool is_closed() const { return closed.load(std::memory_order_acquire); }
+
+private:
+    // 元素类型的右值：底层队列只在成功时才移走，可以直接交给它
+    template <typename T>
+    struct is_element : std::bool_constant<!std::is_lvalue_reference<T>::value &&
+                                           std::is_same<T, value_type>::value>
+    {
+    };
+
+    bool pushItem(value_type &item)
+    {
+        if (closed.load(std::memory_order_acquire) || !block(notFull, [&]()
+                                                             { return queue.try_push(std::move(item)); }))
+            return false;
+        wake(notEmpty);
+        return true;
+    }
+
+    struct Event
+    {
+        cache_padded<std::atomic<uint32_t>> epoch{0u};
+        cache_padded<std::atomic<uint32_t>> waiters{0u};
+    };
+
+    static constexpr int SPINS = 64;
+
+    void wake(Event &e)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (e.waiters->load(std::memory_order_relaxed) && e.waiters->exchange(0, std::memory_order_seq_cst))
+        {
+            e.epoch->fetch_add(1, std::memory_order_release);
+            e.epoch->notify_all();
+        }
+    }
+
+    // 反复尝试 op，先自旋，再在 e 上睡眠；op 成功返回 true，队列关闭返回 false
+    template <typename Op>
+    bool block(Event &e, Op op)
+    {
+        for (int spin = 0;; spin++)
+        {
+            if (op())
+                return true;
+            if (closed.load(std::memory_order_acquire))
+                return false;
+            if (spin < SPINS)
+            {
+                __builtin_ia32_pause();
+                continue;
+            }
+            uint32_t epoch = e.epoch->load(std::memory_order_acquire);
+            e.waiters->fetch_add(1, std::memory_order_seq_cst);
+            if (op())
+                return true;
+            if (!closed.load(std::memory_order_seq_cst))
+                e.epoch->wait(epoch, std::memory_order_acquire);
+        }
+    }
+
+    Q queue;
+    Event notEmpty, notFull;
+    std::atomic<bool> closed{false};
+};
+#pragma endregion
+
+// 可以直接作为 BasicThreadPool 的任务队列：BasicThreadPool<SharedTaskAlloc, LockFreeTaskQueue>
+// 队列有界（默认 1024），满时 enqueue 会阻塞，在任务中向同一个线程池提交大量任务时要注意
+template <typename Task>
+using LockFreeTaskQueue = blocking_queue<mpmc_queue<Task>>;
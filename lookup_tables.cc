@@ -0,0 +1,154 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "lookup_tables.h"
+using namespace std;
+
+// 编译期生成的查找表与运行期初始化的查找表：所在段、启动开销与单次调用开销
+// 编译：g++ -std=c++17 -O2 lookup_tables.cc -o lookup_tables
+// 查看所在段：objdump -t lookup_tables | c++filt | grep -E "CRC32|POPCOUNT"
+
+// GNU ld 提供的段边界：.rodata 在 etext 与 edata 之间（.data 之前），.bss 在 edata 与 _end 之间
+extern "C" char etext, edata, _end;
+
+static const char *section(const void *p)
+{
+    const char *c = static_cast<const char *>(p);
+    if (c >= &etext && c < &edata)
+        return "rodata/data";
+    if (c >= &edata && c < &_end)
+        return "bss";
+    return "other";
+}
+
+#pragma region 运行期初始化的同一组表
+namespace runtime
+{
+    lookup::crc_tables crc32Tables, crc32cTables;
+    array<uint8_t, 256> popcount8;
+    array<array<uint64_t, 256>, 8> tabulation;
+    array<uint64_t, lookup::LATENCY_BUCKETS> latencyBounds;
+
+    // 与 lookup_tables.h 中的生成代码相同，只是放到了 main 之后执行
+    void init()
+    {
+        for (auto pair : {make_pair(&crc32Tables, 0xEDB88320u), make_pair(&crc32cTables, 0x82F63B78u)})
+        {
+            lookup::crc_tables &t = *pair.first;
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                uint32_t c = i;
+                for (int bit = 0; bit < 8; bit++)
+                    c = (c >> 1) ^ (c & 1 ? pair.second : 0);
+                t[0][i] = c;
+            }
+            for (size_t k = 1; k < lookup::CRC_SLICES; k++)
+                for (uint32_t i = 0; i < 256; i++)
+                    t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+        }
+        for (size_t i = 0; i < 256; i++)
+            popcount8[i] = __builtin_popcount(i);
+        uint64_t seed = 0x5EED;
+        for (auto &row : tabulation)
+            for (auto &v : row)
+                v = lookup::splitmix64(seed);
+        latencyBounds = lookup::make_latency_bounds();
+    }
+}
+#pragma endregion
+
+// 逐位计算的 CRC32，不用表
+static uint32_t crc32Bitwise(const void *data, size_t len)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    uint32_t crc = ~0u;
+    while (len--)
+    {
+        crc ^= *p++;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320u : 0);
+    }
+    return ~crc;
+}
+
+static volatile uint64_t sink;
+
+template <typename F>
+double timeIt(F f)
+{
+    auto begin = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count();
+}
+
+int main(int argc, char const *argv[])
+{
+    double initNs = timeIt(runtime::init);
+
+    cout << "CRC32_TABLES  " << sizeof(lookup::CRC32_TABLES) << " B in " << section(&lookup::CRC32_TABLES)
+         << ", runtime copy in " << section(&runtime::crc32Tables) << endl;
+    cout << "TABULATION    " << sizeof(lookup::TABULATION_TABLE) << " B in " << section(&lookup::TABULATION_TABLE)
+         << ", runtime copy in " << section(&runtime::tabulation) << endl;
+    cout << "runtime init of all tables: " << initNs / 1000 << " us, constexpr tables: 0 us" << endl;
+    cout << "tables identical: "
+         << (runtime::crc32Tables == lookup::CRC32_TABLES && runtime::crc32cTables == lookup::CRC32C_TABLES &&
+                     runtime::tabulation == lookup::TABULATION_TABLE && runtime::latencyBounds == lookup::LATENCY_BOUNDS
+                 ? "yes"
+                 : "NO")
+         << endl;
+
+    const char *check = "123456789";
+    cout << hex << "crc32(\"123456789\") = " << lookup::crc32(check, 9) << " (expect cbf43926), crc32c = "
+         << lookup::crc32c(check, 9) << " (expect e3069283)" << dec << endl;
+
+    // 单次调用开销
+    vector<uint8_t> buf(1 << 16);
+    mt19937_64 rng(3);
+    for (auto &b : buf)
+        b = rng();
+    const int rounds = 200;
+    double bitwise = timeIt([&]()
+                            { for (int r = 0; r < rounds / 10; r++) sink = crc32Bitwise(buf.data(), buf.size()); }) /
+                     (rounds / 10);
+    double constTables = timeIt([&]()
+                                { for (int r = 0; r < rounds; r++) sink = lookup::crc32(buf.data(), buf.size()); }) /
+                         rounds;
+    double runtimeTables = timeIt([&]()
+                                  { for (int r = 0; r < rounds; r++) sink = lookup::crc_update(runtime::crc32Tables, 0, buf.data(), buf.size()); }) /
+                           rounds;
+    auto gbps = [&](double ns)
+    { return buf.size() / ns; };
+    cout << "crc32 64KB: bitwise " << gbps(bitwise) << " GB/s, slicing-by-" << lookup::CRC_SLICES << " constexpr "
+         << gbps(constTables) << " GB/s, runtime tables " << gbps(runtimeTables) << " GB/s" << endl;
+
+    const long n = 20000000;
+    vector<uint64_t> values(4096);
+    for (auto &v : values)
+        v = rng() >> (rng() % 64);
+    double tab = timeIt([&]()
+                        { uint64_t h = 0; for (long i = 0; i < n; i++) h += lookup::tabulation_hash(values[i & 4095] + i); sink = h; }) /
+                 n;
+    double pop = timeIt([&]()
+                        { uint64_t h = 0; for (long i = 0; i < n; i++) h += lookup::popcount64(values[i & 4095] + i); sink = h; }) /
+                 n;
+    double popBuiltin = timeIt([&]()
+                               { uint64_t h = 0; for (long i = 0; i < n; i++) h += __builtin_popcountll(values[i & 4095] + i); sink = h; }) /
+                        n;
+    double bucket = timeIt([&]()
+                           { uint64_t h = 0; for (long i = 0; i < n; i++) h += lookup::latency_bucket(values[i & 4095] + i); sink = h; }) /
+                    n;
+    cout << "tabulation_hash " << tab << " ns, popcount64 table " << pop << " ns (builtin " << popBuiltin
+         << " ns), latency_bucket " << bucket << " ns" << endl;
+
+    // 延迟直方图：桶的下界直接查 .rodata 中的表
+    vector<long> histogram(lookup::LATENCY_BUCKETS);
+    exponential_distribution<double> latency(1.0 / 20000);
+    for (int i = 0; i < 100000; i++)
+        histogram[lookup::latency_bucket(uint64_t(latency(rng)))]++;
+    cout << "latency histogram (ns, >= lower bound):" << endl;
+    for (size_t b = 0; b < histogram.size(); b++)
+        if (histogram[b] > 1000)
+            cout << "  " << lookup::LATENCY_BOUNDS[b] << "\t" << histogram[b] << endl;
+    return 0;
+}
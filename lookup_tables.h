@@ -0,0 +1,219 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/** 编译期生成的查找表
+ *
+ * const_value.cc 中的 static const 变量放在 .rodata；这里把整张查找表也放进去：
+ *      表由 constexpr 函数在编译期算好，作为 inline constexpr 变量只在可执行文件中出现一次，
+ *      启动时不需要初始化代码，也不存在多线程首次初始化的问题；
+ *      .rodata 页面直接映射自可执行文件，是只读的干净页，同一程序的多个进程共享同一份物理内存（page cache），
+ *      运行期填充的表在 .bss 中，每个进程各自一份，并且在写入时才分配物理页。
+ *
+ *      crc32 / crc32c      反射多项式 0xEDB88320 / 0x82F63B78，slicing-by-N，每次迭代处理 N 个字节
+ *      tabulation_hash     8 x 256 个 64 位随机数，编译期由 splitmix64 生成
+ *      popcount8 / reverse8  单字节的 1 的个数与位翻转
+ *      latency_bucket      延迟直方图的分桶：按 log2 分段，每段再等分 2^LATENCY_SUB_BITS 份
+ */
+
+// 编译期配置，可以用 -D 覆盖
+#ifndef LOOKUP_CRC_SLICES
+#define LOOKUP_CRC_SLICES 8
+#endif
+#ifndef LOOKUP_LATENCY_SUB_BITS
+#define LOOKUP_LATENCY_SUB_BITS 2
+#endif
+
+static_assert(LOOKUP_CRC_SLICES == 1 || LOOKUP_CRC_SLICES == 4 || LOOKUP_CRC_SLICES == 8,
+              "LOOKUP_CRC_SLICES must be 1, 4 or 8");
+static_assert(LOOKUP_LATENCY_SUB_BITS >= 0 && LOOKUP_LATENCY_SUB_BITS <= 4, "LOOKUP_LATENCY_SUB_BITS out of range");
+
+namespace lookup
+{
+#pragma region 通用生成器
+    // table[i] = f(i)
+    template <typename T, size_t N, typename F>
+    constexpr std::array<T, N> make_table(F f)
+    {
+        std::array<T, N> table{};
+        for (size_t i = 0; i < N; i++)
+            table[i] = f(i);
+        return table;
+    }
+#pragma endregion
+
+#pragma region CRC32
+    constexpr size_t CRC_SLICES = LOOKUP_CRC_SLICES;
+    typedef std::array<std::array<uint32_t, 256>, CRC_SLICES> crc_tables;
+
+    // tables[0] 是标准的逐字节表，tables[k][i] 等于 i 后面再跟 k 个 0 字节时的 CRC
+    constexpr crc_tables make_crc_tables(uint32_t poly)
+    {
+        crc_tables tables{};
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; bit++)
+                c = (c >> 1) ^ (c & 1 ? poly : 0);
+            tables[0][i] = c;
+        }
+        for (size_t k = 1; k < CRC_SLICES; k++)
+            for (uint32_t i = 0; i < 256; i++)
+                tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xff];
+        return tables;
+    }
+
+    inline constexpr crc_tables CRC32_TABLES = make_crc_tables(0xEDB88320u);
+    inline constexpr crc_tables CRC32C_TABLES = make_crc_tables(0x82F63B78u);
+
+    // 小端机器上的 slicing-by-N，crc 为上一段数据的结果，可以分段计算
+    inline uint32_t crc_update(const crc_tables &t, uint32_t crc, const void *data, size_t len)
+    {
+        const uint8_t *p = static_cast<const uint8_t *>(data);
+        crc = ~crc;
+        if constexpr (CRC_SLICES >= 4)
+        {
+            for (; len >= CRC_SLICES; len -= CRC_SLICES, p += CRC_SLICES)
+            {
+                uint32_t x = crc ^ (p[0] | p[1] << 8 | p[2] << 16 | uint32_t(p[3]) << 24);
+                uint32_t c = t[CRC_SLICES - 1][x & 0xff] ^ t[CRC_SLICES - 2][(x >> 8) & 0xff] ^
+                             t[CRC_SLICES - 3][(x >> 16) & 0xff] ^ t[CRC_SLICES - 4][x >> 24];
+                if constexpr (CRC_SLICES == 8)
+                    c ^= t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+                crc = c;
+            }
+        }
+        for (; len; len--, p++)
+            crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+        return ~crc;
+    }
+
+    inline uint32_t crc32(const void *data, size_t len, uint32_t crc = 0) { return crc_update(CRC32_TABLES, crc, data, len); }
+    inline uint32_t crc32c(const void *data, size_t len, uint32_t crc = 0) { return crc_update(CRC32C_TABLES, crc, data, len); }
+
+    // 编译期自检：与公开的逐字节表对照
+    static_assert(CRC32_TABLES[0][1] == 0x77073096u, "crc32 table");
+    static_assert(CRC32C_TABLES[0][1] == 0xF26B8303u, "crc32c table");
+#pragma endregion
+
+#pragma region tabulation hash
+    constexpr uint64_t splitmix64(uint64_t &state)
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    constexpr std::array<std::array<uint64_t, 256>, 8> make_tabulation_table(uint64_t seed)
+    {
+        std::array<std::array<uint64_t, 256>, 8> table{};
+        for (auto &row : table)
+            for (auto &v : row)
+                v = splitmix64(seed);
+        return table;
+    }
+
+    // 简单表格哈希：每个字节查一次表后异或，3-独立，适合对整数 key 做哈希
+    inline constexpr auto TABULATION_TABLE = make_tabulation_table(0x5EED);
+
+    constexpr uint64_t tabulation_hash(uint64_t x)
+    {
+        uint64_t h = 0;
+        for (int i = 0; i < 8; i++, x >>= 8)
+            h ^= TABULATION_TABLE[i][x & 0xff];
+        return h;
+    }
+#pragma endregion
+
+#pragma region 位运算
+    inline constexpr auto POPCOUNT8 = make_table<uint8_t, 256>([](size_t i)
+                                                               {
+        uint8_t n = 0;
+        for (; i; i &= i - 1)
+            n++;
+        return n; });
+
+    inline constexpr auto REVERSE8 = make_table<uint8_t, 256>([](size_t i)
+                                                              {
+        uint8_t r = 0;
+        for (int bit = 0; bit < 8; bit++)
+            r |= ((i >> bit) & 1) << (7 - bit);
+        return r; });
+
+    // floor(log2(i))，LOG2_8[0] 没有意义，记为 0
+    inline constexpr auto LOG2_8 = make_table<uint8_t, 256>([](size_t i)
+                                                            {
+        uint8_t n = 0;
+        while (i >>= 1)
+            n++;
+        return n; });
+
+    constexpr int popcount64(uint64_t x)
+    {
+        int n = 0;
+        for (int i = 0; i < 8; i++, x >>= 8)
+            n += POPCOUNT8[x & 0xff];
+        return n;
+    }
+
+    constexpr uint32_t reverse32(uint32_t x)
+    {
+        return uint32_t(REVERSE8[x & 0xff]) << 24 | uint32_t(REVERSE8[(x >> 8) & 0xff]) << 16 |
+               uint32_t(REVERSE8[(x >> 16) & 0xff]) << 8 | REVERSE8[x >> 24];
+    }
+
+    constexpr int log2_64(uint64_t x)
+    {
+        int shift = 0;
+        if (x >> 32)
+            x >>= 32, shift += 32;
+        if (x >> 16)
+            x >>= 16, shift += 16;
+        if (x >> 8)
+            x >>= 8, shift += 8;
+        return shift + LOG2_8[x];
+    }
+
+    static_assert(popcount64(0xFF00FF00FF00FF01ull) == 33, "popcount");
+    static_assert(reverse32(1) == 0x80000000u, "reverse");
+    static_assert(log2_64(1ull << 40 | 12345) == 40, "log2");
+#pragma endregion
+
+#pragma region 延迟直方图分桶
+    /**
+     * 与 HdrHistogram 类似：[2^k, 2^(k+1)) 这一段再等分为 2^SUB_BITS 个子桶，
+     * 相对误差不超过 1 / 2^SUB_BITS；小于 2^SUB_BITS 的值每个值一个桶。
+     * 每个桶的下界在编译期算好，打印直方图时直接查表。
+     */
+    constexpr int LATENCY_SUB_BITS = LOOKUP_LATENCY_SUB_BITS;
+    constexpr size_t LATENCY_BUCKETS = (64 - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS;
+
+    constexpr size_t latency_bucket(uint64_t v)
+    {
+        if (v < (1ull << LATENCY_SUB_BITS))
+            return v;
+        int k = log2_64(v);
+        uint64_t sub = (v >> (k - LATENCY_SUB_BITS)) & ((1ull << LATENCY_SUB_BITS) - 1);
+        return (size_t(k - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) + sub;
+    }
+
+    constexpr std::array<uint64_t, LATENCY_BUCKETS> make_latency_bounds()
+    {
+        std::array<uint64_t, LATENCY_BUCKETS> bounds{};
+        for (size_t b = 0; b < LATENCY_BUCKETS; b++)
+        {
+            size_t group = b >> LATENCY_SUB_BITS, sub = b & ((1u << LATENCY_SUB_BITS) - 1);
+            bounds[b] = group == 0 ? sub : (uint64_t(1) << (group + LATENCY_SUB_BITS - 1)) | (uint64_t(sub) << (group - 1));
+        }
+        return bounds;
+    }
+
+    // 每个桶的下界
+    inline constexpr auto LATENCY_BOUNDS = make_latency_bounds();
+
+    static_assert(latency_bucket(LATENCY_BOUNDS[37]) == 37, "latency bucket bounds");
+    static_assert(latency_bucket(~0ull) == LATENCY_BUCKETS - 1, "latency bucket range");
+#pragma endregion
+} // namespace lookup
@@ -0,0 +1,259 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * 可选的第二层（预热快照见 lru_snapshot.h）。除 load 外都在持有缓存锁时调用，应当很快：
+ *      load        内存未命中时在锁外调用，返回空表示第二层也没有；
+ *      invalidate  put 覆盖或新增 key 时调用，第二层中该 key 的旧值从此失效；
+ *      evicted     put 淘汰表尾时调用。
+ */
+template <typename K, typename Ptr>
+class LRU_Tier
+{
+public:
+    virtual ~LRU_Tier() {}
+    virtual Ptr load(const K &key) = 0;
+    virtual void invalidate(const K &) {}
+    virtual void evicted(const K &, const Ptr &) {}
+};
+
+// 只被一个线程访问的缓存用它代替 std::mutex，加锁全部编译为空（见 cache_node.h 中每个 I/O 线程独占的分片）
+struct null_mutex
+{
+    void lock() {}
+    bool try_lock() { return true; }
+    void unlock() {}
+};
+
+// Ptr 为 value 的持有方式，默认 shared_ptr<V>，也可以换成 intrusive_ptr / pool_shared_ptr（见 pool_ptr.h）
+// Alloc 用于链表与哈希表的节点，例如放进大页（见 huge_arena.h 的 huge_page_allocator）
+template <typename K, typename V, typename Ptr = std::shared_ptr<V>, typename Mutex = std::mutex,
+          typename Alloc = std::allocator<std::pair<K, Ptr>>>
+class LRU_Cache
+{
+public:
+    typedef std::pair<K, Ptr> node;
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<node> list_allocator;
+    typedef typename std::list<node, list_allocator>::iterator iterator;
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<std::pair<const K, iterator>> map_allocator;
+    typedef LRU_Tier<K, Ptr> tier_type;
+    LRU_Cache(int cap, const Alloc &alloc = Alloc())
+        : capacity(cap), lru_list(list_allocator(alloc)), lru_map(0, std::hash<K>(), std::equal_to<K>(), map_allocator(alloc)) {}
+    Ptr get(K key)
+    {
+        std::unique_lock<Mutex> guard(mutex_t);
+        auto ite = lru_map.find(key);
+        if (ite == lru_map.end())
+        {
+            if (!tier)
+                return Ptr(nullptr);
+            return load(key, guard);
+        }
+        // 原地把节点移到表头：先 erase 再拷贝 *ite->second 会读到已释放的节点，splice 也省掉一次节点分配
+        moving(ite->second, false);
+        lru_list.splice(lru_list.begin(), lru_list, ite->second);
+        return ite->second->second;
+    }
+    void put(K key, Ptr val)
+    {
+        std::lock_guard<Mutex> guard(mutex_t);
+        auto ite = lru_map.find(key);
+        if (ite != lru_map.end())
+        {
+            moving(ite->second, true);
+            lru_list.erase(ite->second);
+        }
+        if (tier)
+        {
+            tier->invalidate(key);
+            written(key);
+        }
+        lru_list.emplace_front(key, val);
+        lru_map[key] = lru_list.begin();
+        if (lru_list.size() > (size_t)capacity)
+        {
+            if (tier)
+                tier->evicted(lru_list.back().first, lru_list.back().second);
+            moving(std::prev(lru_list.end()), true);
+            lru_map.erase(lru_list.back().first);
+            lru_list.pop_back();
+        }
+    }
+
+    // 删除 key，不存在返回 false
+    bool erase(K key)
+    {
+        std::lock_guard<Mutex> guard(mutex_t);
+        if (tier)
+        {
+            tier->invalidate(key);
+            written(key);
+        }
+        auto ite = lru_map.find(key);
+        if (ite == lru_map.end())
+            return false;
+        moving(ite->second, true);
+        lru_list.erase(ite->second);
+        lru_map.erase(ite);
+        return true;
+    }
+
+    // 把 key 放到表尾（最久未使用的一端），已存在则跳过；缓存已满返回 false。用于按原来的冷热顺序预热
+    bool append(K key, Ptr val)
+    {
+        std::lock_guard<Mutex> guard(mutex_t);
+        if (lru_list.size() >= (size_t)capacity)
+            return false;
+        if (lru_map.find(key) == lru_map.end())
+        {
+            lru_list.emplace_back(key, val);
+            lru_map[key] = std::prev(lru_list.end());
+        }
+        return true;
+    }
+
+    /**
+     * 按从新到旧的顺序拷贝所有条目（只拷贝 key 与 Ptr）。每次持锁只拷贝 chunk 个，之间 get / put 照常进行，
+     * 阻塞它们的时间与缓存大小无关；maxHoldMs 非空时写入单次持锁的最长时间。
+     *
+     * 从表尾向表头扫描，游标指向下一个要拷贝的节点；get / put / erase 移动或删除游标所在的节点之前先把游标移到前一个，
+     * 所以扫描期间新增或被访问的条目（移到了表头，仍在未拷贝的一侧）都会被拷贝到。已拷贝过又被访问的条目会拷贝两次，
+     * 保留后一次（更靠近表头的位置）。扫描期间 append 到表尾的条目不包括在内；先拷贝、后来被淘汰的条目仍在结果中，
+     * 它们都在最旧的一端，超过容量的部分截掉。同一时刻只进行一个扫描。
+     */
+    std::vector<node> entries(size_t chunk = 4096, double *maxHoldMs = nullptr)
+    {
+        std::lock_guard<Mutex> scan(scan_mutex);
+        {
+            std::lock_guard<Mutex> guard(mutex_t);
+            scanning = true;
+            cursor = lru_list.empty() ? lru_list.end() : std::prev(lru_list.end());
+        }
+        // 每段的内存在锁外分配，持锁期间只拷贝节点
+        std::vector<std::vector<node>> parts;
+        double maxHold = 0;
+        for (bool done = false; !done;)
+        {
+            std::vector<node> part;
+            part.reserve(std::max<size_t>(chunk, 1));
+            std::lock_guard<Mutex> guard(mutex_t);
+            auto t0 = std::chrono::steady_clock::now();
+            while (part.size() < part.capacity() && cursor != lru_list.end())
+            {
+                part.push_back(*cursor);
+                cursor = cursor == lru_list.begin() ? lru_list.end() : std::prev(cursor);
+            }
+            done = cursor == lru_list.end();
+            scanning = !done;
+            maxHold = std::max(maxHold, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+            parts.push_back(std::move(part));
+        }
+        if (maxHoldMs)
+            *maxHoldMs = maxHold;
+
+        // 后拷贝的在前，同一个 key 只保留第一次出现
+        std::vector<node> out;
+        std::unordered_set<K> seen;
+        for (auto part = parts.rbegin(); part != parts.rend(); ++part)
+            for (auto e = part->rbegin(); e != part->rend(); ++e)
+                if (out.size() < (size_t)capacity && seen.insert(e->first).second)
+                    out.push_back(std::move(*e));
+        return out;
+    }
+
+    void set_tier(std::shared_ptr<tier_type> t)
+    {
+        std::lock_guard<Mutex> guard(mutex_t);
+        tier = std::move(t);
+    }
+
+    size_t size()
+    {
+        std::lock_guard<Mutex> guard(mutex_t);
+        return lru_list.size();
+    }
+
+private:
+    // 正在锁外 load 的 key：并发 load 的个数，以及期间对它的 put / erase 次数
+    struct Loading
+    {
+        int loaders = 0;
+        uint64_t writes = 0;
+    };
+
+    void written(const K &key)
+    {
+        if (loading.empty())
+            return;
+        auto ite = loading.find(key);
+        if (ite != loading.end())
+            ite->second.writes++;
+    }
+
+    // 节点 it 被移到表头（removing 为 false）或删除之前调用，让扫描游标继续指向尚未拷贝的部分
+    void moving(iterator it, bool removing)
+    {
+        if (!scanning || it != cursor)
+            return;
+        if (cursor != lru_list.begin())
+            --cursor;
+        else if (removing)
+            cursor = lru_list.end();
+    }
+
+    // 未命中时在锁外查第二层；期间如果有同一个 key 的 put / erase，第二层读到的值可能已经过期，丢弃它。
+    // 只跟踪正在 load 的 key，其他 key 的写不影响
+    Ptr load(const K &key, std::unique_lock<Mutex> &guard)
+    {
+        std::shared_ptr<tier_type> t = tier;
+        Loading &mine = loading[key];
+        mine.loaders++;
+        uint64_t seen = mine.writes;
+        guard.unlock();
+        Ptr val = t->load(key);
+        guard.lock();
+        auto entry = loading.find(key); // 期间 loading 可能重新哈希，不能用 mine
+        bool stale = entry->second.writes != seen;
+        if (--entry->second.loaders == 0)
+            loading.erase(entry);
+        auto ite = lru_map.find(key);
+        if (ite != lru_map.end())
+        {
+            moving(ite->second, false);
+            lru_list.splice(lru_list.begin(), lru_list, ite->second);
+            return ite->second->second;
+        }
+        if (!val || stale)
+            return Ptr(nullptr);
+        lru_list.emplace_front(key, val);
+        lru_map[key] = lru_list.begin();
+        if (lru_list.size() > (size_t)capacity)
+        {
+            if (tier)
+                tier->evicted(lru_list.back().first, lru_list.back().second);
+            moving(std::prev(lru_list.end()), true);
+            lru_map.erase(lru_list.back().first);
+            lru_list.pop_back();
+        }
+        return val;
+    }
+
+    int capacity;
+    Mutex mutex_t;
+    std::list<node, list_allocator> lru_list;
+    std::unordered_map<K, iterator, std::hash<K>, std::equal_to<K>, map_allocator> lru_map;
+    std::shared_ptr<tier_type> tier;
+    std::unordered_map<K, Loading> loading;
+    // entries() 的扫描状态，由 mutex_t 保护
+    Mutex scan_mutex;
+    bool scanning = false;
+    iterator cursor;
+};
@@ -0,0 +1,167 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "lru_snapshot.h"
+using namespace std;
+
+// LRU_Cache 的快照与重启后的预热：保存耗时与持锁时间、恢复耗时、重启后的命中率曲线
+// 编译：g++ -std=c++17 -O2 -pthread lru_snapshot.cc -o lru_snapshot
+
+typedef LRU_Cache<uint64_t, string> Cache;
+typedef LRU_Snapshot<uint64_t, string> Snapshot;
+
+static const uint64_t KEYS = 2000000;
+static const int CAPACITY = 200000;
+static const char *PATH = "/tmp/lru_snapshot.bin";
+
+static double elapsedMs(chrono::steady_clock::time_point t0)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+// 长尾分布：key = KEYS * u^4，小 key 远比大 key 热
+static vector<uint64_t> workload(size_t n, uint64_t seed)
+{
+    mt19937_64 rng(seed);
+    uniform_real_distribution<double> u(0, 1);
+    vector<uint64_t> keys(n);
+    for (auto &k : keys)
+        k = uint64_t(KEYS * pow(u(rng), 4));
+    return keys;
+}
+
+// 模拟回源：每个 value 约 100 字节
+static shared_ptr<string> fetch(uint64_t key)
+{
+    return make_shared<string>("value-" + to_string(key) + string(90, 'x'));
+}
+
+// 未命中时回源并 put，返回是否命中
+static bool request(Cache &cache, uint64_t key)
+{
+    if (cache.get(key))
+        return true;
+    cache.put(key, fetch(key));
+    return false;
+}
+
+int main()
+{
+    // 第一次运行：跑到稳态后在后台保存快照，同时继续服务请求
+    double steady;
+    {
+        Cache cache(CAPACITY);
+        vector<uint64_t> keys = workload(3000000, 1);
+        long hits = 0;
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            bool hit = request(cache, keys[i]);
+            if (i >= keys.size() - 1000000)
+                hits += hit;
+        }
+        steady = hits / 1e6;
+
+        // 请求先生成好，保存开始后立即发请求，才能覆盖持锁拷贝的时段
+        vector<uint64_t> more = workload(1 << 20, 2);
+        auto future = Snapshot::save_async(cache, PATH);
+        long served = 0;
+        double worstUs = 0;
+        while (future.wait_for(chrono::seconds(0)) != future_status::ready)
+        {
+            auto t0 = chrono::steady_clock::now();
+            request(cache, more[served++ & (more.size() - 1)]);
+            worstUs = max(worstUs, elapsedMs(t0) * 1000);
+        }
+        Snapshot::SaveStats stats = future.get();
+        cout << "steady-state hit rate " << fixed << setprecision(3) << steady << endl;
+        cout << "snapshot: " << stats.entries << " entries, " << stats.bytes / 1024 << " KB, copied in "
+             << setprecision(2) << stats.copyMs << " ms (lock held at most " << stats.lockMs << " ms at a time), total "
+             << stats.totalMs << " ms" << endl;
+        cout << "  served " << served << " requests during snapshot, worst latency " << setprecision(0) << worstUs
+             << " us" << endl;
+    }
+
+    // 模拟重启：冷启动；只挂快照，未命中时懒加载（快照一直作为第二层，命中包括从快照读出的）；
+    // 后台按冷热顺序预热，完成后摘掉快照，只剩内存中的条目
+    vector<uint64_t> keys = workload(1000000, 3);
+    const size_t WINDOW = 50000;
+    struct Run
+    {
+        const char *name;
+        vector<double> curve;
+        double restoreMs = 0, firstHitMs = -1, warmMs = 0;
+        size_t warmed = 0;
+    };
+    vector<Run> runs = {{"cold"}, {"lazy"}, {"warm"}};
+    for (size_t r = 0; r < runs.size(); r++)
+    {
+        Run &run = runs[r];
+        Cache cache(CAPACITY);
+        auto start = chrono::steady_clock::now();
+        shared_ptr<Snapshot> snapshot;
+        thread warmer;
+        if (r > 0)
+        {
+            snapshot = Snapshot::restore(cache, PATH);
+            run.restoreMs = elapsedMs(start);
+            if (!snapshot)
+            {
+                cout << "restore failed" << endl;
+                return 1;
+            }
+            if (r == 2)
+                warmer = thread([&]()
+                                {
+                                    run.warmed = snapshot->warm(cache);
+                                    cache.set_tier(nullptr);
+                                    run.warmMs = elapsedMs(start); });
+        }
+        long hits = 0;
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            bool hit = request(cache, keys[i]);
+            if (hit && run.firstHitMs < 0)
+                run.firstHitMs = elapsedMs(start);
+            hits += hit;
+            if ((i + 1) % WINDOW == 0)
+            {
+                run.curve.push_back(double(hits) / WINDOW);
+                hits = 0;
+            }
+        }
+        if (warmer.joinable())
+            warmer.join();
+    }
+
+    cout << endl
+         << "after restart" << setprecision(2) << endl;
+    for (auto &run : runs)
+    {
+        cout << "  " << left << setw(6) << run.name << right << " restore " << setw(6) << run.restoreMs
+             << " ms, first hit at " << setw(8) << run.firstHitMs << " ms";
+        if (run.warmed)
+            cout << ", warmed " << run.warmed << " entries in " << run.warmMs << " ms";
+        cout << endl;
+    }
+    cout << endl
+         << "hit rate per " << WINDOW << " requests" << endl
+         << setw(10) << "requests";
+    for (auto &run : runs)
+        cout << setw(10) << run.name;
+    cout << endl;
+    for (size_t w = 0; w < runs[0].curve.size(); w++)
+    {
+        cout << setw(10) << (w + 1) * WINDOW << setprecision(3);
+        for (auto &run : runs)
+            cout << setw(10) << run.curve[w];
+        cout << endl;
+    }
+    unlink(PATH);
+    return 0;
+}
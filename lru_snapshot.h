@@ -0,0 +1,327 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "lookup_tables.h"
+#include "lru_cache.h"
+
+/** LRU_Cache 的预热快照，用法与基准见 lru_snapshot.cc
+ *
+ * 保存：entries() 分段持锁，每段只拷贝 key 与 Ptr（引用计数 +1），编码与写文件都在锁外，写到 path.tmp 后 fsync + rename 原子替换。
+ * 恢复：mmap 只读映射文件，校验文件头即可使用，与条目数无关；快照作为 LRU_Cache 的第二层（LRU_Tier）挂上去，
+ *       内存未命中时按 key 查文件中的哈希表，解码 value 放进缓存，进程启动后立即就能命中；
+ *       可以再用 warm() 在后台按原来从新到旧的顺序把条目追加到表尾，直到缓存填满。
+ * 恢复之后 put 过的 key 在快照中标记为失效，不会再从快照中读出旧值。
+ *
+ * 文件格式（小端，偏移都是从文件开头算起）：
+ *      Header
+ *      记录 × count      u32 keyLen, u32 valueLen, key 字节, value 字节，按从新到旧的顺序
+ *      Slot × slots      开放寻址哈希表（线性探测，装载率 <= 1/2），hash 为 key 编码的 crc32c，offset 为 0 表示空槽
+ */
+
+// 编解码：平凡可复制的类型按字节拷贝，std::string 直接存字节，其他类型需要特化 lru_codec
+template <typename T>
+struct lru_codec
+{
+    static_assert(std::is_trivially_copyable<T>::value, "specialize lru_codec for this type");
+    static void encode(const T &value, std::string &out) { out.append(reinterpret_cast<const char *>(&value), sizeof(T)); }
+    static T decode(const char *data, size_t size)
+    {
+        T value{};
+        std::memcpy(&value, data, std::min(size, sizeof(T)));
+        return value;
+    }
+};
+
+template <>
+struct lru_codec<std::string>
+{
+    static void encode(const std::string &value, std::string &out) { out.append(value); }
+    static std::string decode(const char *data, size_t size) { return std::string(data, size); }
+};
+
+template <typename K, typename V, typename Ptr = std::shared_ptr<V>, typename KeyCodec = lru_codec<K>,
+          typename ValueCodec = lru_codec<V>>
+class LRU_Snapshot : public LRU_Tier<K, Ptr>
+{
+public:
+    typedef LRU_Cache<K, V, Ptr> Cache;
+
+    struct SaveStats
+    {
+        size_t entries = 0;
+        size_t bytes = 0;
+        double lockMs = 0;  // entries() 单次持锁的最长时间，get / put 最多被阻塞这么久（单核上还包括被其他线程抢占的时间）
+        double copyMs = 0;  // entries() 的总耗时
+        double totalMs = 0; // 包括编码、写文件与 fsync
+    };
+
+    // 失败时抛出 runtime_error，原来的快照文件保持不变
+    static SaveStats save(Cache &cache, const std::string &path)
+    {
+        SaveStats stats;
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<typename Cache::node> entries = cache.entries(COPY_CHUNK, &stats.lockMs);
+        stats.copyMs = elapsedMs(t0);
+        stats.entries = entries.size();
+
+        std::string tmp = path + ".tmp";
+        FILE *f = fopen(tmp.c_str(), "wb");
+        if (!f)
+            throw std::runtime_error("cannot create " + tmp);
+        std::unique_ptr<FILE, int (*)(FILE *)> guard(f, fclose);
+        setvbuf(f, nullptr, _IOFBF, 1 << 20);
+
+        Header h{};
+        std::memcpy(h.magic, MAGIC, sizeof(h.magic));
+        h.version = VERSION;
+        h.count = entries.size();
+        uint64_t offset = sizeof(Header);
+        bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+
+        std::vector<Slot> index;
+        index.reserve(entries.size());
+        std::string key, value;
+        for (auto &e : entries)
+        {
+            key.clear();
+            value.clear();
+            KeyCodec::encode(e.first, key);
+            ValueCodec::encode(*e.second, value);
+            uint32_t lens[2] = {uint32_t(key.size()), uint32_t(value.size())};
+            ok = ok && fwrite(lens, sizeof(lens), 1, f) == 1 && fwrite(key.data(), 1, key.size(), f) == key.size() &&
+                 fwrite(value.data(), 1, value.size(), f) == value.size();
+            index.push_back({lookup::crc32c(key.data(), key.size()), 0, offset});
+            offset += sizeof(lens) + key.size() + value.size();
+        }
+        entries.clear(); // 尽早释放对 value 的引用
+
+        // 表按 8 字节对齐
+        static const char zeros[8] = {};
+        uint64_t pad = (8 - offset % 8) % 8;
+        ok = ok && fwrite(zeros, 1, pad, f) == pad;
+        h.tableOffset = offset + pad;
+        h.slots = 2;
+        while (h.slots < index.size() * 2)
+            h.slots *= 2;
+        std::vector<Slot> table(h.slots);
+        for (const Slot &s : index)
+        {
+            uint64_t i = s.hash & (h.slots - 1);
+            while (table[i].offset)
+                i = (i + 1) & (h.slots - 1);
+            table[i] = s;
+        }
+        ok = ok && fwrite(table.data(), sizeof(Slot), table.size(), f) == table.size();
+        h.fileSize = h.tableOffset + h.slots * sizeof(Slot);
+        h.headerCrc = headerCrc(h);
+        ok = ok && fseek(f, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, f) == 1 && fflush(f) == 0 &&
+             fsync(fileno(f)) == 0;
+        guard.reset();
+        if (!ok || rename(tmp.c_str(), path.c_str()) != 0)
+        {
+            unlink(tmp.c_str());
+            throw std::runtime_error("cannot write " + path);
+        }
+        stats.bytes = h.fileSize;
+        stats.totalMs = elapsedMs(t0);
+        return stats;
+    }
+
+    // 在后台线程中保存，期间缓存照常服务
+    static std::future<SaveStats> save_async(Cache &cache, const std::string &path)
+    {
+        return std::async(std::launch::async, [&cache, path]()
+                          { return save(cache, path); });
+    }
+
+    // 映射快照文件；文件不存在或校验失败时返回空，按冷启动处理
+    static std::shared_ptr<LRU_Snapshot> open(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return nullptr;
+        struct stat st;
+        void *map = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(Header))
+            map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED)
+            return nullptr;
+        std::shared_ptr<LRU_Snapshot> s(new LRU_Snapshot(static_cast<const char *>(map), st.st_size));
+        return s->valid() ? s : nullptr;
+    }
+
+    // open 并挂到 cache 上作为第二层
+    static std::shared_ptr<LRU_Snapshot> restore(Cache &cache, const std::string &path)
+    {
+        std::shared_ptr<LRU_Snapshot> s = open(path);
+        if (s)
+            cache.set_tier(s);
+        return s;
+    }
+
+    ~LRU_Snapshot()
+    {
+        if (dead)
+            munmap(dead, header().slots);
+        munmap(const_cast<char *>(base), length);
+    }
+
+    // 按从新到旧的顺序追加到 cache 表尾，直到缓存填满或达到 limit，返回实际追加的条数
+    size_t warm(Cache &cache, size_t limit = SIZE_MAX)
+    {
+        size_t n = 0;
+        uint64_t offset = sizeof(Header);
+        while (offset < header().tableOffset && n < limit)
+        {
+            Record r;
+            if (!record(offset, r))
+                break;
+            offset = r.next;
+            long slot = find(r.key, r.keyLen);
+            if (slot < 0 || dead[slot].load(std::memory_order_relaxed))
+                continue;
+            if (!cache.append(KeyCodec::decode(r.key, r.keyLen), Ptr(new V(ValueCodec::decode(r.value, r.valueLen)))))
+                break;
+            n++;
+        }
+        return n;
+    }
+
+    Ptr load(const K &key) override
+    {
+        std::string bytes;
+        KeyCodec::encode(key, bytes);
+        long slot = find(bytes.data(), bytes.size());
+        Record r;
+        if (slot < 0 || dead[slot].load(std::memory_order_relaxed) || !record(table()[slot].offset, r))
+            return Ptr(nullptr);
+        return Ptr(new V(ValueCodec::decode(r.value, r.valueLen)));
+    }
+
+    void invalidate(const K &key) override
+    {
+        std::string bytes;
+        KeyCodec::encode(key, bytes);
+        long slot = find(bytes.data(), bytes.size());
+        if (slot >= 0)
+            dead[slot].store(1, std::memory_order_relaxed);
+    }
+
+    size_t size() const { return header().count; }
+    size_t bytes() const { return length; }
+
+private:
+    static constexpr char MAGIC[8] = {'L', 'R', 'U', 'S', 'N', 'A', 'P', '1'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t COPY_CHUNK = 1024; // entries() 每次持锁拷贝的条目数
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerCrc; // 计算时此字段为 0
+        uint64_t count;
+        uint64_t slots;
+        uint64_t tableOffset;
+        uint64_t fileSize;
+    };
+
+    struct Slot
+    {
+        uint32_t hash;
+        uint32_t reserved;
+        uint64_t offset;
+    };
+
+    struct Record
+    {
+        const char *key, *value;
+        uint32_t keyLen, valueLen;
+        uint64_t next;
+    };
+
+    LRU_Snapshot(const char *base, size_t length) : base(base), length(length) {}
+
+    static double elapsedMs(std::chrono::steady_clock::time_point t0)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    }
+
+    static uint32_t headerCrc(Header h)
+    {
+        h.headerCrc = 0;
+        return lookup::crc32c(&h, sizeof(h));
+    }
+
+    const Header &header() const { return *reinterpret_cast<const Header *>(base); }
+    const Slot *table() const { return reinterpret_cast<const Slot *>(base + header().tableOffset); }
+
+    // 只校验文件头与表的位置；记录在读取时逐条检查边界，不在启动时扫描整个文件
+    bool valid()
+    {
+        const Header &h = header();
+        if (std::memcmp(h.magic, MAGIC, sizeof(h.magic)) || h.version != VERSION || h.headerCrc != headerCrc(h) ||
+            h.fileSize != length || h.slots < 2 || (h.slots & (h.slots - 1)) || h.tableOffset % 8 ||
+            h.tableOffset < sizeof(Header) || h.tableOffset + h.slots * sizeof(Slot) != length)
+            return false;
+        // 匿名映射由内核清零，只有被写到的页才分配物理内存，恢复时不需要 memset 整个数组
+        void *p = mmap(nullptr, h.slots, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            return false;
+        dead = static_cast<std::atomic<uint8_t> *>(p);
+        return true;
+    }
+
+    bool record(uint64_t offset, Record &r) const
+    {
+        uint64_t end = header().tableOffset;
+        uint32_t lens[2];
+        if (offset < sizeof(Header) || offset + sizeof(lens) > end)
+            return false;
+        std::memcpy(lens, base + offset, sizeof(lens));
+        r.next = offset + sizeof(lens) + uint64_t(lens[0]) + lens[1];
+        if (r.next > end)
+            return false;
+        r.keyLen = lens[0];
+        r.valueLen = lens[1];
+        r.key = base + offset + sizeof(lens);
+        r.value = r.key + r.keyLen;
+        return true;
+    }
+
+    // 返回槽位下标，找不到返回 -1
+    long find(const char *key, size_t size) const
+    {
+        uint32_t hash = lookup::crc32c(key, size);
+        uint64_t mask = header().slots - 1;
+        const Slot *t = table();
+        for (uint64_t i = hash & mask, probes = 0; probes <= mask; i = (i + 1) & mask, probes++)
+        {
+            if (!t[i].offset)
+                return -1;
+            Record r;
+            if (t[i].hash == hash && record(t[i].offset, r) && r.keyLen == size && !std::memcmp(r.key, key, size))
+                return long(i);
+        }
+        return -1;
+    }
+
+    const char *base;
+    size_t length;
+    std::atomic<uint8_t> *dead = nullptr; // 恢复后被 put 覆盖过的 key，按槽位下标
+};
@@ -0,0 +1,211 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+#include "lru_spill.h"
+using namespace std;
+
+// 只用内存的 LRU_Cache 与加上溢出层之后的命中率和请求延迟，回源用忙等模拟；以及覆盖写为主时后台压缩的正确性
+// 编译：g++ -std=c++17 -O2 -pthread lru_spill.cc -o lru_spill
+
+typedef LRU_Cache<uint64_t, string> Cache;
+typedef LRU_Spill<uint64_t, string> Spill;
+
+static const uint64_t KEYS = 2000000;
+static const int CAPACITY = 100000;
+static const size_t REQUESTS = 600000;
+static const double WRITE_RATIO = 0.05;
+static const auto FETCH_COST = chrono::microseconds(20); // 回源比读本地文件贵两个数量级
+
+// 长尾分布：key = KEYS * u^5
+static vector<uint64_t> workload(size_t n, uint64_t seed)
+{
+    mt19937_64 rng(seed);
+    uniform_real_distribution<double> u(0, 1);
+    vector<uint64_t> keys(n);
+    for (auto &k : keys)
+        k = uint64_t(KEYS * pow(u(rng), 5));
+    return keys;
+}
+
+static shared_ptr<string> value(uint64_t key, int version)
+{
+    return make_shared<string>("value-" + to_string(key) + "-v" + to_string(version) + string(90, 'x'));
+}
+
+static shared_ptr<string> fetch(uint64_t key, int version)
+{
+    auto until = chrono::steady_clock::now() + FETCH_COST;
+    while (chrono::steady_clock::now() < until)
+        ;
+    return value(key, version);
+}
+
+struct Result
+{
+    double hitRate, seconds;
+    double mean, p50, p99, p999; // 所有请求，微秒
+    double hitP50, hitP99;        // 只算命中的请求
+    long hits;
+};
+
+static Result run(Cache &cache, const vector<uint64_t> &keys)
+{
+    mt19937 rng(5);
+    vector<float> latencies, hitLatencies;
+    latencies.reserve(keys.size());
+    long hits = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        auto t0 = chrono::steady_clock::now();
+        uint64_t key = keys[i];
+        if (rng() % 1000 < WRITE_RATIO * 1000)
+            cache.put(key, fetch(key, int(i))); // 写：新版本覆盖
+        else if (cache.get(key))
+        {
+            hits++;
+            hitLatencies.push_back(chrono::duration<float, micro>(chrono::steady_clock::now() - t0).count());
+        }
+        else
+            cache.put(key, fetch(key, 0));
+        latencies.push_back(chrono::duration<float, micro>(chrono::steady_clock::now() - t0).count());
+    }
+    Result r;
+    r.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    r.mean = r.seconds * 1e6 / keys.size();
+    auto pct = [](vector<float> &v, double p)
+    {
+        sort(v.begin(), v.end());
+        return v.empty() ? 0.0 : v[size_t(p * (v.size() - 1))];
+    };
+    r.p50 = pct(latencies, 0.5);
+    r.p99 = pct(latencies, 0.99);
+    r.p999 = pct(latencies, 0.999);
+    r.hitP50 = pct(hitLatencies, 0.5);
+    r.hitP99 = pct(hitLatencies, 0.99);
+    r.hits = hits;
+    r.hitRate = double(hits) / keys.size();
+    return r;
+}
+
+static void print(const char *name, const Result &r)
+{
+    cout << left << setw(14) << name << right << fixed << setprecision(3) << setw(10) << r.hitRate << setprecision(1)
+         << setw(10) << r.mean << setw(10) << r.p50 << setw(10) << r.p99 << setw(10) << r.p999 << setprecision(2)
+         << setw(10) << r.hitP50 << setw(10) << r.hitP99 << setprecision(1) << setw(10) << r.seconds << defaultfloat
+         << endl;
+}
+
+/**
+ * 8KB 一段（约 60 条记录）、一半请求是覆盖写：溢出的副本很快被 put 作废，旧段的有效比例掉到 1/2 以下，
+ * 后台线程不断压缩。每次命中都与该 key 最后一次写入的版本比较，压缩搬动记录时不能让旧值回来。
+ */
+static bool compaction()
+{
+    const uint64_t HOT_KEYS = 20000;
+    const int OPS = 2000000;
+    Cache cache(2000);
+    auto spill = Spill::attach(cache, "/tmp", 8 << 10, 64 << 20);
+    vector<int> latest(HOT_KEYS, -1);
+    mt19937_64 rng(11);
+    long hits = 0, stale = 0;
+    for (int i = 0; i < OPS; i++)
+    {
+        uint64_t key = rng() % HOT_KEYS;
+        if (rng() % 2)
+        {
+            cache.put(key, value(key, i));
+            latest[key] = i;
+        }
+        else if (auto v = cache.get(key))
+        {
+            hits++;
+            stale += latest[key] < 0 || *v != *value(key, latest[key]);
+        }
+    }
+    Spill::Stats s = spill->stats();
+    cout << "overwrite-heavy, 8KB segments: " << OPS << " ops over " << HOT_KEYS << " keys, " << hits << " hits ("
+         << s.hits << " from spill), " << stale << " stale" << endl;
+    cout << "  compacted " << s.compactedSegments << " segments (" << s.movedRecords << " records moved), dropped "
+         << s.droppedSegments << " segments, " << s.segments << " segments live" << endl;
+    return stale == 0 && s.compactedSegments > 0;
+}
+
+/**
+ * 第二层的 load 在缓存锁外进行，期间其他线程可能在写别的 key。包装溢出层，在每次 load 中途 put 一个别的 key，
+ * 确定地重现这种交错：别的 key 的写不能让 load 读到的值被丢弃。溢出层足够大、不丢段，每次 get 都应命中。
+ */
+struct WriteDuringLoad : LRU_Tier<uint64_t, shared_ptr<string>>
+{
+    Cache *cache;
+    shared_ptr<Spill> spill;
+    uint64_t next = KEYS;
+
+    shared_ptr<string> load(const uint64_t &key) override
+    {
+        shared_ptr<string> v = spill->load(key);
+        cache->put(next, value(next, 1));
+        next++;
+        return v;
+    }
+    void invalidate(const uint64_t &key) override { spill->invalidate(key); }
+    void evicted(const uint64_t &key, const shared_ptr<string> &val) override { spill->evicted(key, val); }
+};
+
+static bool writesDuringLoad()
+{
+    const int READ_KEYS = 40000, READS = 200000;
+    Cache cache(10000);
+    auto tier = make_shared<WriteDuringLoad>();
+    tier->cache = &cache;
+    tier->spill = make_shared<Spill>("/tmp", 1 << 20, 256 << 20);
+    cache.set_tier(tier);
+    for (int k = 0; k < READ_KEYS; k++)
+        cache.put(k, value(k, 0));
+    mt19937 rng(17);
+    long misses = 0;
+    for (int i = 0; i < READS; i++)
+        misses += !cache.get(rng() % READ_KEYS);
+    Spill::Stats s = tier->spill->stats();
+    cache.set_tier(nullptr);
+    cout << "another key written during every load: " << READS << " gets, " << s.hits << " loaded from spill, "
+         << misses << " returned null" << endl;
+    return misses == 0;
+}
+
+int main()
+{
+    vector<uint64_t> keys = workload(REQUESTS, 1);
+    cout << REQUESTS << " requests over " << KEYS << " keys, RAM capacity " << CAPACITY << ", " << WRITE_RATIO * 100
+         << "% writes, fetch " << FETCH_COST.count() << " us" << endl;
+    cout << left << setw(14) << "" << right << setw(10) << "hit rate" << setw(10) << "mean us" << setw(10) << "p50 us"
+         << setw(10) << "p99 us" << setw(10) << "p99.9 us" << setw(10) << "hit p50" << setw(10) << "hit p99"
+         << setw(10) << "seconds" << endl;
+
+    Cache ramOnly(CAPACITY);
+    print("RAM only", run(ramOnly, keys));
+
+    // 4MB 一段，总共最多 24MB（约 19 万条），小到足以观察丢弃旧段
+    Cache tiered(CAPACITY);
+    auto spill = Spill::attach(tiered, "/tmp", 4 << 20, 24 << 20);
+    Result r = run(tiered, keys);
+    print("RAM + spill", r);
+
+    Spill::Stats s = spill->stats();
+    cout << endl
+         << "spill tier: " << s.hits << " hits (" << fixed << setprecision(1) << 100.0 * s.hits / max<long>(1, r.hits)
+         << "% of all hits), " << s.misses << " misses" << defaultfloat << endl;
+    cout << "  " << s.entries << " entries, " << s.segments << " segments, " << (s.diskBytes >> 20) << " MB on disk, "
+         << (s.liveBytes >> 20) << " MB live" << endl;
+    cout << "  spilled " << s.spilled << ", skipped rewrite " << s.skipped << ", compacted " << s.compactedSegments
+         << " segments (" << s.movedRecords << " records moved), dropped " << s.droppedSegments << " segments ("
+         << s.droppedEntries << " entries)" << endl
+         << endl;
+    bool ok = compaction();
+    return writesDuringLoad() && ok ? 0 : 1;
+}
@@ -0,0 +1,313 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "lru_cache.h"
+#include "lru_snapshot.h"
+
+/** LRU_Cache 的第二层：淘汰的条目溢出到本地文件，用法与基准见 lru_spill.cc
+ *
+ * 文件按段（segment）组织，每段是一个预先 ftruncate 好的文件，MAP_SHARED 映射后顺序追加记录（格式同 lru_snapshot.h）：
+ *      u32 keyLen, u32 valueLen, key 字节, value 字节
+ * 段文件映射后立即 unlink，进程退出（包括崩溃）后空间自动回收；页缓存由内核按需写回磁盘、回收内存。
+ * 内存中只有一张索引 key -> (段号, 段内偏移)，每个条目 8 字节加上 key。
+ *
+ *      evicted     写到当前段末尾；如果该 key 在溢出层中的副本仍然有效（从溢出层提升上来之后没有被 put 过），不重复写
+ *      load        查索引，从映射中解码 value；命中后 LRU_Cache 把它放回内存（提升），溢出层的副本保留
+ *      invalidate  put 时删除索引项，旧记录成为垃圾
+ * 后台线程压缩（compaction）有效数据比例低于 compactBelow 的旧段：把仍被索引引用的记录搬到当前段，然后删除旧段。
+ * 总大小超过 maxBytes 时同一个线程丢弃最旧的段，其中的条目从索引中删除（溢出层本身也是缓存），
+ * 丢弃在后台进行，期间总大小会短暂超过 maxBytes。
+ *
+ * 所有操作在一把互斥锁内完成：evicted 由 LRU_Cache 在持有缓存锁时调用，这里只做一次 memcpy，偶尔新开一个段；
+ * 压缩与丢弃每处理一批记录就释放一次锁，不会长时间阻塞 load / evicted。
+ */
+template <typename K, typename V, typename Ptr = std::shared_ptr<V>, typename KeyCodec = lru_codec<K>,
+          typename ValueCodec = lru_codec<V>>
+class LRU_Spill : public LRU_Tier<K, Ptr>
+{
+public:
+    typedef LRU_Cache<K, V, Ptr> Cache;
+
+    struct Stats
+    {
+        size_t entries = 0;
+        size_t segments = 0;
+        size_t diskBytes = 0; // 所有段的大小
+        size_t liveBytes = 0; // 其中仍被索引引用的记录
+        size_t spilled = 0;   // evicted 写入的条数
+        size_t skipped = 0;   // evicted 时副本仍有效、没有重复写的条数
+        size_t hits = 0, misses = 0;
+        size_t compactedSegments = 0, movedRecords = 0;
+        size_t droppedSegments = 0, droppedEntries = 0;
+    };
+
+    LRU_Spill(const std::string &dir, size_t segmentBytes = 64 << 20, size_t maxBytes = size_t(1) << 30,
+              double compactBelow = 0.5)
+        : dir(dir), segmentBytes(segmentBytes), maxBytes(maxBytes), compactBelow(compactBelow)
+    {
+        if (segmentBytes < 4096 || segmentBytes > UINT32_MAX || maxBytes < 2 * segmentBytes)
+            throw std::invalid_argument("LRU_Spill: bad segment / max size");
+        std::lock_guard<std::mutex> guard(mutex);
+        if (!openSegment())
+            throw std::runtime_error("LRU_Spill: cannot create segment in " + dir);
+        compactor = std::thread([this]()
+                                { compactLoop(); });
+    }
+
+    ~LRU_Spill()
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            stop = true;
+        }
+        wakeup.notify_one();
+        compactor.join();
+    }
+
+    static std::shared_ptr<LRU_Spill> attach(Cache &cache, const std::string &dir, size_t segmentBytes = 64 << 20,
+                                             size_t maxBytes = size_t(1) << 30)
+    {
+        auto s = std::make_shared<LRU_Spill>(dir, segmentBytes, maxBytes);
+        cache.set_tier(s);
+        return s;
+    }
+
+    Ptr load(const K &key) override
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        auto ite = index.find(key);
+        if (ite == index.end())
+        {
+            counters.misses++;
+            return Ptr(nullptr);
+        }
+        counters.hits++;
+        const char *p = segments[ite->second.segment]->base + ite->second.offset;
+        uint32_t lens[2];
+        std::memcpy(lens, p, sizeof(lens));
+        return Ptr(new V(ValueCodec::decode(p + sizeof(lens) + lens[0], lens[1])));
+    }
+
+    void invalidate(const K &key) override
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        auto ite = index.find(key);
+        if (ite == index.end())
+            return;
+        release(ite->second);
+        index.erase(ite);
+    }
+
+    void evicted(const K &key, const Ptr &val) override
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (index.count(key))
+        {
+            counters.skipped++;
+            return;
+        }
+        key_.clear();
+        value_.clear();
+        KeyCodec::encode(key, key_);
+        ValueCodec::encode(*val, value_);
+        Location loc;
+        if (!append(key_.data(), key_.size(), value_.data(), value_.size(), loc))
+            return;
+        index.emplace(key, loc);
+        counters.spilled++;
+    }
+
+    Stats stats()
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        Stats s = counters;
+        s.entries = index.size();
+        s.segments = segments.size();
+        s.diskBytes = segments.size() * segmentBytes;
+        s.liveBytes = 0;
+        for (auto &kv : segments)
+            s.liveBytes += kv.second->live;
+        return s;
+    }
+
+private:
+    struct Location
+    {
+        uint32_t segment;
+        uint32_t offset;
+    };
+
+    struct Segment
+    {
+        char *base = nullptr;
+        size_t size = 0;
+        size_t used = 0;
+        size_t live = 0;
+        ~Segment()
+        {
+            if (base)
+                munmap(base, size);
+        }
+    };
+
+    static constexpr size_t HEADER = 2 * sizeof(uint32_t);
+    static constexpr size_t MOVE_BATCH = 256; // 压缩时每批搬动的记录数
+
+    static size_t recordSize(const char *p)
+    {
+        uint32_t lens[2];
+        std::memcpy(lens, p, sizeof(lens));
+        return HEADER + lens[0] + lens[1];
+    }
+
+    // 失败（目录不可写、磁盘满等）返回 false，此时只是不再溢出，不影响 put
+    bool openSegment()
+    {
+        std::string path = dir + "/lru_spill." + std::to_string(getpid()) + "." + std::to_string(nextSegment) + ".seg";
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd < 0)
+            return false;
+        unlink(path.c_str());
+        void *map = MAP_FAILED;
+        if (ftruncate(fd, segmentBytes) == 0)
+            map = mmap(nullptr, segmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED)
+            return false;
+        std::unique_ptr<Segment> s(new Segment);
+        s->base = static_cast<char *>(map);
+        s->size = segmentBytes;
+        active = nextSegment++;
+        segments.emplace(active, std::move(s));
+        wakeup.notify_one(); // 可能需要丢弃旧段或压缩
+        return true;
+    }
+
+    // 写到当前段末尾，放不下时换新段；单条记录比一个段还大时不写
+    bool append(const char *key, size_t keyLen, const char *value, size_t valueLen, Location &loc)
+    {
+        size_t size = HEADER + keyLen + valueLen;
+        if (size > segmentBytes)
+            return false;
+        if (segments[active]->used + size > segmentBytes && !openSegment())
+            return false;
+        Segment &s = *segments[active];
+        uint32_t lens[2] = {uint32_t(keyLen), uint32_t(valueLen)};
+        char *p = s.base + s.used;
+        std::memcpy(p, lens, HEADER);
+        std::memcpy(p + HEADER, key, keyLen);
+        std::memcpy(p + HEADER + keyLen, value, valueLen);
+        loc = {active, uint32_t(s.used)};
+        s.used += size;
+        s.live += size;
+        return true;
+    }
+
+    void release(const Location &loc)
+    {
+        Segment &s = *segments[loc.segment];
+        s.live -= recordSize(s.base + loc.offset);
+    }
+
+    // 要处理的段：总大小超过 maxBytes 时是最旧的段（丢弃），否则是有效比例最低且低于 compactBelow 的已写满的段（压缩）
+    bool pickVictim(uint32_t &id, bool &keep)
+    {
+        if (segments.size() * segmentBytes > maxBytes && segments.begin()->first != active)
+        {
+            id = segments.begin()->first;
+            keep = false;
+            return true;
+        }
+        double best = compactBelow;
+        bool found = false;
+        for (auto &kv : segments)
+        {
+            double ratio = double(kv.second->live) / kv.second->size;
+            if (kv.first != active && ratio < best)
+            {
+                best = ratio;
+                id = kv.first;
+                found = true;
+            }
+        }
+        keep = true;
+        return found;
+    }
+
+    void compactLoop()
+    {
+        std::unique_lock<std::mutex> guard(mutex);
+        while (!stop)
+        {
+            uint32_t id;
+            bool keep;
+            if (!pickVictim(id, keep))
+            {
+                wakeup.wait_for(guard, std::chrono::milliseconds(100));
+                continue;
+            }
+            // 分批处理，批与批之间放开锁
+            for (size_t offset = 0; !stop && offset < segments[id]->used;)
+            {
+                for (size_t n = 0; n < MOVE_BATCH && offset < segments[id]->used; n++)
+                {
+                    const char *p = segments[id]->base + offset;
+                    size_t size = recordSize(p);
+                    uint32_t lens[2];
+                    std::memcpy(lens, p, sizeof(lens));
+                    K key = KeyCodec::decode(p + HEADER, lens[0]);
+                    auto ite = index.find(key);
+                    if (ite != index.end() && ite->second.segment == id && ite->second.offset == offset)
+                    {
+                        Location loc;
+                        // append 只会新开段，不会删除段，p 始终有效
+                        if (keep && append(p + HEADER, lens[0], p + HEADER + lens[0], lens[1], loc))
+                        {
+                            ite->second = loc;
+                            counters.movedRecords++;
+                        }
+                        else
+                        {
+                            index.erase(ite);
+                            counters.droppedEntries++;
+                        }
+                    }
+                    offset += size;
+                }
+                guard.unlock();
+                std::this_thread::yield();
+                guard.lock();
+            }
+            if (stop)
+                break;
+            segments.erase(id);
+            (keep ? counters.compactedSegments : counters.droppedSegments)++;
+        }
+    }
+
+    std::string dir;
+    size_t segmentBytes, maxBytes;
+    double compactBelow;
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool stop = false;
+    std::map<uint32_t, std::unique_ptr<Segment>> segments; // 段号递增，begin() 是最旧的段
+    uint32_t active = 0, nextSegment = 0;
+    std::unordered_map<K, Location> index;
+    Stats counters;
+    std::string key_, value_; // evicted 的编码缓冲区，持锁使用
+    std::thread compactor;
+};
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/** perf_event_open 的最小封装
+ *
+ * 只统计当前线程的用户态事件（exclude_kernel / exclude_hv），不需要 root，
+ * 但容器里或 /proc/sys/kernel/perf_event_paranoid 过高时会打开失败，此时 valid() 为 false，
+ * 调用方应当把结果当作“不可用”而不是 0。
+ * inherit 为 true 时，之后由当前线程创建的子线程的事件也计入（用于多线程的基准）。
+ */
+class PerfCounter
+{
+public:
+    PerfCounter(uint32_t type, uint64_t config, bool inherit = false) : fd(-1)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = inherit;
+        fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    PerfCounter(const PerfCounter &) = delete;
+    PerfCounter &operator=(const PerfCounter &) = delete;
+    PerfCounter(PerfCounter &&other) noexcept : fd(other.fd) { other.fd = -1; }
+    ~PerfCounter()
+    {
+        if (fd >= 0)
+            close(fd);
+    }
+
+    static PerfCounter cycles(bool inherit = false)
+    {
+        return PerfCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, inherit);
+    }
+    static PerfCounter instructions(bool inherit = false)
+    {
+        return PerfCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, inherit);
+    }
+    static PerfCounter cacheMisses(bool inherit = false)
+    {
+        return PerfCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, inherit);
+    }
+    static PerfCounter branchMisses(bool inherit = false)
+    {
+        return PerfCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, inherit);
+    }
+    static PerfCounter dtlbMisses(bool inherit = false)
+    {
+        return PerfCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+                           inherit);
+    }
+
+    bool valid() const { return fd >= 0; }
+
+    void start()
+    {
+        if (fd < 0)
+            return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    void stop()
+    {
+        if (fd >= 0)
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    uint64_t value() const
+    {
+        uint64_t v = 0;
+        if (fd < 0 || read(fd, &v, sizeof(v)) != sizeof(v))
+            return 0;
+        return v;
+    }
+
+private:
+    int fd;
+};
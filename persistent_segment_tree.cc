@@ -0,0 +1,272 @@
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <random>
+#include "segment_tree.h"
+using namespace std;
+
+// 可持久化（多版本）线段树，以统计区间最大值、区间加为例
+// 编译：g++ -std=c++17 -O2 -pthread persistent_segment_tree.cc -o persistent_segment_tree
+
+/** 路径复制（path copying）
+ *
+ * 每次 update 只复制从根到被修改节点路径上的 O(log n) 个节点，其余子树在新旧版本之间共享，
+ * 于是每个版本只需要保存一个根。为了让旧版本保持不变，不能再做 pushDown（那会修改共享节点），
+ * 这里使用“标记永久化”：mask 永远留在节点上，查询时沿路径把祖先的 mask 累加起来。
+ *
+ *      data = max(左孩子 data, 右孩子 data) + mask，空孩子视为整段都是 0
+ *
+ * 节点不保存 left/right，区间在递归时计算，孩子用 32 位下标代替指针，加上引用计数一个节点是 20 字节。
+ */
+
+/** 基于 arena 的回收
+ *
+ * 节点分配在按块增长的 arena 中（块地址不变，下标永远有效），每个节点带一个引用计数，
+ * 表示有多少父节点/版本根指向它。drop 一个版本时递减根的计数，降到 0 的节点递归释放孩子，
+ * 然后挂到空闲链表上，下一次 update 优先复用，因此保留的版本数不变时内存不会增长。
+ */
+class PersistentSegmentTree
+{
+public:
+    PersistentSegmentTree(int lo, int hi) : lo(lo), hi(hi), freeList(0), live(0)
+    {
+        blocks.emplace_back(new PNode[BLOCK_SIZE]);
+        allocated = 1; // 下标 0 保留为空节点
+        roots.push_back(0);
+    }
+    PersistentSegmentTree(const PersistentSegmentTree &) = delete;
+    PersistentSegmentTree &operator=(const PersistentSegmentTree &) = delete;
+
+    // 在 version 的基础上做一次区间加，返回新版本号，旧版本不受影响
+    int update(int version, int l, int r, int val)
+    {
+        roots.push_back(update(roots[version], lo, hi, l, r, val));
+        return (int)roots.size() - 1;
+    }
+
+    // O(log n) 地查询任意一个仍然保留的版本
+    int query(int version, int l, int r) const { return query(roots[version], lo, hi, l, r, 0); }
+
+    // 丢弃一个版本，只被它引用的节点会被回收
+    void drop(int version)
+    {
+        release(roots[version]);
+        roots[version] = 0;
+    }
+
+    size_t liveNodes() const { return live; }
+    size_t arenaBytes() const { return blocks.size() * BLOCK_SIZE * sizeof(PNode); }
+    static constexpr size_t nodeBytes() { return sizeof(PNode); }
+
+private:
+    struct PNode
+    {
+        int data, mask;
+        uint32_t lchild, rchild; // 同时被空闲链表复用，lchild 指向下一个空闲节点
+        uint32_t ref;
+    };
+    static_assert(sizeof(PNode) == 20, "PNode 的大小与上面的说明不一致");
+    static const uint32_t BLOCK_BITS = 16;
+    static const uint32_t BLOCK_SIZE = 1u << BLOCK_BITS;
+
+    PNode &at(uint32_t idx) { return blocks[idx >> BLOCK_BITS][idx & (BLOCK_SIZE - 1)]; }
+    const PNode &at(uint32_t idx) const { return blocks[idx >> BLOCK_BITS][idx & (BLOCK_SIZE - 1)]; }
+    int dataOf(uint32_t idx) const { return idx ? at(idx).data : 0; }
+
+    uint32_t allocate()
+    {
+        uint32_t idx;
+        if (freeList)
+        {
+            idx = freeList;
+            freeList = at(idx).lchild;
+        }
+        else
+        {
+            if (allocated == blocks.size() * BLOCK_SIZE)
+                blocks.emplace_back(new PNode[BLOCK_SIZE]);
+            idx = allocated++;
+        }
+        live++;
+        return idx;
+    }
+
+    void retain(uint32_t idx)
+    {
+        if (idx)
+            at(idx).ref++;
+    }
+
+    void release(uint32_t idx)
+    {
+        if (!idx || --at(idx).ref > 0)
+            return;
+        release(at(idx).lchild);
+        release(at(idx).rchild);
+        at(idx).lchild = freeList;
+        freeList = idx;
+        live--;
+    }
+
+    uint32_t update(uint32_t old, int nl, int nr, int l, int r, int val)
+    {
+        uint32_t idx = allocate();
+        PNode node = old ? at(old) : PNode{0, 0, 0, 0, 0};
+        node.ref = 1;
+        if (l <= nl && r >= nr)
+        {
+            // 整段覆盖，孩子原样共享
+            retain(node.lchild);
+            retain(node.rchild);
+            node.data += val;
+            node.mask += val;
+        }
+        else
+        {
+            int mid = nl + (nr - nl) / 2;
+            if (l <= mid)
+                node.lchild = update(node.lchild, nl, mid, l, r, val);
+            else
+                retain(node.lchild);
+            if (r > mid)
+                node.rchild = update(node.rchild, mid + 1, nr, l, r, val);
+            else
+                retain(node.rchild);
+            node.data = max(dataOf(node.lchild), dataOf(node.rchild)) + node.mask;
+        }
+        // allocate 可能新增 block，但已有 block 的地址不变，这里重新取引用即可
+        at(idx) = node;
+        return idx;
+    }
+
+    int query(uint32_t idx, int nl, int nr, int l, int r, int add) const
+    {
+        if (!idx)
+            return add; // 空子树整段都是 0
+        const PNode &node = at(idx);
+        if (l <= nl && r >= nr)
+            return node.data + add;
+        int mid = nl + (nr - nl) / 2;
+        int res = INT_MIN;
+        if (l <= mid)
+            res = max(res, query(node.lchild, nl, mid, l, r, add + node.mask));
+        if (r > mid)
+            res = max(res, query(node.rchild, mid + 1, nr, l, r, add + node.mask));
+        return res;
+    }
+
+private:
+    int lo, hi;
+    vector<unique_ptr<PNode[]>> blocks;
+    size_t allocated;
+    uint32_t freeList;
+    size_t live;
+    vector<uint32_t> roots; // 版本号 -> 根，被 drop 的版本根为 0
+};
+
+// 全量快照：把整棵动态开链树复制一份
+static Node *cloneTree(const Node *node, size_t &count)
+{
+    if (!node)
+        return nullptr;
+    Node *copy = new Node(node->left, node->right);
+    copy->data = node->data;
+    copy->mask = node->mask;
+    copy->lchild = cloneTree(node->lchild, count);
+    copy->rchild = cloneTree(node->rchild, count);
+    count++;
+    return copy;
+}
+
+static double seconds(chrono::steady_clock::time_point begin)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+}
+
+int main(int argc, char const *argv[])
+{
+    const int n = 1 << 18, snapshots = 64, perSnapshot = 2000, queries = 200000;
+    mt19937 rng(7);
+    auto randomRange = [&](int &l, int &r)
+    {
+        l = rng() % n, r = rng() % n;
+        if (l > r)
+            swap(l, r);
+    };
+
+    // 1. 全量复制：每 perSnapshot 次更新复制一次整棵树
+    Node *live = new Node(0, n - 1);
+    vector<Node *> copies;
+    size_t copiedNodes = 0;
+    auto begin = chrono::steady_clock::now();
+    for (int s = 0; s < snapshots; s++)
+    {
+        for (int i = 0; i < perSnapshot; i++)
+        {
+            int l, r;
+            randomRange(l, r);
+            update(live, l, r, rng() % 100);
+        }
+        copies.push_back(cloneTree(live, copiedNodes));
+    }
+    double copyTime = seconds(begin);
+
+    // 2. 路径复制：同样的操作序列，每次更新都产生一个新版本，只保留快照点的版本
+    rng.seed(7);
+    PersistentSegmentTree tree(0, n - 1);
+    vector<int> versions;
+    int current = 0;
+    begin = chrono::steady_clock::now();
+    for (int s = 0; s < snapshots; s++)
+    {
+        for (int i = 0; i < perSnapshot; i++)
+        {
+            int l, r;
+            randomRange(l, r);
+            int next = tree.update(current, l, r, rng() % 100);
+            // 快照点之间的中间版本不保留，立即回收
+            if (i > 0)
+                tree.drop(current);
+            current = next;
+        }
+        versions.push_back(current);
+    }
+    double persistTime = seconds(begin);
+
+    cout << "full copy:  " << copiedNodes * sizeof(Node) / snapshots << " bytes/version, build "
+         << copyTime << " s" << endl;
+    cout << "persistent: " << tree.liveNodes() * PersistentSegmentTree::nodeBytes() / snapshots
+         << " bytes/version, build " << persistTime << " s" << endl;
+
+    // 查询延迟：随机版本、随机区间
+    vector<int> qv(queries), ql(queries), qr(queries);
+    for (int i = 0; i < queries; i++)
+    {
+        qv[i] = rng() % snapshots;
+        randomRange(ql[i], qr[i]);
+    }
+    vector<int> expect(queries), got(queries);
+    begin = chrono::steady_clock::now();
+    for (int i = 0; i < queries; i++)
+        expect[i] = query(copies[qv[i]], ql[i], qr[i]);
+    double t = seconds(begin);
+    cout << "query full copy:  " << t / queries * 1e9 << " ns/op" << endl;
+    begin = chrono::steady_clock::now();
+    for (int i = 0; i < queries; i++)
+        got[i] = tree.query(versions[qv[i]], ql[i], qr[i]);
+    t = seconds(begin);
+    cout << "query persistent: " << t / queries * 1e9 << " ns/op" << endl;
+    cout << (expect == got ? "results match" : "results MISMATCH") << endl;
+
+    // 丢弃一半版本，被回收的节点会在后续 update 中复用
+    size_t before = tree.liveNodes();
+    for (int s = 0; s < snapshots; s += 2)
+        tree.drop(versions[s]);
+    cout << "drop " << snapshots / 2 << " versions: live nodes " << before << " -> " << tree.liveNodes()
+         << ", arena " << tree.arenaBytes() << " bytes" << endl;
+
+    delete live;
+    for (Node *copy : copies)
+        delete copy;
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include "pool_ptr.h"
+using namespace std;
+
+// 对比 shared_ptr / intrusive_ptr / pool_shared_ptr 在 LRU_Cache 和 ThreadPool 中的堆分配次数与延迟
+// 编译：g++ -std=c++17 -O2 -pthread pool_ptr.cc -o pool_ptr
+
+// 统计全局 operator new 的调用次数
+static atomic<long> allocations(0);
+void *operator new(size_t size)
+{
+    allocations.fetch_add(1, memory_order_relaxed);
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+struct Value
+{
+    long id;
+    char payload[48];
+    Value(long i) : id(i) {}
+};
+
+struct IntrusiveValue : RefCounted<IntrusiveValue>
+{
+    long id;
+    char payload[48];
+    IntrusiveValue(long i) : id(i) {}
+};
+
+struct Result
+{
+    double nsPerOp;
+    double allocsPerOp;
+};
+
+template <typename Body>
+Result measure(long ops, Body body)
+{
+    long before = allocations.load();
+    auto begin = chrono::steady_clock::now();
+    body();
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count();
+    return {ns / ops, double(allocations.load() - before) / ops};
+}
+
+// 容量 capacity 的缓存上执行 ops 次“未命中则 put，命中则 get”，key 在 2 * capacity 范围内随机
+template <typename Cache, typename Make>
+Result cacheWorkload(long ops, int capacity, Make make)
+{
+    Cache cache(capacity);
+    mt19937 rng(1);
+    long sink = 0;
+    Result r = measure(ops, [&]()
+                       {
+        for (long i = 0; i < ops; i++)
+        {
+            int key = rng() % (2 * capacity);
+            auto v = cache.get(key);
+            if (v)
+                sink += v->id;
+            else
+                cache.put(key, make(key));
+        } });
+    volatile long keep = sink; // 防止 get 的结果被优化掉
+    (void)keep;
+    return r;
+}
+
+template <typename Pool>
+Result poolWorkload(long tasks)
+{
+    Pool pool(4);
+    atomic<long> sum(0);
+    vector<future<void>> results;
+    results.reserve(tasks);
+    return measure(tasks, [&]()
+                   {
+        for (long i = 0; i < tasks; i++)
+            results.push_back(pool.enqueue([&sum, i]()
+                                           { sum += i; }));
+        for (auto &f : results)
+            f.wait(); });
+}
+
+static void print(const char *name, Result r)
+{
+    cout << "  " << name << r.nsPerOp << " ns/op, " << r.allocsPerOp << " allocs/op" << endl;
+}
+
+int main(int argc, char const *argv[])
+{
+    const long ops = 2000000, tasks = 200000;
+    const int capacity = 10000;
+
+    // 先预热一遍对象池，让池里的槽位块都分配好，后面测的是稳态
+    cacheWorkload<PooledLRU_Cache<int, Value>>(ops, capacity, [](long k)
+                                               { return make_pool_shared<Value>(k); });
+
+    cout << "LRU_Cache get/put" << endl;
+    print("shared_ptr(new V):   ", cacheWorkload<LRU_Cache<int, Value>>(ops, capacity, [](long k)
+                                                                         { return shared_ptr<Value>(new Value(k)); }));
+    print("make_shared:         ", cacheWorkload<LRU_Cache<int, Value>>(ops, capacity, [](long k)
+                                                                         { return make_shared<Value>(k); }));
+    print("intrusive_ptr:       ", cacheWorkload<IntrusiveLRU_Cache<int, IntrusiveValue>>(ops, capacity, [](long k)
+                                                                                         { return make_intrusive<IntrusiveValue>(k); }));
+    print("pool_shared_ptr:     ", cacheWorkload<PooledLRU_Cache<int, Value>>(ops, capacity, [](long k)
+                                                                               { return make_pool_shared<Value>(k); }));
+
+    // packaged_task 内部还会 make_shared 一次共享状态，这一次无法通过外部分配器消除
+    cout << "ThreadPool enqueue" << endl;
+    print("make_shared task:    ", poolWorkload<ThreadPool>(tasks));
+    print("pool_shared_ptr task:", poolWorkload<PooledThreadPool>(tasks));
+
+    {
+        auto p = make_pool_unique<Value>(7);
+        cout << "pool_unique_ptr value " << p->id << ", Value pool chunks "
+             << ObjectPool<Value>::instance().chunks() << endl;
+    }
+    return 0;
+}
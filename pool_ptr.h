@@ -0,0 +1,314 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+#include "lru_cache.h"
+#include "thread_pool.h"
+
+// 消除控制块分配的智能指针，用法与测试见 pool_ptr.cc
+//
+//      intrusive_ptr<T>     引用计数嵌在对象内部（T 继承 RefCounted<T>），没有额外的控制块
+//      ObjectPool<T>        按类型划分的对象池，线程本地缓存 + 中心空闲链表，批量搬运
+//      pool_unique_ptr<T>   unique_ptr + 归还对象池的 deleter
+//      pool_shared_ptr<T>   计数与对象放在同一个池化的槽位中，一次池分配，不调用 malloc
+
+/** make_shared 的开销
+ *
+ * make_shared 把对象和控制块合成一次 malloc，但控制块里依然有 vptr、use_count、weak_count、deleter，
+ * 每次拷贝/析构都是原子操作；直接 shared_ptr<T>(new T) 更是两次 malloc。
+ * 在 LRU_Cache 的 put、ThreadPool 的 enqueue 这种高频路径上，这些分配都打在全局堆上。
+ */
+
+#pragma region intrusive_ptr
+// 与 boost::intrusive_ptr 的约定一致：通过 ADL 调用 intrusive_ptr_add_ref / intrusive_ptr_release
+template <typename Derived>
+class RefCounted
+{
+public:
+    RefCounted() : refs(0) {}
+    RefCounted(const RefCounted &) : refs(0) {} // 拷贝对象不拷贝计数
+    RefCounted &operator=(const RefCounted &) { return *this; }
+    long use_count() const { return refs.load(std::memory_order_relaxed); }
+
+    friend void intrusive_ptr_add_ref(const Derived *p)
+    {
+        static_cast<const RefCounted *>(p)->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    friend void intrusive_ptr_release(const Derived *p)
+    {
+        if (static_cast<const RefCounted *>(p)->refs.fetch_sub(1, std::memory_order_release) == 1)
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            delete p;
+        }
+    }
+
+protected:
+    ~RefCounted() = default;
+
+private:
+    mutable std::atomic<long> refs;
+};
+
+template <typename T>
+class intrusive_ptr
+{
+public:
+    intrusive_ptr(T *p = nullptr, bool add_ref = true) : ptr(p)
+    {
+        if (ptr && add_ref)
+            intrusive_ptr_add_ref(ptr);
+    }
+    intrusive_ptr(const intrusive_ptr &other) : intrusive_ptr(other.ptr) {}
+    intrusive_ptr(intrusive_ptr &&other) noexcept : ptr(other.ptr) { other.ptr = nullptr; }
+    intrusive_ptr &operator=(intrusive_ptr other) noexcept
+    {
+        std::swap(ptr, other.ptr);
+        return *this;
+    }
+    ~intrusive_ptr()
+    {
+        if (ptr)
+            intrusive_ptr_release(ptr);
+    }
+
+    T *get() const { return ptr; }
+    T &operator*() const { return *ptr; }
+    T *operator->() const { return ptr; }
+    explicit operator bool() const { return ptr != nullptr; }
+
+private:
+    T *ptr;
+};
+
+template <typename T, typename... Args>
+intrusive_ptr<T> make_intrusive(Args &&...args)
+{
+    return intrusive_ptr<T>(new T(std::forward<Args>(args)...));
+}
+#pragma endregion
+
+#pragma region ObjectPool
+/** 类型化对象池
+ *
+ * 每种 T 一个全局池。槽位按 CHUNK 个一组从堆上申请，之后永不归还给堆，只在池内循环使用：
+ *      线程本地缓存：allocate/deallocate 的快路径，不加锁；
+ *      中心空闲链表：本地缓存空了从这里一次取 BATCH 个，本地缓存满了一次还回 BATCH 个，
+ *                   线程退出时本地缓存全部还回，跨线程释放的槽位也因此能回到别的线程。
+ */
+template <typename T>
+class ObjectPool
+{
+    union Slot
+    {
+        Slot *next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+    static const size_t CHUNK = 256;
+    static const size_t BATCH = 32;
+
+public:
+    static ObjectPool &instance()
+    {
+        static ObjectPool pool;
+        return pool;
+    }
+
+    void *allocate()
+    {
+        LocalCache &cache = local();
+        if (cache.slots.empty())
+            refill(cache);
+        Slot *s = cache.slots.back();
+        cache.slots.pop_back();
+        return s;
+    }
+
+    void deallocate(void *p)
+    {
+        LocalCache &cache = local();
+        cache.slots.push_back(static_cast<Slot *>(p));
+        if (cache.slots.size() >= 2 * BATCH)
+            flush(cache, BATCH);
+    }
+
+    template <typename... Args>
+    T *create(Args &&...args)
+    {
+        void *p = allocate();
+        try
+        {
+            return new (p) T(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            deallocate(p);
+            throw;
+        }
+    }
+
+    void destroy(T *p)
+    {
+        p->~T();
+        deallocate(p);
+    }
+
+    // 从堆上申请过的槽位块数，用于统计
+    size_t chunks() const
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        return _chunks.size();
+    }
+
+private:
+    struct LocalCache
+    {
+        std::vector<Slot *> slots;
+        ~LocalCache() { ObjectPool::instance().flush(*this, slots.size()); }
+    };
+
+    ObjectPool() : _free(nullptr) {}
+    ~ObjectPool()
+    {
+        for (Slot *c : _chunks)
+            ::operator delete(c);
+    }
+
+    static LocalCache &local()
+    {
+        thread_local LocalCache cache;
+        return cache;
+    }
+
+    void refill(LocalCache &cache)
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        for (size_t i = 0; i < BATCH; i++)
+        {
+            if (!_free)
+            {
+                Slot *chunk = static_cast<Slot *>(::operator new(CHUNK * sizeof(Slot)));
+                _chunks.push_back(chunk);
+                for (size_t j = 0; j < CHUNK; j++)
+                {
+                    chunk[j].next = _free;
+                    _free = &chunk[j];
+                }
+            }
+            cache.slots.push_back(_free);
+            _free = _free->next;
+        }
+    }
+
+    void flush(LocalCache &cache, size_t count)
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        for (size_t i = 0; i < count; i++)
+        {
+            Slot *s = cache.slots.back();
+            cache.slots.pop_back();
+            s->next = _free;
+            _free = s;
+        }
+    }
+
+    mutable std::mutex _mutex;
+    Slot *_free;
+    std::vector<Slot *> _chunks;
+};
+#pragma endregion
+
+#pragma region pool_unique_ptr / pool_shared_ptr
+template <typename T>
+struct PoolDeleter
+{
+    void operator()(T *p) const { ObjectPool<T>::instance().destroy(p); }
+};
+
+template <typename T>
+using pool_unique_ptr = std::unique_ptr<T, PoolDeleter<T>>;
+
+template <typename T, typename... Args>
+pool_unique_ptr<T> make_pool_unique(Args &&...args)
+{
+    return pool_unique_ptr<T>(ObjectPool<T>::instance().create(std::forward<Args>(args)...));
+}
+
+// 计数和对象在同一个池化槽位中，相当于 make_shared，只是内存来自 ObjectPool 而不是 malloc
+template <typename T>
+class pool_shared_ptr
+{
+    struct Box
+    {
+        std::atomic<long> refs;
+        T value;
+        template <typename... Args>
+        Box(Args &&...args) : refs(1), value(std::forward<Args>(args)...) {}
+    };
+
+public:
+    pool_shared_ptr(std::nullptr_t = nullptr) : box(nullptr) {}
+    pool_shared_ptr(const pool_shared_ptr &other) : box(other.box)
+    {
+        if (box)
+            box->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    pool_shared_ptr(pool_shared_ptr &&other) noexcept : box(other.box) { other.box = nullptr; }
+    pool_shared_ptr &operator=(pool_shared_ptr other) noexcept
+    {
+        std::swap(box, other.box);
+        return *this;
+    }
+    ~pool_shared_ptr()
+    {
+        if (box && box->refs.fetch_sub(1, std::memory_order_release) == 1)
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            ObjectPool<Box>::instance().destroy(box);
+        }
+    }
+
+    T *get() const { return box ? &box->value : nullptr; }
+    T &operator*() const { return box->value; }
+    T *operator->() const { return &box->value; }
+    explicit operator bool() const { return box != nullptr; }
+    long use_count() const { return box ? box->refs.load(std::memory_order_relaxed) : 0; }
+
+    template <typename U, typename... Args>
+    friend pool_shared_ptr<U> make_pool_shared(Args &&...args);
+
+private:
+    explicit pool_shared_ptr(Box *b) : box(b) {}
+    Box *box;
+};
+
+template <typename T, typename... Args>
+pool_shared_ptr<T> make_pool_shared(Args &&...args)
+{
+    typedef typename pool_shared_ptr<T>::Box Box;
+    return pool_shared_ptr<T>(ObjectPool<Box>::instance().create(std::forward<Args>(args)...));
+}
+#pragma endregion
+
+#pragma region 容器的池化版本
+// value 由调用方用 make_pool_shared 创建
+template <typename K, typename V>
+using PooledLRU_Cache = LRU_Cache<K, V, pool_shared_ptr<V>>;
+
+// V 需要继承 RefCounted<V>
+template <typename K, typename V>
+using IntrusiveLRU_Cache = LRU_Cache<K, V, intrusive_ptr<V>>;
+
+// packaged_task 从对象池分配，省掉 make_shared 的那一次 malloc
+struct PoolTaskAlloc
+{
+    template <typename T, typename... Args>
+    static pool_shared_ptr<T> make(Args &&...args) { return make_pool_shared<T>(std::forward<Args>(args)...); }
+};
+
+typedef BasicThreadPool<PoolTaskAlloc> PooledThreadPool;
+#pragma endregion
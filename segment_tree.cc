@@ -1,78 +1,85 @@
 #include <iostream>
-#include <string>
+#include <chrono>
+#include <random>
+#include "segment_tree.h"
 using namespace std;
 
-// 动态开链线段树，以统计区间最大值为例
-// 核心函数是以下几个，对不同的应用场景，需要修改具体实现
-struct Node;
-int query(Node *node, int l, int r);            // 查询一段区间内的值（最大/最小/区间和）
-void addChild(Node *node);                      // 生成一个节点的孩子节点
-void update(Node *node, int l, int r, int val); // 更新一段区间的值，可以加/减，单点操作只需 l==r
-void pushDown(Node *node);                      // 将一个节点的 mask push 到子节点并清零
+// 线段树的核心实现见 segment_tree.h，这里对比逐条操作与批量/并行批量操作的吞吐
+// 编译：g++ -std=c++17 -O2 -pthread segment_tree.cc -o segment_tree
 
-struct Node
+static double seconds(chrono::steady_clock::time_point begin)
 {
-    int left, right;
-    int data, mask; // mask 只表示对孩子节点需要做的操作，不会对本节点造成影响
-    Node *lchild, *rchild;
-    Node(int l, int r) : left(l), right(r), data(0), mask(0), lchild(nullptr), rchild(nullptr) {}
-    ~Node() { delete lchild, rchild; }
-    void addMask(int val) { mask += val; }
-    void clearMask() { mask = 0; }
-    string toString() { return "node: " + to_string(left) + "-" + to_string(right); }
-};
+    return chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+}
 
-void addChild(Node *node)
+static vector<RangeOp> randomOps(int n, int count, int maxVal, mt19937 &rng)
 {
-    if (node->right > node->left && !node->lchild)
+    vector<RangeOp> ops(count);
+    for (auto &op : ops)
     {
-        int mid = node->left + (node->right - node->left) / 2;
-        node->lchild = new Node(node->left, mid);
-        node->rchild = new Node(mid + 1, node->right);
+        int a = rng() % n, b = rng() % n;
+        op = {min(a, b), max(a, b), (int)(rng() % maxVal)};
     }
+    // 日志回放的操作按 l 排好序
+    sort(ops.begin(), ops.end(), [](const RangeOp &x, const RangeOp &y)
+         { return x.l < y.l; });
+    return ops;
 }
 
-int query(Node *node, int l, int r)
+int main(int argc, char const *argv[])
 {
-    if (l > node->right || r < node->left)
-        return -1;
-    if (l <= node->left && r >= node->right)
-        return node->data;
-    addChild(node);
-    pushDown(node); // 在查询的时候懒操作
-    return max(query(node->lchild, l, r), query(node->rchild, l, r));
-}
+    const int n = 1 << 20, count = 200000;
+    mt19937 rng(42);
+    vector<int> arr(n);
+    for (auto &v : arr)
+        v = rng() % 1000;
+    vector<RangeOp> ops = randomOps(n, count, 100, rng);
+    vector<RangeOp> qs = randomOps(n, count, 1, rng);
 
-void update(Node *node, int l, int r, int val)
-{
-    if (l > node->right || r < node->left)
-        return;
-    if (l <= node->left && r >= node->right)
-    {
-        node->data += val;
-        node->mask += val;
-        return;
-    }
-    addChild(node);
-    pushDown(node); // 在更新子节点时，需要先将当前节点的 mask 下放，否则最后对当前节点的值更新就是无效的
-    update(node->lchild, l, r, val);
-    update(node->rchild, l, r, val);
-    node->data = max(node->lchild->data, node->rchild->data);
-}
+    auto begin = chrono::steady_clock::now();
+    Node *one = build(arr);
+    cout << "build " << n << " leaves: " << seconds(begin) << " s" << endl;
+    Node *batch = build(arr);
+    Node *parallel = build(arr);
 
-void pushDown(Node *node)
-{
-    if (node->left == node->right)
-        return;
-    node->lchild->addMask(node->mask);
-    node->rchild->addMask(node->mask);
-    node->lchild->data += node->mask;
-    node->rchild->data += node->mask;
-    node->clearMask();
-}
+    begin = chrono::steady_clock::now();
+    for (auto &op : ops)
+        update(one, op.l, op.r, op.val);
+    double t = seconds(begin);
+    cout << "update one-at-a-time: " << count / t << " ops/s" << endl;
 
-int main(int argc, char const *argv[])
-{
-    Node *root = new Node(0, 1e9);
+    begin = chrono::steady_clock::now();
+    batchUpdate(batch, ops);
+    t = seconds(begin);
+    cout << "update batch:         " << count / t << " ops/s" << endl;
+
+    ThreadPool pool(max(1u, thread::hardware_concurrency())); // hardware_concurrency 未知时为 0
+    begin = chrono::steady_clock::now();
+    parallelUpdate(parallel, ops, pool);
+    t = seconds(begin);
+    cout << "update parallel(" << pool.size() << "):  " << count / t << " ops/s" << endl;
+
+    vector<int> expect(count);
+    begin = chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+        expect[i] = query(one, qs[i].l, qs[i].r);
+    t = seconds(begin);
+    cout << "query one-at-a-time:  " << count / t << " ops/s" << endl;
+
+    begin = chrono::steady_clock::now();
+    vector<int> got = batchQuery(batch, qs);
+    t = seconds(begin);
+    cout << "query batch:          " << count / t << " ops/s" << endl;
+
+    begin = chrono::steady_clock::now();
+    vector<int> gotParallel = parallelQuery(parallel, qs, pool);
+    t = seconds(begin);
+    cout << "query parallel(" << pool.size() << "):   " << count / t << " ops/s" << endl;
+
+    cout << (expect == got && expect == gotParallel ? "results match" : "results MISMATCH") << endl;
+
+    delete one;
+    delete batch;
+    delete parallel;
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,280 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <string>
+#include <vector>
+#include "thread_pool.h"
+
+// 动态开链线段树，以统计区间最大值为例
+// 核心函数是以下几个，对不同的应用场景，需要修改具体实现
+struct Node;
+inline int query(Node *node, int l, int r);            // 查询一段区间内的值（最大/最小/区间和）
+inline void addChild(Node *node);                      // 生成一个节点的孩子节点
+inline void update(Node *node, int l, int r, int val); // 更新一段区间的值，可以加/减，单点操作只需 l==r
+inline void pushDown(Node *node);                      // 将一个节点的 mask push 到子节点并清零
+
+struct Node
+{
+    int left, right;
+    int data, mask; // mask 只表示对孩子节点需要做的操作，不会对本节点造成影响
+    Node *lchild, *rchild;
+    Node(int l, int r) : left(l), right(r), data(0), mask(0), lchild(nullptr), rchild(nullptr) {}
+    ~Node()
+    {
+        // 注意不能写成 delete lchild, rchild; 逗号表达式只会释放 lchild
+        delete lchild;
+        delete rchild;
+    }
+    void addMask(int val) { mask += val; }
+    void clearMask() { mask = 0; }
+    std::string toString() { return "node: " + std::to_string(left) + "-" + std::to_string(right); }
+};
+
+inline void addChild(Node *node)
+{
+    if (node->right > node->left && !node->lchild)
+    {
+        int mid = node->left + (node->right - node->left) / 2;
+        node->lchild = new Node(node->left, mid);
+        node->rchild = new Node(mid + 1, node->right);
+    }
+}
+
+inline int query(Node *node, int l, int r)
+{
+    if (l > node->right || r < node->left)
+        return INT_MIN; // 取最大值的单位元，与 batchQuery 相同；update 可以加负数，不能用 -1
+    if (l <= node->left && r >= node->right)
+        return node->data;
+    addChild(node);
+    pushDown(node); // 在查询的时候懒操作
+    return std::max(query(node->lchild, l, r), query(node->rchild, l, r));
+}
+
+inline void update(Node *node, int l, int r, int val)
+{
+    if (l > node->right || r < node->left)
+        return;
+    if (l <= node->left && r >= node->right)
+    {
+        node->data += val;
+        node->mask += val;
+        return;
+    }
+    addChild(node);
+    pushDown(node); // 在更新子节点时，需要先将当前节点的 mask 下放，否则最后对当前节点的值更新就是无效的
+    update(node->lchild, l, r, val);
+    update(node->rchild, l, r, val);
+    node->data = std::max(node->lchild->data, node->rchild->data);
+}
+
+inline void pushDown(Node *node)
+{
+    if (node->left == node->right)
+        return;
+    node->lchild->addMask(node->mask);
+    node->rchild->addMask(node->mask);
+    node->lchild->data += node->mask;
+    node->rchild->data += node->mask;
+    node->clearMask();
+}
+
+#pragma region 批量操作
+/** 批量建树 / 批量更新 / 批量查询
+ *
+ * 逐条 update 时，每条操作都要从根走到叶子，路径上的 addChild/pushDown 被重复执行。
+ * 批量接口把一组操作一起带着往下走：每个节点只访问一次，只 pushDown 一次，
+ * 完全覆盖当前节点的操作直接合并成一个 mask，只有部分覆盖的操作才继续分给左右孩子。
+ *
+ * 操作最好按 l 升序排列（从日志回放时天然有序），这样分给孩子的子序列依然有序，访存更连续；
+ * 乱序输入结果也正确，只是慢一些。
+ *
+ * 批量查询不修改树：从根往下走时累加祖先的 mask，没有孩子的节点说明整个区间的值都相同，
+ * 因此查询是只读的，可以被多个线程同时执行。
+ */
+struct RangeOp
+{
+    int l, r;
+    int val; // update 时为增量，query 时为结果下标
+};
+
+// O(n) 地从初始数组建树，arr[i] 对应位置 offset + i，叶子全部展开
+inline Node *build(const std::vector<int> &arr, int l, int r, int offset = 0)
+{
+    Node *node = new Node(l, r);
+    if (l == r)
+    {
+        node->data = arr[l - offset];
+        return node;
+    }
+    int mid = l + (r - l) / 2;
+    node->lchild = build(arr, l, mid, offset);
+    node->rchild = build(arr, mid + 1, r, offset);
+    node->data = std::max(node->lchild->data, node->rchild->data);
+    return node;
+}
+
+inline Node *build(const std::vector<int> &arr)
+{
+    return build(arr, 0, (int)arr.size() - 1, 0);
+}
+
+// 把与当前节点相交但不完全覆盖它的操作分成左右两组，完全覆盖的增量累加到 whole
+inline void splitOps(Node *node, const std::vector<RangeOp> &ops, int &whole,
+                     std::vector<RangeOp> &lops, std::vector<RangeOp> &rops)
+{
+    int mid = node->left + (node->right - node->left) / 2;
+    for (const RangeOp &op : ops)
+    {
+        if (op.l > node->right || op.r < node->left)
+            continue;
+        if (op.l <= node->left && op.r >= node->right)
+        {
+            whole += op.val;
+            continue;
+        }
+        if (op.l <= mid)
+            lops.push_back(op);
+        if (op.r > mid)
+            rops.push_back(op);
+    }
+}
+
+inline void batchUpdate(Node *node, const std::vector<RangeOp> &ops)
+{
+    if (ops.empty())
+        return;
+    int whole = 0;
+    std::vector<RangeOp> lops, rops;
+    splitOps(node, ops, whole, lops, rops);
+    if (!lops.empty() || !rops.empty())
+    {
+        addChild(node);
+        pushDown(node);
+        batchUpdate(node->lchild, lops);
+        batchUpdate(node->rchild, rops);
+        node->data = std::max(node->lchild->data, node->rchild->data);
+    }
+    // 与逐条 update 相同的不变式：data = max(孩子 data) + mask
+    node->data += whole;
+    node->mask += whole;
+}
+
+// add 为所有祖先节点尚未下放的 mask 之和
+inline void batchQuery(const Node *node, const std::vector<RangeOp> &qs, int add, std::vector<int> &res)
+{
+    std::vector<RangeOp> lqs, rqs;
+    int mid = node->left + (node->right - node->left) / 2;
+    for (const RangeOp &q : qs)
+    {
+        if (q.l > node->right || q.r < node->left)
+            continue;
+        if ((q.l <= node->left && q.r >= node->right) || !node->lchild)
+        {
+            res[q.val] = std::max(res[q.val], node->data + add);
+            continue;
+        }
+        if (q.l <= mid)
+            lqs.push_back(q);
+        if (q.r > mid)
+            rqs.push_back(q);
+    }
+    if (!lqs.empty())
+        batchQuery(node->lchild, lqs, add + node->mask, res);
+    if (!rqs.empty())
+        batchQuery(node->rchild, rqs, add + node->mask, res);
+}
+
+// 返回与 qs 一一对应的结果，qs[i].val 会被改写为 i
+inline std::vector<int> batchQuery(const Node *root, std::vector<RangeOp> qs)
+{
+    std::vector<int> res(qs.size(), INT_MIN);
+    for (size_t i = 0; i < qs.size(); i++)
+        qs[i].val = (int)i;
+    batchQuery(root, qs, 0, res);
+    return res;
+}
+#pragma endregion
+
+#pragma region 并行批量操作
+/** 按键空间切分到线程池
+ *
+ * 从根往下展开 depth 层，得到 2^depth 棵互不相交的子树；顶部几层由调用线程串行处理
+ * （合并完全覆盖的操作、pushDown、分组），每棵子树的操作交给一个 worker 执行 batchUpdate。
+ * 所有 worker 结束后再自底向上重新计算顶部几层的 data。
+ * 子树之间没有共享节点，因此 worker 之间不需要加锁。
+ */
+// touched 按后序记录被展开的顶部节点及其本批次完全覆盖的增量，孩子一定先于父亲
+inline void dispatchUpdate(Node *node, const std::vector<RangeOp> &ops, int depth, ThreadPool &pool,
+                           std::vector<std::future<void>> &futures, std::vector<std::pair<Node *, int>> &touched)
+{
+    if (ops.empty())
+        return;
+    if (depth == 0 || node->left == node->right)
+    {
+        futures.push_back(pool.enqueue([node, ops]()
+                                       { batchUpdate(node, ops); }));
+        return;
+    }
+    int whole = 0;
+    std::vector<RangeOp> lops, rops;
+    splitOps(node, ops, whole, lops, rops);
+    if (lops.empty() && rops.empty())
+    {
+        node->data += whole;
+        node->mask += whole;
+        return;
+    }
+    addChild(node);
+    pushDown(node);
+    dispatchUpdate(node->lchild, lops, depth - 1, pool, futures, touched);
+    dispatchUpdate(node->rchild, rops, depth - 1, pool, futures, touched);
+    touched.emplace_back(node, whole);
+}
+
+inline int partitionDepth(size_t workers)
+{
+    int depth = 0;
+    // 子树数量取 worker 数的 4 倍左右，避免某棵子树过重导致负载不均
+    while ((size_t(1) << depth) < workers * 4)
+        depth++;
+    return depth;
+}
+
+inline void parallelUpdate(Node *root, const std::vector<RangeOp> &ops, ThreadPool &pool)
+{
+    std::vector<std::future<void>> futures;
+    std::vector<std::pair<Node *, int>> touched;
+    dispatchUpdate(root, ops, partitionDepth(pool.size()), pool, futures, touched);
+    for (auto &f : futures)
+        f.wait();
+    for (auto &t : touched)
+    {
+        Node *node = t.first;
+        node->data = std::max(node->lchild->data, node->rchild->data) + t.second;
+        node->mask += t.second;
+    }
+}
+
+// 查询是只读的，直接把查询按块分给 worker
+inline std::vector<int> parallelQuery(const Node *root, const std::vector<RangeOp> &qs, ThreadPool &pool)
+{
+    std::vector<int> res(qs.size(), INT_MIN);
+    size_t chunks = std::max<size_t>(pool.size(), 1) * 4;
+    size_t step = (qs.size() + chunks - 1) / chunks;
+    std::vector<std::future<void>> futures;
+    for (size_t begin = 0; begin < qs.size(); begin += step)
+    {
+        size_t end = std::min(qs.size(), begin + step);
+        futures.push_back(pool.enqueue([root, &qs, &res, begin, end]()
+                                       {
+            std::vector<RangeOp> part(qs.begin() + begin, qs.begin() + end);
+            for (size_t i = 0; i < part.size(); i++)
+                part[i].val = (int)(begin + i);
+            batchQuery(root, part, 0, res); }));
+    }
+    for (auto &f : futures)
+        f.wait();
+    return res;
+}
+#pragma endregion
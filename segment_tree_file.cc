@@ -0,0 +1,298 @@
+#include <iostream>
+#include <malloc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+#include "segment_tree.h"
+#include "segment_tree_file.h"
+using namespace std;
+
+// 工作进程启动时从原始数据重建线段树 vs mmap 预先写好的树文件：每进程的启动耗时、查询耗时与 RSS / PSS，
+// 以及可写覆盖层上的更新与 segment_tree.h 的结果对照
+// 编译：g++ -std=c++17 -O2 -pthread segment_tree_file.cc -o segment_tree_file
+//
+// PSS 把共享页按共享它的进程数均摊，几个进程映射同一个树文件时 PSS 远小于 RSS；重建的树在各进程的堆中，二者相等
+
+static const int N = 1 << 21;
+static const int WORKERS = 4;
+static const int QUERIES = 200000;
+static const char *RAW_PATH = "/tmp/segment_tree_file.raw";
+static const char *TREE_PATH = "/tmp/segment_tree_file.tree";
+static const char *SAVED_PATH = "/tmp/segment_tree_file.saved";
+
+static double msSince(chrono::steady_clock::time_point t0)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+// /proc/self/status、/proc/self/smaps_rollup 中以 key 开头的一行的值，KB
+static long procKB(const char *path, const char *key)
+{
+    ifstream in(path);
+    string line;
+    size_t n = strlen(key);
+    while (getline(in, line))
+        if (line.compare(0, n, key) == 0)
+            return atol(line.c_str() + n);
+    return -1;
+}
+
+static vector<pair<int, int>> randomRanges(int count, uint32_t seed)
+{
+    mt19937 rng(seed);
+    vector<pair<int, int>> qs(count);
+    for (auto &q : qs)
+    {
+        int a = rng() % N, b = rng() % N;
+        q = {min(a, b), max(a, b)};
+    }
+    return qs;
+}
+
+static vector<int> readRaw()
+{
+    vector<int> arr(N);
+    FILE *f = fopen(RAW_PATH, "rb");
+    if (!f || fread(arr.data(), sizeof(int), N, f) != size_t(N))
+        throw runtime_error(string("cannot read ") + RAW_PATH);
+    fclose(f);
+    return arr;
+}
+
+#pragma region 工作进程
+struct Report
+{
+    double startupMs, queryNs;
+    long rssKB, pssKB;
+    long checksum;
+};
+
+// 父进程关闭写端即放行所有阻塞在读端的子进程
+struct Gate
+{
+    int fd[2];
+    Gate()
+    {
+        if (pipe(fd) != 0)
+            throw runtime_error("pipe");
+    }
+    void wait() const
+    {
+        char c;
+        while (read(fd[0], &c, 1) > 0)
+            ;
+    }
+};
+
+// 子进程：准备好树 → 通知 → 等 go → 查询 → 通知 → 等 measure（此时所有进程都查询完、都还活着）→ 报告 → 等 quit
+static void worker(bool mapped, int notify, int report, const Gate &go, const Gate &measure, const Gate &quit)
+{
+    auto t0 = chrono::steady_clock::now();
+    Node *root = nullptr;
+    unique_ptr<MappedSegmentTree> tree;
+    if (mapped)
+        tree = MappedSegmentTree::open(TREE_PATH);
+    else
+        root = build(readRaw());
+    Report r{msSince(t0), 0, 0, 0, 0};
+    char c = 1;
+    if ((mapped && !tree) || write(notify, &c, 1) != 1)
+        _exit(1);
+    go.wait();
+
+    vector<pair<int, int>> qs = randomRanges(QUERIES, 7);
+    t0 = chrono::steady_clock::now();
+    for (auto &q : qs)
+        r.checksum += mapped ? tree->query(q.first, q.second) : query(root, q.first, q.second);
+    r.queryNs = msSince(t0) * 1e6 / QUERIES;
+    if (write(notify, &c, 1) != 1)
+        _exit(1);
+    measure.wait();
+
+    r.rssKB = procKB("/proc/self/status", "VmRSS:");
+    r.pssKB = procKB("/proc/self/smaps_rollup", "Pss:");
+    if (write(report, &r, sizeof(r)) != ssize_t(sizeof(r)))
+        _exit(1);
+    quit.wait();
+    _exit(0);
+}
+
+static void readAll(int fd, void *buf, size_t n)
+{
+    char *p = static_cast<char *>(buf);
+    while (n > 0)
+    {
+        ssize_t got = read(fd, p, n);
+        if (got <= 0)
+            throw runtime_error("worker exited early");
+        p += got;
+        n -= got;
+    }
+}
+
+// 同时启动 WORKERS 个进程，打印每进程的平均值与全部就绪的墙钟时间；返回各进程查询结果的校验和
+static long run(bool mapped)
+{
+    int notify[2], report[2];
+    if (pipe(notify) != 0 || pipe(report) != 0)
+        throw runtime_error("pipe");
+    Gate go, measure, quit;
+    auto t0 = chrono::steady_clock::now();
+    vector<pid_t> pids;
+    for (int i = 0; i < WORKERS; i++)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            // 子进程必须关掉各个 Gate 的写端，否则父进程关闭后读端也收不到 EOF
+            for (const Gate *g : {&go, &measure, &quit})
+                close(g->fd[1]);
+            close(notify[0]);
+            close(report[0]);
+            worker(mapped, notify[1], report[1], go, measure, quit);
+        }
+        pids.push_back(pid);
+    }
+    close(notify[1]);
+    close(report[1]);
+
+    char c[WORKERS];
+    readAll(notify[0], c, WORKERS);
+    double allReadyMs = msSince(t0);
+    close(go.fd[1]);
+    readAll(notify[0], c, WORKERS);
+    close(measure.fd[1]);
+
+    Report sum{0, 0, 0, 0, 0};
+    long checksum = 0;
+    for (int i = 0; i < WORKERS; i++)
+    {
+        Report r;
+        readAll(report[0], &r, sizeof(r));
+        sum.startupMs += r.startupMs;
+        sum.queryNs += r.queryNs;
+        sum.rssKB += r.rssKB;
+        sum.pssKB += r.pssKB;
+        if (i > 0 && r.checksum != checksum)
+            cout << "checksum mismatch between workers" << endl;
+        checksum = r.checksum;
+    }
+    close(quit.fd[1]);
+    for (pid_t pid : pids)
+        waitpid(pid, nullptr, 0);
+    close(notify[0]);
+    close(report[0]);
+
+    cout << left << setw(10) << (mapped ? "mmap" : "rebuild") << right << fixed << setprecision(1) << setw(12)
+         << sum.startupMs / WORKERS << setw(14) << allReadyMs << setw(10) << sum.queryNs / WORKERS << setw(10)
+         << sum.rssKB / WORKERS / 1024.0 << setw(10) << sum.pssKB / WORKERS / 1024.0 << setw(14) << checksum
+         << defaultfloat << endl;
+    return checksum;
+}
+#pragma endregion
+
+// 在可写覆盖层上做区间更新，与 segment_tree.h 的同一串更新逐个比较查询结果；再 save 成新文件重新打开比较。
+// root 与 path 中的树相同；Private_Dirty 的增量是更新时写时复制的文件页与覆盖层中新节点占用的内存
+static bool overlay(const char *name, Node *root, const char *path)
+{
+    unique_ptr<MappedSegmentTree> tree = MappedSegmentTree::open(path, true);
+    if (!tree)
+        return false;
+    const int UPDATES = 20000, CHECKS = 20000;
+    vector<pair<int, int>> us = randomRanges(UPDATES, 3);
+    long dirtyKB = procKB("/proc/self/smaps_rollup", "Private_Dirty:");
+    auto t0 = chrono::steady_clock::now();
+    for (auto &u : us)
+        tree->update(u.first, u.second, (u.first ^ u.second) % 100);
+    double updateMs = msSince(t0);
+    dirtyKB = procKB("/proc/self/smaps_rollup", "Private_Dirty:") - dirtyKB;
+    for (auto &u : us)
+        update(root, u.first, u.second, (u.first ^ u.second) % 100);
+
+    tree->save(SAVED_PATH);
+    unique_ptr<MappedSegmentTree> saved = MappedSegmentTree::open(SAVED_PATH);
+    int wrong = 0;
+    for (auto &q : randomRanges(CHECKS, 5))
+    {
+        int expected = query(root, q.first, q.second);
+        wrong += tree->query(q.first, q.second) != expected;
+        wrong += !saved || saved->query(q.first, q.second) != expected;
+    }
+    cout << left << setw(8) << name << right << fixed << setprecision(1) << setw(10) << tree->bytes() / 1048576.0
+         << setw(11) << updateMs << setw(11) << tree->overlay_nodes() << setw(10) << dirtyKB / 1024.0 << setw(13)
+         << (saved ? saved->nodes() : 0) << setw(12) << wrong << defaultfloat << endl;
+    return wrong == 0;
+}
+
+int main()
+{
+    mt19937 rng(42);
+    vector<int> arr(N);
+    for (auto &v : arr)
+        v = rng() % 1000;
+    FILE *f = fopen(RAW_PATH, "wb");
+    if (!f || fwrite(arr.data(), sizeof(int), N, f) != size_t(N))
+    {
+        cout << "cannot write " << RAW_PATH << endl;
+        return 1;
+    }
+    fclose(f);
+
+    auto t0 = chrono::steady_clock::now();
+    Node *root = build(arr);
+    double buildMs = msSince(t0);
+    t0 = chrono::steady_clock::now();
+    MappedSegmentTree::save(root, TREE_PATH);
+    double saveMs = msSince(t0);
+    unique_ptr<MappedSegmentTree> tree = MappedSegmentTree::open(TREE_PATH);
+    if (!tree)
+    {
+        cout << "cannot open " << TREE_PATH << endl;
+        return 1;
+    }
+    cout << N << " leaves: build " << fixed << setprecision(1) << buildMs << " ms, save " << saveMs << " ms, file "
+         << tree->nodes() << " nodes, " << tree->bytes() / 1048576.0 << " MB" << defaultfloat << endl;
+
+    int wrong = 0;
+    for (auto &q : randomRanges(20000, 9))
+        wrong += tree->query(q.first, q.second) != query(root, q.first, q.second);
+    cout << "mmap queries vs segment_tree.h: " << wrong << " mismatches" << endl << endl;
+    tree.reset();
+
+    // fork 前释放并把空闲的堆还给内核，否则子进程继承这部分页，RSS / PSS 都偏大
+    delete root;
+    arr = vector<int>();
+    malloc_trim(0);
+
+    cout << WORKERS << " worker processes, " << QUERIES << " random range queries each" << endl;
+    cout << left << setw(10) << "" << right << setw(12) << "startup ms" << setw(14) << "all ready ms" << setw(10)
+         << "query ns" << setw(10) << "RSS MB" << setw(10) << "PSS MB" << setw(14) << "checksum" << endl;
+    if (run(false) != run(true))
+        wrong++;
+    cout << endl;
+
+    // 完整建出的树上更新只改已有节点（写时复制文件页）；只由稀疏更新展开过的树上更新还会在覆盖层中新增节点
+    cout << left << setw(8) << "overlay" << right << setw(10) << "file MB" << setw(11) << "update ms" << setw(11)
+         << "new nodes" << setw(10) << "dirty MB" << setw(13) << "saved nodes" << setw(12) << "mismatches" << endl;
+    root = build(readRaw());
+    bool ok = overlay("full", root, TREE_PATH);
+    delete root;
+    malloc_trim(0); // 否则覆盖层的新节点落在已经是脏页的空闲堆上，不计入增量
+    root = new Node(0, N - 1);
+    for (auto &u : randomRanges(2000, 13))
+        update(root, u.first, u.second, (u.second - u.first) % 100);
+    MappedSegmentTree::save(root, TREE_PATH);
+    ok = overlay("sparse", root, TREE_PATH) && ok;
+    delete root;
+
+    unlink(RAW_PATH);
+    unlink(TREE_PATH);
+    unlink(SAVED_PATH);
+    return ok && wrong == 0 ? 0 : 1;
+}
@@ -0,0 +1,258 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "lookup_tables.h"
+#include "segment_tree.h"
+
+/** segment_tree.h 中线段树的文件格式：建一次树写成文件，各进程 mmap 后直接查询，用法与基准见 segment_tree_file.cc
+ *
+ * 文件布局与映射地址无关，孩子用节点下标而不是 Node* 表示：
+ *      Header            magic "SEGTREE1", version, headerCrc, count（节点数）, 根的区间 [left, right], fileSize，共 64 字节
+ *      FileNode × count  先序排列（左子树紧跟在父节点之后，查询时访存更集中），每个 16 字节：data, mask, lchild, rchild；
+ *                        没有孩子时 lchild 为 0（根的下标为 0，不会是孩子）。节点区间不存，从根往下按 addChild 相同的方式二分
+ *
+ * open 只映射并校验文件头，不读节点，耗时与文件大小无关；只读打开时映射为 MAP_SHARED，
+ * 同一个文件在所有进程中共用页缓存里的同一份物理页。query 直接在映射上进行，
+ * 与 batchQuery 一样累加祖先尚未下放的 mask，不修改节点。
+ *
+ * 可写覆盖层：open(path, true) 映射为 MAP_PRIVATE 可写，update 改到的节点所在的页由内核写时复制为进程私有，
+ * 其余的页仍与其他进程共享；update 需要展开的新节点放在进程内的数组中，下标从 count 开始。
+ * 覆盖层不写回原文件，save 把当前状态（文件 + 覆盖层）写成新文件。
+ */
+class MappedSegmentTree
+{
+public:
+    ~MappedSegmentTree()
+    {
+        if (base)
+            munmap(const_cast<char *>(base), length);
+    }
+
+    MappedSegmentTree(const MappedSegmentTree &) = delete;
+    MappedSegmentTree &operator=(const MappedSegmentTree &) = delete;
+
+    // 把 segment_tree.h 的树写成文件：写到 path.tmp，fsync 后 rename 原子替换
+    static void save(const Node *root, const std::string &path)
+    {
+        std::vector<FileNode> nodes;
+        flatten(root, nodes);
+        write(path, root->left, root->right, nodes);
+    }
+
+    void save(const std::string &path) const
+    {
+        std::vector<FileNode> nodes;
+        flatten(uint32_t(0), nodes);
+        write(path, header().left, header().right, nodes);
+    }
+
+    // 文件不存在或文件头校验失败时返回空
+    static std::unique_ptr<MappedSegmentTree> open(const std::string &path, bool writable = false)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return nullptr;
+        struct stat st;
+        void *map = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(Header))
+            map = writable ? mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0)
+                           : mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED)
+            return nullptr;
+        std::unique_ptr<MappedSegmentTree> tree(new MappedSegmentTree(static_cast<char *>(map), st.st_size, writable));
+        if (!tree->valid())
+            return nullptr;
+        return tree;
+    }
+
+    // [l, r] 的最大值，与区间不相交时为 INT_MIN
+    int query(int l, int r) const { return query(0, header().left, header().right, l, r, 0); }
+
+    // 区间加 val，只能用于可写打开的树
+    void update(int l, int r, int val)
+    {
+        if (!writable)
+            throw std::logic_error("MappedSegmentTree: opened read-only");
+        update(0, header().left, header().right, l, r, val);
+    }
+
+    int left() const { return header().left; }
+    int right() const { return header().right; }
+    size_t nodes() const { return count + extra.size(); }
+    size_t overlay_nodes() const { return extra.size(); }
+    size_t bytes() const { return length; }
+
+private:
+    static constexpr char MAGIC[8] = {'S', 'E', 'G', 'T', 'R', 'E', 'E', '1'};
+    static constexpr uint32_t VERSION = 1;
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerCrc; // 计算时此字段为 0
+        uint64_t count;
+        int32_t left, right;
+        uint64_t fileSize;
+        uint64_t reserved[3];
+    };
+    static_assert(sizeof(Header) == 64, "header layout");
+
+    struct FileNode
+    {
+        int32_t data, mask;
+        uint32_t lchild, rchild;
+    };
+    static_assert(sizeof(FileNode) == 16, "node layout");
+
+    MappedSegmentTree(char *base, size_t length, bool writable) : base(base), length(length), writable(writable) {}
+
+    static uint32_t headerCrc(Header h)
+    {
+        h.headerCrc = 0;
+        return lookup::crc32c(&h, sizeof(h));
+    }
+
+    const Header &header() const { return *reinterpret_cast<const Header *>(base); }
+
+    // 只校验文件头与大小；节点不在启动时扫描，越界的孩子下标在访问时按没有孩子处理
+    bool valid()
+    {
+        const Header &h = header();
+        if (std::memcmp(h.magic, MAGIC, sizeof(h.magic)) || h.version != VERSION || h.headerCrc != headerCrc(h) ||
+            h.fileSize != length || h.count == 0 || h.count >= UINT32_MAX || h.left > h.right ||
+            sizeof(Header) + h.count * sizeof(FileNode) != length)
+            return false;
+        count = h.count;
+        nodes_ = reinterpret_cast<FileNode *>(const_cast<char *>(base) + sizeof(Header));
+        return true;
+    }
+
+    const FileNode &at(uint32_t i) const { return i < count ? nodes_[i] : extra[i - count]; }
+    FileNode &at(uint32_t i) { return i < count ? nodes_[i] : extra[i - count]; }
+
+    bool hasChildren(const FileNode &n) const
+    {
+        size_t total = nodes();
+        return n.lchild && n.lchild < total && n.rchild < total;
+    }
+
+    int query(uint32_t i, int nl, int nr, int l, int r, int add) const
+    {
+        if (l > nr || r < nl)
+            return INT_MIN;
+        const FileNode &n = at(i);
+        if ((l <= nl && r >= nr) || !hasChildren(n))
+            return n.data + add;
+        int mid = nl + (nr - nl) / 2;
+        return std::max(query(n.lchild, nl, mid, l, r, add + n.mask), query(n.rchild, mid + 1, nr, l, r, add + n.mask));
+    }
+
+    // 与 segment_tree.h 的 update 相同：部分覆盖时先展开（addChild）再下放 mask（pushDown）
+    void update(uint32_t i, int nl, int nr, int l, int r, int val)
+    {
+        if (l > nr || r < nl)
+            return;
+        if (l <= nl && r >= nr)
+        {
+            at(i).data += val;
+            at(i).mask += val;
+            return;
+        }
+        if (!hasChildren(at(i)))
+        {
+            // extra 扩容会使引用失效，先追加再通过下标回写
+            uint32_t c = uint32_t(nodes());
+            extra.push_back({0, 0, 0, 0});
+            extra.push_back({0, 0, 0, 0});
+            at(i).lchild = c;
+            at(i).rchild = c + 1;
+        }
+        FileNode &n = at(i);
+        uint32_t lc = n.lchild, rc = n.rchild;
+        at(lc).data += n.mask;
+        at(lc).mask += n.mask;
+        at(rc).data += n.mask;
+        at(rc).mask += n.mask;
+        n.mask = 0;
+        int mid = nl + (nr - nl) / 2;
+        update(lc, nl, mid, l, r, val);
+        update(rc, mid + 1, nr, l, r, val);
+        at(i).data = std::max(at(lc).data, at(rc).data);
+    }
+
+    // 先序展开：先写父节点占位，左子树写完后才知道右孩子的下标
+    static uint32_t flatten(const Node *node, std::vector<FileNode> &out)
+    {
+        uint32_t i = uint32_t(out.size());
+        out.push_back({node->data, node->mask, 0, 0});
+        if (node->lchild)
+        {
+            uint32_t lc = flatten(node->lchild, out);
+            uint32_t rc = flatten(node->rchild, out);
+            out[i].lchild = lc;
+            out[i].rchild = rc;
+        }
+        return i;
+    }
+
+    uint32_t flatten(uint32_t node, std::vector<FileNode> &out) const
+    {
+        uint32_t i = uint32_t(out.size());
+        const FileNode &n = at(node);
+        out.push_back({n.data, n.mask, 0, 0});
+        if (hasChildren(n))
+        {
+            uint32_t lc = flatten(n.lchild, out);
+            uint32_t rc = flatten(n.rchild, out);
+            out[i].lchild = lc;
+            out[i].rchild = rc;
+        }
+        return i;
+    }
+
+    static void write(const std::string &path, int left, int right, const std::vector<FileNode> &nodes)
+    {
+        std::string tmp = path + ".tmp";
+        FILE *f = fopen(tmp.c_str(), "wb");
+        if (!f)
+            throw std::runtime_error("cannot create " + tmp);
+        std::unique_ptr<FILE, int (*)(FILE *)> guard(f, fclose);
+        Header h{};
+        std::memcpy(h.magic, MAGIC, sizeof(h.magic));
+        h.version = VERSION;
+        h.count = nodes.size();
+        h.left = left;
+        h.right = right;
+        h.fileSize = sizeof(Header) + nodes.size() * sizeof(FileNode);
+        h.headerCrc = headerCrc(h);
+        bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+                  fwrite(nodes.data(), sizeof(FileNode), nodes.size(), f) == nodes.size() && fflush(f) == 0 &&
+                  fsync(fileno(f)) == 0;
+        guard.reset();
+        if (!ok || rename(tmp.c_str(), path.c_str()) != 0)
+        {
+            unlink(tmp.c_str());
+            throw std::runtime_error("cannot write " + path);
+        }
+    }
+
+    const char *base;
+    size_t length;
+    bool writable;
+    size_t count = 0;
+    FileNode *nodes_ = nullptr;
+    std::vector<FileNode> extra; // 覆盖层中新展开的节点
+};
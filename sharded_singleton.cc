@@ -0,0 +1,116 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "sharded_singleton.h"
+using namespace std;
+
+// 计数器自增：单例中的 atomic 与按线程、按 CPU 分片的对比
+// 编译：g++ -std=c++17 -O2 -pthread sharded_singleton.cc -o sharded_singleton
+
+struct Metrics
+{
+    atomic<long> requests{0};
+    atomic<long> bytes{0};
+
+    // 线程退出时合并分片
+    Metrics &operator+=(const Metrics &other)
+    {
+        requests.fetch_add(other.requests.load(memory_order_relaxed), memory_order_relaxed);
+        bytes.fetch_add(other.bytes.load(memory_order_relaxed), memory_order_relaxed);
+        return *this;
+    }
+};
+
+// singleton.cc 风格：所有线程共享一个对象
+class MetricsSingleton
+{
+public:
+    static Metrics &getInstance()
+    {
+        static Metrics instance;
+        return instance;
+    }
+};
+
+typedef sharded_singleton<Metrics, void, shard_mode::per_thread> ThreadMetrics;
+typedef sharded_singleton<Metrics, void, shard_mode::per_cpu> CpuMetrics;
+
+// 只有本线程写的分片，不需要原子的读改写
+static inline void bump(atomic<long> &c, long n) { c.store(c.load(memory_order_relaxed) + n, memory_order_relaxed); }
+
+template <typename Record>
+double run(int threads, long iters, Record record)
+{
+    auto begin = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++)
+        workers.emplace_back([&]()
+                             { for (long i = 0; i < iters; i++) record(i); });
+    for (auto &w : workers)
+        w.join();
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count() / (double(threads) * iters);
+}
+
+template <typename Sharded>
+long totalRequests()
+{
+    return Sharded::reduce(0L, [](long acc, const Metrics &m)
+                           { return acc + m.requests.load(memory_order_relaxed); });
+}
+
+int main(int argc, char const *argv[])
+{
+    const long iters = 10000000;
+    int cores = max(1u, thread::hardware_concurrency());
+    cout << "cpus " << cores << ", per_cpu shards " << CpuMetrics::shards() << ", sizeof(shard) "
+         << sizeof(ThreadMetrics::shard) << endl;
+
+    vector<int> counts;
+    for (int t = 1; t < cores * 2; t *= 2)
+        counts.push_back(t);
+    counts.push_back(cores * 2);
+
+    for (int threads : counts)
+    {
+        double shared = run(threads, iters, [](long i)
+                            {
+            Metrics &m = MetricsSingleton::getInstance();
+            m.requests.fetch_add(1, memory_order_relaxed);
+            m.bytes.fetch_add(i & 1023, memory_order_relaxed); });
+        double perThread = run(threads, iters, [](long i)
+                               {
+            Metrics &m = ThreadMetrics::local();
+            bump(m.requests, 1);
+            bump(m.bytes, i & 1023); });
+        double perCpu = run(threads, iters, [](long i)
+                            {
+            Metrics &m = CpuMetrics::local();
+            m.requests.fetch_add(1, memory_order_relaxed);
+            m.bytes.fetch_add(i & 1023, memory_order_relaxed); });
+        cout << threads << " threads, ns/record: singleton atomic " << shared << ", per_thread " << perThread
+             << ", per_cpu " << perCpu << endl;
+    }
+
+    // 线程全部退出后，分片已合并进 retired，总数不丢
+    long expected = 0;
+    for (int threads : counts)
+        expected += threads * iters;
+    cout << "requests: singleton " << MetricsSingleton::getInstance().requests.load() << ", per_thread "
+         << totalRequests<ThreadMetrics>() << " (" << ThreadMetrics::shards() << " live shards), per_cpu "
+         << totalRequests<CpuMetrics>() << ", expected " << expected << endl;
+
+    // 读者在写者运行期间聚合
+    atomic<bool> stop(false);
+    thread writer([&]()
+                  {
+        while (!stop.load(memory_order_relaxed))
+            bump(ThreadMetrics::local().requests, 1); });
+    long first = totalRequests<ThreadMetrics>();
+    this_thread::sleep_for(chrono::milliseconds(50));
+    long second = totalRequests<ThreadMetrics>();
+    stop = true;
+    writer.join();
+    cout << "live aggregation: +" << second - first << " requests in 50 ms while the writer was running" << endl;
+    return 0;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <sched.h>
+#include <unistd.h>
+#include <memory>
+#include "layout.h"
+#include "singleton.h"
+
+/** 按线程或按 CPU 分片的全局服务（指标、配置、分配器统计等），用法与基准见 sharded_singleton.cc
+ *
+ * singleton.cc 风格的单例只有一个对象，所有线程写同一处，计数器所在的 cache line 在核之间来回迁移。
+ * sharded_singleton 给每个线程（per_thread）或每个 CPU（per_cpu）一个独占 cache line 的分片：
+ *      写者只写自己的分片，没有竞争；读者调用 reduce 把所有分片合并起来，读到的是一个近似的瞬时值。
+ *
+ *      per_thread  就是 singleton.h 中的 thread_local_singleton，实例换成 cache_padded<T>：
+ *                  线程第一次访问时登记，退出时合并进 retired，分片只有所属线程会写，T 的字段用 atomic 的 relaxed load + store 即可；
+ *      per_cpu     分片数等于 CPU 数，sched_getcpu 选择分片（glibc 2.35 起直接读 rseq 中的 cpu_id，不陷入内核），
+ *                  线程可能在读到 CPU 号之后被迁移，同一个分片偶尔会被多个线程写，所以写入需要原子的读改写；
+ *                  分片数量与线程数无关，线程频繁创建销毁时没有登记开销。
+ */
+
+enum class shard_mode
+{
+    per_thread,
+    per_cpu,
+};
+
+template <typename T, typename Tag = void, shard_mode Mode = shard_mode::per_thread, typename Merge = merge_add>
+class sharded_singleton
+{
+public:
+    typedef cache_padded<T> shard;
+
+    static T &local()
+    {
+        if constexpr (Mode == shard_mode::per_cpu)
+        {
+            CpuShards &c = cpuShards();
+            int cpu = sched_getcpu();
+            return c.shards[cpu < 0 ? 0 : size_t(cpu) % c.count].value;
+        }
+        else
+            return ThreadShards::local().value;
+    }
+
+    // f(acc, const T &) -> acc，遍历所有分片
+    template <typename R, typename F>
+    static R reduce(R init, F f)
+    {
+        if constexpr (Mode == shard_mode::per_cpu)
+        {
+            CpuShards &c = cpuShards();
+            for (size_t i = 0; i < c.count; i++)
+                init = f(init, c.shards[i].value);
+        }
+        else
+            init = ThreadShards::reduce(init, [&f](R acc, const shard &s)
+                                        { return f(acc, s.value); });
+        return init;
+    }
+
+    // 当前的分片数：per_thread 为存活的线程数，per_cpu 为 CPU 数
+    static size_t shards()
+    {
+        if constexpr (Mode == shard_mode::per_cpu)
+            return cpuShards().count;
+        else
+            return ThreadShards::threads();
+    }
+
+private:
+#pragma region per_cpu
+    struct CpuShards
+    {
+        size_t count;
+        std::unique_ptr<shard[]> shards;
+        CpuShards()
+        {
+            long n = sysconf(_SC_NPROCESSORS_CONF);
+            count = n > 0 ? size_t(n) : 1;
+            shards.reset(new shard[count]()); // 值初始化，atomic 成员清零
+        }
+    };
+
+    static CpuShards &cpuShards()
+    {
+        static CpuShards c;
+        return c;
+    }
+#pragma endregion
+
+#pragma region per_thread
+    struct MergeShard
+    {
+        void operator()(shard &into, const shard &from) const { Merge()(into.value, from.value); }
+    };
+
+    // 以 sharded_singleton 自身为 Tag，不同的 sharded_singleton 各有一套登记表
+    typedef thread_local_singleton<shard, sharded_singleton, MergeShard> ThreadShards;
+#pragma endregion
+};
@@ -1,11 +1,19 @@
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/signalfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 /* 什么是信号驱动IO？
 
@@ -37,7 +45,8 @@ void do_sometime(int signal)
     sendto(socket_fd, buffer, len, 0, (struct sockaddr *)&cli_addr, clilen);
 }
 
-int main(int argc, char const *argv[])
+// 原来的回显服务：端口 8888，每个 SIGIO 读一个数据报
+static int sigio_server()
 {
     socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
 
@@ -78,6 +87,372 @@ int main(int argc, char const *argv[])
     return 0;
 }
 
+/* 排队的实时信号 + signalfd
+
+上面的方式有两个问题：
+    * SIGIO 是标准信号，不排队：处理函数还没运行时到达的多个数据报只产生一次 SIGIO，
+      而 do_sometime 每次只读一个数据报，其余的留在套接字缓冲区里，缓冲区满后新到的数据报被内核丢弃；
+    * SIGIO 不携带是哪个 fd 就绪，一个进程有多个套接字时只能挨个去读。
+
+改进：
+    1. fcntl(fd, F_SETSIG, sig) 把就绪通知换成实时信号 sig。实时信号排队，每个事件一个，siginfo 中的 si_fd 就是就绪的 fd；
+    2. 在所有线程中屏蔽 sig，用 signalfd 在普通的循环中读取信号，不再有信号处理函数里能做什么的限制；
+    3. 每次收到通知，用 recvmmsg 一批一批地把 si_fd 读到 EAGAIN，同一批信号中重复的 fd 只读一次；
+    4. 实时信号队列（RLIMIT_SIGPENDING）溢出时内核改发一个 SIGIO，收到 SIGIO 就把所有套接字都读一遍。
+*/
+
+static const int DRAIN_BATCH = 32;
+static const int DATAGRAM = 2048;
+
+// 把 fd 的就绪通知改为实时信号 sig，必须在 fd 收到数据之前、在所有线程屏蔽 sig 之后调用
+static int enable_rtsig(int fd, int sig)
+{
+    if (fcntl(fd, F_SETOWN, getpid()) < 0 || fcntl(fd, F_SETSIG, sig) < 0)
+        return -1;
+    return fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK | O_ASYNC);
+}
+
+// 屏蔽 sig 与 SIGIO（溢出通知）并返回读取它们的 signalfd；屏蔽要在创建其他线程之前，否则信号可能投递给没有屏蔽的线程
+static int open_rtsig_fd(int sig)
+{
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, sig);
+    sigaddset(&mask, SIGIO);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    return signalfd(-1, &mask, SFD_CLOEXEC | SFD_NONBLOCK);
+}
+
+// 一次 recvmmsg 的缓冲区
+struct DrainBuffer
+{
+    char data[DRAIN_BATCH][DATAGRAM];
+    struct iovec iov[DRAIN_BATCH];
+    struct sockaddr_in peers[DRAIN_BATCH];
+    struct mmsghdr msgs[DRAIN_BATCH];
+};
+
+// 把 fd 读到 EAGAIN，每批调用一次 on_batch(fd, msgs, n)，返回读到的数据报数
+template <typename F>
+static long drain(int fd, DrainBuffer &b, F &&on_batch)
+{
+    long total = 0;
+    for (;;)
+    {
+        for (int i = 0; i < DRAIN_BATCH; i++)
+        {
+            b.iov[i].iov_base = b.data[i];
+            b.iov[i].iov_len = DATAGRAM;
+            memset(&b.msgs[i].msg_hdr, 0, sizeof(b.msgs[i].msg_hdr));
+            b.msgs[i].msg_hdr.msg_iov = &b.iov[i];
+            b.msgs[i].msg_hdr.msg_iovlen = 1;
+            b.msgs[i].msg_hdr.msg_name = &b.peers[i];
+            b.msgs[i].msg_hdr.msg_namelen = sizeof(b.peers[i]);
+        }
+        int n = recvmmsg(fd, b.msgs, DRAIN_BATCH, MSG_DONTWAIT, NULL);
+        if (n <= 0)
+            return total;
+        on_batch(fd, b.msgs, n);
+        total += n;
+        if (n < DRAIN_BATCH)
+            return total;
+    }
+}
+
+// 等待最多 timeout_ms，处理这期间排队的所有信号，返回读到的数据报数；sfd 为空时返回 0
+template <typename F>
+static long rtsig_poll(int sfd, const std::vector<int> &fds, DrainBuffer &b, int timeout_ms, F &&on_batch)
+{
+    struct pollfd pfd = {sfd, POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) <= 0)
+        return 0;
+    struct signalfd_siginfo infos[64];
+    ssize_t bytes = read(sfd, infos, sizeof(infos));
+    if (bytes <= 0)
+        return 0;
+    int n = bytes / sizeof(infos[0]);
+    long total = 0;
+    std::vector<int> done;
+    for (int i = 0; i < n; i++)
+    {
+        if (infos[i].ssi_signo == SIGIO)
+        {
+            // 实时信号队列溢出，不知道哪些 fd 就绪
+            for (int fd : fds)
+                total += drain(fd, b, on_batch);
+            continue;
+        }
+        int fd = infos[i].ssi_fd;
+        if (std::find(done.begin(), done.end(), fd) != done.end())
+            continue;
+        done.push_back(fd);
+        total += drain(fd, b, on_batch);
+    }
+    return total;
+}
+
+// 实时信号版本的回显服务：端口 8888 起的 n 个套接字
+static int rtsig_server(int n)
+{
+    int sig = SIGRTMIN + 1;
+    int sfd = open_rtsig_fd(sig);
+    std::vector<int> fds;
+    for (int i = 0; i < n; i++)
+    {
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        struct sockaddr_in servaddr;
+        memset(&servaddr, 0, sizeof(servaddr));
+        servaddr.sin_family = AF_INET;
+        servaddr.sin_port = htons(8888 + i);
+        servaddr.sin_addr.s_addr = INADDR_ANY;
+        if (bind(fd, (struct sockaddr *)&servaddr, sizeof(servaddr)) < 0 || enable_rtsig(fd, sig) < 0)
+        {
+            perror("bind / F_SETSIG");
+            return 1;
+        }
+        fds.push_back(fd);
+    }
+    DrainBuffer *b = new DrainBuffer;
+    // 原样发回：收到的 msgs 直接作为 sendmmsg 的参数，msg_name 已经是对端地址
+    auto echo = [](int fd, struct mmsghdr *msgs, int count)
+    {
+        for (int i = 0; i < count; i++)
+            msgs[i].msg_hdr.msg_iov->iov_len = msgs[i].msg_len;
+        sendmmsg(fd, msgs, count, 0);
+    };
+    while (1)
+        rtsig_poll(sfd, fds, *b, -1, echo);
+}
+
+/* 基准：SIGIO + 每次读一个（do_sometime） vs SIGIO + 读到 EAGAIN vs 实时信号 + signalfd
+
+发送线程按突发（BURST 个连发，然后停 GAP_US）向服务端套接字发送带发送时间戳的数据报，
+服务端套接字的接收缓冲区设得较小（SMALL_RCVBUF），便于观察溢出：
+    delivered   被处理的数据报
+    stranded    发送结束、空闲一段时间后仍留在缓冲区里没被读的（SIGIO 不会再来）
+    dropped     缓冲区满被内核丢弃的 = sent - delivered - stranded
+Linux 只在上一次读操作遇到过 EAGAIN 之后才为新到的数据发 SIGIO（SOCK_ASYNC_WAITDATA），
+do_sometime 那样每次只读一个、从不读到 EAGAIN，第一个信号之后就再也收不到通知，数据全部滞留或被丢弃。
+latency 为发送到被读出的时间。单核机器上发送线程与处理方抢同一个 CPU，延迟包含调度等待。
+*/
+static const long PACKETS = 200000;
+static const int BURST = 64;
+static const int GAP_US = 100;
+static const int SMALL_RCVBUF = 32 << 10;
+
+static long now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+struct BenchResult
+{
+    long delivered, stranded, dropped;
+    double p50_us, p99_us, max_us;
+};
+
+// 处理方记录的延迟，信号处理函数中也会写，预先分配好
+static long *latencies = NULL;
+static std::atomic<long> delivered_count(0);
+static std::vector<int> bench_fds;
+
+static void record(const char *data)
+{
+    long sent;
+    memcpy(&sent, data, sizeof(sent));
+    long i = delivered_count.load(std::memory_order_relaxed);
+    if (i < PACKETS)
+        latencies[i] = now_ns() - sent;
+    delivered_count.store(i + 1, std::memory_order_relaxed);
+}
+
+// 与 do_sometime 相同：每个信号只读一个数据报
+static void one_per_signal(int)
+{
+    int saved = errno;
+    char buffer[DATAGRAM];
+    if (recv(bench_fds[0], buffer, sizeof(buffer), MSG_DONTWAIT) >= (ssize_t)sizeof(long))
+        record(buffer);
+    errno = saved;
+}
+
+// 与 bench.cc 中的 echoOnSigio 相同：读到 EAGAIN；但只有一个套接字时才知道该读哪个
+static void drain_per_signal(int)
+{
+    int saved = errno;
+    char buffer[DATAGRAM];
+    ssize_t n;
+    while ((n = recv(bench_fds[0], buffer, sizeof(buffer), MSG_DONTWAIT)) >= 0)
+        if (n >= (ssize_t)sizeof(long))
+            record(buffer);
+    errno = saved;
+}
+
+static int bench_socket(struct sockaddr_in &addr)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (struct sockaddr *)&addr, &len);
+    int rcvbuf = SMALL_RCVBUF;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    return fd;
+}
+
+// 发送线程：在各个套接字之间轮流，每个突发发给同一个套接字
+static void sender(const std::vector<struct sockaddr_in> &addrs, std::atomic<bool> &finished)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    char msg[200] = {0};
+    for (long i = 0; i < PACKETS; i++)
+    {
+        const struct sockaddr_in &to = addrs[(i / BURST) % addrs.size()];
+        long t = now_ns();
+        memcpy(msg, &t, sizeof(t));
+        sendto(fd, msg, sizeof(msg), 0, (const struct sockaddr *)&to, sizeof(to));
+        if ((i + 1) % BURST == 0)
+            usleep(GAP_US);
+    }
+    close(fd);
+    finished.store(true);
+}
+
+static BenchResult finish_bench()
+{
+    BenchResult r;
+    r.delivered = std::min(delivered_count.load(), PACKETS);
+    r.stranded = 0;
+    char buffer[DATAGRAM];
+    for (int fd : bench_fds)
+    {
+        while (recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT) >= 0)
+            r.stranded++;
+        close(fd);
+    }
+    r.dropped = PACKETS - r.delivered - r.stranded;
+    std::sort(latencies, latencies + r.delivered);
+    r.p50_us = r.delivered ? latencies[r.delivered / 2] / 1000.0 : 0;
+    r.p99_us = r.delivered ? latencies[r.delivered * 99 / 100] / 1000.0 : 0;
+    r.max_us = r.delivered ? latencies[r.delivered - 1] / 1000.0 : 0;
+    bench_fds.clear();
+    delivered_count = 0;
+    return r;
+}
+
+// 信号处理函数的两种写法，只有一个套接字
+static BenchResult bench_sigio(void (*handler)(int))
+{
+    struct sockaddr_in addr;
+    bench_fds.push_back(bench_socket(addr));
+
+    struct sigaction act, old;
+    memset(&act, 0, sizeof(act));
+    act.sa_handler = handler;
+    sigaction(SIGIO, &act, &old);
+    fcntl(bench_fds[0], F_SETOWN, getpid());
+    fcntl(bench_fds[0], F_SETFL, fcntl(bench_fds[0], F_GETFL, 0) | O_NONBLOCK | O_ASYNC);
+
+    // 发送线程屏蔽 SIGIO，信号只投递给主线程
+    sigset_t mask, saved;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGIO);
+    pthread_sigmask(SIG_BLOCK, &mask, &saved);
+    std::atomic<bool> finished(false);
+    std::vector<struct sockaddr_in> addrs(1, addr);
+    std::thread t([&]()
+                  { sender(addrs, finished); });
+    pthread_sigmask(SIG_SETMASK, &saved, NULL);
+    while (!finished)
+        usleep(1000); // 被 SIGIO 打断后继续等
+    t.join();
+    usleep(50000);
+
+    fcntl(bench_fds[0], F_SETFL, fcntl(bench_fds[0], F_GETFL, 0) & ~O_ASYNC);
+    sigaction(SIGIO, &old, NULL);
+    return finish_bench();
+}
+
+static BenchResult bench_rtsig(int sockets)
+{
+    int sig = SIGRTMIN + 1;
+    int sfd = open_rtsig_fd(sig); // 在创建发送线程之前屏蔽
+    std::vector<struct sockaddr_in> addrs(sockets);
+    for (int i = 0; i < sockets; i++)
+    {
+        bench_fds.push_back(bench_socket(addrs[i]));
+        enable_rtsig(bench_fds[i], sig);
+    }
+    DrainBuffer *b = new DrainBuffer;
+    auto on_batch = [](int, struct mmsghdr *msgs, int n)
+    {
+        for (int i = 0; i < n; i++)
+            if (msgs[i].msg_len >= sizeof(long))
+                record((const char *)msgs[i].msg_hdr.msg_iov->iov_base);
+    };
+    std::atomic<bool> finished(false);
+    std::thread t([&]()
+                  { sender(addrs, finished); });
+    while (!finished)
+        rtsig_poll(sfd, bench_fds, *b, 10, on_batch);
+    t.join();
+    // 处理剩下的通知，直到空闲 50ms
+    while (rtsig_poll(sfd, bench_fds, *b, 50, on_batch) > 0)
+        ;
+    BenchResult r = finish_bench();
+    close(sfd);
+    delete b;
+
+    // 丢弃还在排队的信号，恢复屏蔽字，不影响下一轮
+    struct timespec zero = {0, 0};
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, sig);
+    sigaddset(&mask, SIGIO);
+    while (sigtimedwait(&mask, NULL, &zero) > 0)
+        ;
+    pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+    return r;
+}
+
+static void print_result(const char *name, const BenchResult &r)
+{
+    printf("%-34s %10ld %10ld %10ld %10.1f %10.1f %10.1f\n", name, r.delivered, r.stranded, r.dropped, r.p50_us,
+           r.p99_us, r.max_us);
+}
+
+static int benchmark()
+{
+    latencies = new long[PACKETS];
+    printf("%ld packets of 200 B, bursts of %d every %d us, server SO_RCVBUF %d KB\n", PACKETS, BURST, GAP_US,
+           SMALL_RCVBUF >> 10);
+    printf("%-34s %10s %10s %10s %10s %10s %10s\n", "", "delivered", "stranded", "dropped", "p50 us", "p99 us",
+           "max us");
+    print_result("SIGIO, one read per signal", bench_sigio(one_per_signal));
+    print_result("SIGIO, read until EAGAIN", bench_sigio(drain_per_signal));
+    print_result("RT signal + signalfd, 1 socket", bench_rtsig(1));
+    print_result("RT signal + signalfd, 16 sockets", bench_rtsig(16));
+    delete[] latencies;
+    return 0;
+}
+
+// 用法：signal_driven_io             运行基准
+//       signal_driven_io sigio       原来的 SIGIO 回显服务（端口 8888）
+//       signal_driven_io rtsig [n]   实时信号 + signalfd 的回显服务（端口 8888 起的 n 个套接字）
+// 编译：g++ -std=c++17 -O2 -pthread signal_driven_io.cc -o signal_driven_io
+int main(int argc, char const *argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "sigio") == 0)
+        return sigio_server();
+    if (argc > 1 && strcmp(argv[1], "rtsig") == 0)
+        return rtsig_server(argc > 2 ? atoi(argv[2]) : 1);
+    return benchmark();
+}
+
 /* Tcp / Udp
 
 以下条件均会导致对一个 TCP 套接字产生SIGIO信号：
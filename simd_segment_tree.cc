@@ -0,0 +1,307 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <immintrin.h>
+#include "segment_tree.h"
+using namespace std;
+
+// 叶子为数据块的线段树，块内的部分区间操作使用 SIMD（区间加、区间最大值）
+// 编译：g++ -std=c++17 -O2 -pthread simd_segment_tree.cc -o simd_segment_tree
+// 不需要 -mavx2，AVX2/SSE4.1 内核通过 target 属性单独编译，运行时按 CPUID 选择
+
+/** 为什么要把叶子换成块？
+ *
+ * 一值一叶的线段树在底部几层，每次只处理两三个元素就要做一次指针跳转，
+ * 对稠密数据来说 cache miss 与分支才是主要开销。
+ * 这里把数据按 B（64~256）个一组存成连续数组，线段树只索引每个块的摘要（块最大值），
+ * 一个区间操作被拆成：两端的部分块用 SIMD 内核直接扫描/修改，中间的整块交给块上的线段树。
+ *
+ * 块上的线段树使用“标记永久化”：add 留在节点上不下放，
+ *      mx[node] = max(mx[左], mx[右]) + add[node]
+ * 某个块中元素的真实值 = vals[i] + 从根到该块叶子路径上所有 add 之和。
+ */
+
+#pragma region SIMD 内核
+// 返回 p[0..len) 的最大值，len > 0
+typedef int (*MaxKernel)(const int *p, int len);
+// p[0..len) 每个元素加 v
+typedef void (*AddKernel)(int *p, int len, int v);
+
+static int maxScalar(const int *p, int len)
+{
+    int res = p[0];
+    for (int i = 1; i < len; i++)
+        res = max(res, p[i]);
+    return res;
+}
+
+static void addScalar(int *p, int len, int v)
+{
+    for (int i = 0; i < len; i++)
+        p[i] += v;
+}
+
+__attribute__((target("sse4.1"))) static int maxSse41(const int *p, int len)
+{
+    int i = 0, res = p[0];
+    if (len >= 4)
+    {
+        __m128i acc = _mm_loadu_si128((const __m128i *)p);
+        for (i = 4; i + 4 <= len; i += 4)
+            acc = _mm_max_epi32(acc, _mm_loadu_si128((const __m128i *)(p + i)));
+        acc = _mm_max_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+        acc = _mm_max_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+        res = _mm_cvtsi128_si32(acc);
+    }
+    for (; i < len; i++)
+        res = max(res, p[i]);
+    return res;
+}
+
+__attribute__((target("sse4.1"))) static void addSse41(int *p, int len, int v)
+{
+    __m128i inc = _mm_set1_epi32(v);
+    int i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        __m128i *q = (__m128i *)(p + i);
+        _mm_storeu_si128(q, _mm_add_epi32(_mm_loadu_si128(q), inc));
+    }
+    for (; i < len; i++)
+        p[i] += v;
+}
+
+__attribute__((target("avx2"))) static int maxAvx2(const int *p, int len)
+{
+    int i = 0, res = p[0];
+    if (len >= 8)
+    {
+        __m256i acc = _mm256_loadu_si256((const __m256i *)p);
+        for (i = 8; i + 8 <= len; i += 8)
+            acc = _mm256_max_epi32(acc, _mm256_loadu_si256((const __m256i *)(p + i)));
+        __m128i half = _mm_max_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        half = _mm_max_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+        half = _mm_max_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+        res = _mm_cvtsi128_si32(half);
+    }
+    for (; i < len; i++)
+        res = max(res, p[i]);
+    return res;
+}
+
+__attribute__((target("avx2"))) static void addAvx2(int *p, int len, int v)
+{
+    __m256i inc = _mm256_set1_epi32(v);
+    int i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        __m256i *q = (__m256i *)(p + i);
+        _mm256_storeu_si256(q, _mm256_add_epi32(_mm256_loadu_si256(q), inc));
+    }
+    for (; i < len; i++)
+        p[i] += v;
+}
+
+struct Kernels
+{
+    const char *name;
+    MaxKernel max;
+    AddKernel add;
+};
+
+static Kernels detectKernels()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return {"avx2", maxAvx2, addAvx2};
+    if (__builtin_cpu_supports("sse4.1"))
+        return {"sse4.1", maxSse41, addSse41};
+    return {"scalar", maxScalar, addScalar};
+}
+#pragma endregion
+
+class BlockedSegmentTree
+{
+public:
+    // blockSize 建议 64~256，values 的下标即位置
+    BlockedSegmentTree(const vector<int> &values, int blockSize, Kernels kernels = detectKernels())
+        : n((int)values.size()), B(blockSize), nb((n + blockSize - 1) / blockSize), k(kernels), vals(values)
+    {
+        size = 1;
+        while (size < nb)
+            size <<= 1;
+        mx.assign(2 * size, INT_MIN);
+        add.assign(2 * size, 0);
+        for (int b = 0; b < nb; b++)
+            mx[size + b] = k.max(&vals[b * B], blockLen(b));
+        for (int i = size - 1; i > 0; i--)
+            mx[i] = max(mx[2 * i], mx[2 * i + 1]);
+    }
+
+    int query(int l, int r) const
+    {
+        int bl = l / B, br = r / B;
+        if (bl == br)
+            return partialMax(bl, l, r);
+        int res = max(partialMax(bl, l, bl * B + blockLen(bl) - 1), partialMax(br, br * B, r));
+        if (bl + 1 <= br - 1)
+            res = max(res, queryBlocks(1, 0, size - 1, bl + 1, br - 1));
+        return res;
+    }
+
+    void update(int l, int r, int val)
+    {
+        int bl = l / B, br = r / B;
+        if (bl == br)
+        {
+            partialAdd(bl, l, r, val);
+            return;
+        }
+        partialAdd(bl, l, bl * B + blockLen(bl) - 1, val);
+        partialAdd(br, br * B, r, val);
+        if (bl + 1 <= br - 1)
+            updateBlocks(1, 0, size - 1, bl + 1, br - 1, val);
+    }
+
+    const char *kernelName() const { return k.name; }
+
+private:
+    int blockLen(int b) const { return min(B, n - b * B); }
+
+    // 块 b 所有祖先（含叶子本身）上的 add 之和
+    int pathAdd(int b) const
+    {
+        int res = 0;
+        for (int i = size + b; i > 0; i >>= 1)
+            res += add[i];
+        return res;
+    }
+
+    int partialMax(int b, int l, int r) const
+    {
+        if (l == b * B && r == b * B + blockLen(b) - 1)
+            return mx[size + b] - add[size + b] + pathAdd(b);
+        return k.max(&vals[l], r - l + 1) + pathAdd(b);
+    }
+
+    void partialAdd(int b, int l, int r, int val)
+    {
+        if (l == b * B && r == b * B + blockLen(b) - 1)
+        {
+            updateBlocks(1, 0, size - 1, b, b, val);
+            return;
+        }
+        k.add(&vals[l], r - l + 1, val);
+        int i = size + b;
+        mx[i] = k.max(&vals[b * B], blockLen(b)) + add[i];
+        for (i >>= 1; i > 0; i >>= 1)
+            mx[i] = max(mx[2 * i], mx[2 * i + 1]) + add[i];
+    }
+
+    int queryBlocks(int node, int nl, int nr, int l, int r) const
+    {
+        if (l <= nl && r >= nr)
+            return mx[node];
+        int mid = (nl + nr) / 2, res = INT_MIN;
+        if (l <= mid)
+            res = max(res, queryBlocks(2 * node, nl, mid, l, r));
+        if (r > mid)
+            res = max(res, queryBlocks(2 * node + 1, mid + 1, nr, l, r));
+        return res + add[node];
+    }
+
+    void updateBlocks(int node, int nl, int nr, int l, int r, int val)
+    {
+        if (l <= nl && r >= nr)
+        {
+            mx[node] += val;
+            add[node] += val;
+            return;
+        }
+        int mid = (nl + nr) / 2;
+        if (l <= mid)
+            updateBlocks(2 * node, nl, mid, l, r, val);
+        if (r > mid)
+            updateBlocks(2 * node + 1, mid + 1, nr, l, r, val);
+        mx[node] = max(mx[2 * node], mx[2 * node + 1]) + add[node];
+    }
+
+private:
+    int n, B, nb, size;
+    Kernels k;
+    vector<int> vals;    // 原始数据，不含块上线段树的 add
+    vector<int> mx, add; // 块上线段树，叶子 size + b 对应块 b
+};
+
+static double seconds(chrono::steady_clock::time_point begin)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+}
+
+struct Op
+{
+    int l, r, val;
+    bool isQuery;
+};
+
+int main(int argc, char const *argv[])
+{
+    const int n = 1 << 22, count = 500000;
+    mt19937 rng(3);
+    vector<int> arr(n);
+    for (auto &v : arr)
+        v = rng() % 1000000;
+    // 稠密数据上的短区间操作最能体现底层的差别，这里区间长度取 1~4096
+    vector<Op> ops(count);
+    for (auto &op : ops)
+    {
+        op.l = rng() % n;
+        op.r = min(n - 1, op.l + (int)(rng() % 4096));
+        op.val = rng() % 100;
+        op.isQuery = rng() % 2;
+    }
+
+    Node *root = build(arr);
+    vector<int> expect;
+    expect.reserve(count);
+    auto begin = chrono::steady_clock::now();
+    for (auto &op : ops)
+    {
+        if (op.isQuery)
+            expect.push_back(query(root, op.l, op.r));
+        else
+            update(root, op.l, op.r, op.val);
+    }
+    cout << "one value per leaf:     " << count / seconds(begin) << " ops/s" << endl;
+    delete root;
+
+    vector<Kernels> variants = {{"scalar", maxScalar, addScalar}};
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1"))
+        variants.push_back({"sse4.1", maxSse41, addSse41});
+    if (__builtin_cpu_supports("avx2"))
+        variants.push_back({"avx2", maxAvx2, addAvx2});
+    cout << "runtime dispatch picks: " << detectKernels().name << endl;
+
+    for (int blockSize : {64, 128, 256})
+    {
+        for (const Kernels &k : variants)
+        {
+            BlockedSegmentTree tree(arr, blockSize, k);
+            vector<int> got;
+            got.reserve(count);
+            begin = chrono::steady_clock::now();
+            for (auto &op : ops)
+            {
+                if (op.isQuery)
+                    got.push_back(tree.query(op.l, op.r));
+                else
+                    tree.update(op.l, op.r, op.val);
+            }
+            double t = seconds(begin);
+            cout << "block " << blockSize << " " << k.name << ":\t" << count / t << " ops/s"
+                 << (got == expect ? "" : "  results MISMATCH") << endl;
+        }
+    }
+    return 0;
+}
@@ -1,8 +1,15 @@
 #include <iostream>
+#include <chrono>
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "singleton.h"
 
 using namespace std;
 
+// 编译：g++ -std=c++20 -O2 -pthread singleton.cc -o singleton
+
 /**
  * C++ 11 标准做法，c++11 局部静态变量已经是线性安全了
  * 通过局部 static 变量只能初始化一次的特性，实现单例
@@ -25,6 +32,8 @@ private:
 /**
  * 普通懒汉式（Lazy Singleton）
  * 在第一次使用时才进行初始化，这叫做延时初始化
+ * 注意：多个线程同时第一次调用时，对 instance 的读写存在数据竞争，可能创建出多个实例，
+ * 下面的 LazyUnique、LazyEmbeded 也一样；线程安全的懒汉式见 singleton.h 中的 lazy_singleton
  */
 class NormalLazy
 {
@@ -118,8 +127,97 @@ private:
 LazyEmbeded *LazyEmbeded::instance = nullptr;
 LazyEmbeded::Deletor LazyEmbeded::deletor;
 
+#pragma region 基准
+struct Config
+{
+    int value = 1;
+};
+
+// 与 Singleton 相同的局部 static 写法
+struct MeyersConfig
+{
+    static Config &getInstance()
+    {
+        static Config instance;
+        return instance;
+    }
+};
+
+static atomic<long> sink;
+
+// threads 个线程各调用 iters 次，返回每次调用的平均纳秒数
+template <typename F>
+double perCall(int threads, long iters, F f)
+{
+    auto begin = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++)
+        workers.emplace_back([&]()
+                             {
+            long sum = 0;
+            for (long i = 0; i < iters; i++)
+            {
+                sum += f();
+                // 每次都重新取单例，防止编译器把取地址提到循环外
+                asm volatile("" ::: "memory");
+            }
+            sink.store(sum, memory_order_relaxed); });
+    for (auto &w : workers)
+        w.join();
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count() / (double(threads) * iters);
+}
+
+struct Logger
+{
+    Logger() { cout << "  Logger created" << endl; }
+    ~Logger() { cout << "  Logger destroyed" << endl; }
+    void log(const string &s) { cout << "  [log] " << s << endl; }
+};
+
+// Database 析构时还要写日志，Logger 的 Order 更大，所以后销毁
+struct Database
+{
+    Database() { lazy_singleton<Logger, 100>::instance().log("Database created"); }
+    ~Database() { lazy_singleton<Logger, 100>::instance().log("Database destroyed"); }
+};
+
+struct CounterTag;
+#pragma endregion
 
 int main()
 {
+    const long iters = 20000000;
+    for (int threads : {1, 2, 4, 8})
+    {
+        cout << threads << " threads, read ns/call:"
+             << " local static " << perCall(threads, iters, []()
+                                            { return MeyersConfig::getInstance().value; })
+             << ", constinit " << perCall(threads, iters, []()
+                                         { return constant_singleton<Config>::instance().value; })
+             << ", DCLP " << perCall(threads, iters, []()
+                                    { return lazy_singleton<Config>::instance().value; })
+             << ", thread_local " << perCall(threads, iters, []()
+                                            { return thread_local_singleton<Config, void, merge_discard>::local().value; })
+             << endl;
+
+        // 计数器：所有线程共享一个 atomic，与每个线程一个分片、读时合并
+        atomic<long> &shared = constant_singleton<atomic<long>, CounterTag>::instance();
+        double sharedNs = perCall(threads, iters, [&]()
+                                  { return shared.fetch_add(1, memory_order_relaxed); });
+        auto sum = []()
+        { return thread_local_singleton<atomic<long>, CounterTag>::reduce(0L, [](long acc, const atomic<long> &c)
+                                                                          { return acc + c.load(memory_order_relaxed); }); };
+        long before = sum();
+        double shardedNs = perCall(threads, iters, []()
+                                   {
+            atomic<long> &c = thread_local_singleton<atomic<long>, CounterTag>::local();
+            c.store(c.load(memory_order_relaxed) + 1, memory_order_relaxed);
+            return 0; });
+        cout << "  counter ns/inc: shared atomic " << sharedNs << ", thread_local shards " << shardedNs
+             << " (sum " << sum() - before << ")" << endl;
+    }
+
+    lazy_singleton<Database>::instance();
+    cout << "main returns, singletons are destroyed in order:" << endl;
     return 0;
 }
\ No newline at end of file
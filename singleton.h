@@ -0,0 +1,239 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+/** 线程安全且访问开销可控的单例，用法与基准见 singleton.cc
+ *
+ * singleton.cc 中的几种写法：
+ *      Singleton 的局部 static 是线程安全的，但每次调用都要检查一次 guard 变量；
+ *      NormalLazy / LazyUnique / LazyEmbeded 在多个线程同时首次调用时对 instance 存在数据竞争。
+ * 这里按对象的特点分成三种：
+ *      constant_singleton      构造函数是 constexpr 的类型，编译期完成初始化（constinit），访问就是一个常量地址；
+ *      lazy_singleton          需要在运行期构造的类型，双重检查锁，快路径只有一次 acquire load；
+ *      thread_local_singleton  每个线程一份实例，写入时互不竞争，读取时把所有线程的实例合并起来。
+ * lazy_singleton 在 singleton_registry 中登记，退出时按 Order 与创建顺序销毁。
+ */
+
+// C++20 的 constinit 保证静态初始化，构造函数不是 constexpr 时直接编译失败；C++17 下退化为静态断言
+#if defined(__cpp_constinit)
+#define SINGLETON_CONSTINIT constinit
+#else
+#define SINGLETON_CONSTINIT
+#endif
+
+#pragma region constant_singleton
+// Tag 用于区分同一类型的多个实例
+template <typename T, typename Tag = void>
+class constant_singleton
+{
+public:
+    static T &instance() { return value; }
+
+private:
+#if !defined(__cpp_constinit)
+    static_assert((T{}, true), "constant_singleton requires a constexpr default constructor");
+#endif
+    static SINGLETON_CONSTINIT inline T value{};
+};
+#pragma endregion
+
+#pragma region singleton_registry
+/**
+ * 退出时的销毁顺序：
+ *      Order 小的先销毁，相同 Order 按创建的逆序销毁（与函数内局部 static 的规则一致）；
+ *      例如日志单例取较大的 Order，其他单例在析构函数中仍然可以写日志。
+ * 注册表本身在第一个 lazy_singleton 创建时构造，因此会在此之后构造的全局对象析构之后才开始销毁单例；
+ * 也可以在 main 结束前显式调用 shutdown()。已经销毁的单例再次被访问时会重新创建。
+ */
+class singleton_registry
+{
+public:
+    static singleton_registry &instance()
+    {
+        static singleton_registry registry;
+        return registry;
+    }
+
+    void add(int order, void (*destroy)())
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        entries.push_back({order, sequence++, destroy});
+    }
+
+    void shutdown()
+    {
+        for (;;)
+        {
+            void (*destroy)();
+            {
+                std::lock_guard<std::mutex> guard(mutex);
+                if (entries.empty())
+                    return;
+                auto next = std::min_element(entries.begin(), entries.end(), [](const Entry &a, const Entry &b)
+                                             { return a.order != b.order ? a.order < b.order : a.sequence > b.sequence; });
+                destroy = next->destroy;
+                entries.erase(next);
+            }
+            // 不持有锁，析构函数中可以访问其他单例
+            destroy();
+        }
+    }
+
+    ~singleton_registry() { shutdown(); }
+
+private:
+    struct Entry
+    {
+        int order;
+        long sequence;
+        void (*destroy)();
+    };
+
+    singleton_registry() = default;
+
+    std::mutex mutex;
+    std::vector<Entry> entries;
+    long sequence = 0;
+};
+#pragma endregion
+
+#pragma region lazy_singleton
+/**
+ * 双重检查锁：
+ *      快路径 acquire 读取指针，与创建线程的 release 写配对，读到非空指针时对象一定已经构造完成；
+ *      慢路径加锁后再检查一次，保证只构造一次。
+ * 与局部 static 相比开销相近（都是一次 acquire load + 分支），区别在于销毁时机可以控制。
+ */
+template <typename T, int Order = 0>
+class lazy_singleton
+{
+public:
+    static T &instance()
+    {
+        T *p = ptr.load(std::memory_order_acquire);
+        if (__builtin_expect(p != nullptr, 1))
+            return *p;
+        return create();
+    }
+
+    static bool alive() { return ptr.load(std::memory_order_acquire) != nullptr; }
+
+private:
+    __attribute__((noinline)) static T &create()
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        T *p = ptr.load(std::memory_order_relaxed);
+        if (!p)
+        {
+            p = new T();
+            singleton_registry::instance().add(Order, &destroy);
+            ptr.store(p, std::memory_order_release);
+        }
+        return *p;
+    }
+
+    static void destroy() { delete ptr.exchange(nullptr, std::memory_order_acq_rel); }
+
+    static inline std::atomic<T *> ptr{nullptr};
+    static inline std::mutex mutex;
+};
+#pragma endregion
+
+#pragma region thread_local_singleton
+// 线程退出时把它的实例合并到 retired 中，默认用 +=
+struct merge_add
+{
+    template <typename T>
+    void operator()(T &into, const T &from) const { into += from; }
+};
+
+// 每个线程的实例只是缓存之类不需要保留的数据
+struct merge_discard
+{
+    template <typename T>
+    void operator()(T &, const T &) const {}
+};
+
+/**
+ * 每个线程第一次调用 local() 时创建自己的实例并登记，之后的访问只读一个 thread_local 指针；
+ * 读者通过 reduce 遍历所有存活线程的实例，再加上已退出线程合并下来的结果。
+ * 读者与写者并发访问同一个实例，所以 T 的字段应当是 atomic 的：
+ * 只有所属线程会写，写入用 relaxed 的 load + store 即可，不需要原子的读改写。
+ */
+template <typename T, typename Tag = void, typename Merge = merge_add>
+class thread_local_singleton
+{
+public:
+    static T &local()
+    {
+        T *p = cached;
+        if (__builtin_expect(p != nullptr, 1))
+            return *p;
+        return attach();
+    }
+
+    // f(acc, const T &) -> acc
+    template <typename R, typename F>
+    static R reduce(R init, F f)
+    {
+        State &s = state();
+        std::lock_guard<std::mutex> guard(s.mutex);
+        init = f(init, s.retired);
+        for (const T *value : s.live)
+            init = f(init, *value);
+        return init;
+    }
+
+    static size_t threads()
+    {
+        State &s = state();
+        std::lock_guard<std::mutex> guard(s.mutex);
+        return s.live.size();
+    }
+
+private:
+    struct State
+    {
+        std::mutex mutex;
+        std::vector<const T *> live;
+        T retired{};
+    };
+
+    // 保证在所有线程的 Holder 析构之后才销毁
+    static State &state()
+    {
+        static State s;
+        return s;
+    }
+
+    struct Holder
+    {
+        T value{};
+        Holder()
+        {
+            State &s = state();
+            std::lock_guard<std::mutex> guard(s.mutex);
+            s.live.push_back(&value);
+        }
+        ~Holder()
+        {
+            State &s = state();
+            std::lock_guard<std::mutex> guard(s.mutex);
+            Merge()(s.retired, value);
+            s.live.erase(std::find(s.live.begin(), s.live.end(), &value));
+            cached = nullptr;
+        }
+    };
+
+    __attribute__((noinline)) static T &attach()
+    {
+        static thread_local Holder holder;
+        cached = &holder.value;
+        return holder.value;
+    }
+
+    static inline thread_local T *cached = nullptr;
+};
+#pragma endregion
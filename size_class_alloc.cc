@@ -0,0 +1,307 @@
+#include <iostream>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <iomanip>
+#include <list>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "lru_cache.h"
+#include "segment_tree.h"
+#include "size_class_alloc.h"
+#include "thread_pool.h"
+using namespace std;
+
+// 项目中分配密集的结构（LRU_Cache 的链表与哈希表节点、线段树 Node、ThreadPool 的 packaged_task）
+// 在 glibc malloc 与 SizeClassAllocator 下的耗时与峰值 RSS，以及采样分析器的输出
+// 编译：g++ -std=c++17 -O2 -pthread -rdynamic size_class_alloc.cc -o size_class_alloc
+//
+// 两种分配器各跑一个子进程（SIZE_CLASS_ALLOC=off / on），互不影响对方的堆与峰值 RSS
+
+SIZE_CLASS_GLOBAL_NEW()
+
+static double nsSince(chrono::steady_clock::time_point t0, size_t ops)
+{
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / ops;
+}
+
+#pragma region 负载
+// 未命中就 put：每次淘汰释放一个链表节点、一个哈希表节点和一个 shared_ptr 控制块，再分配三个新的
+static double lruChurn()
+{
+    const size_t OPS = 2000000;
+    LRU_Cache<uint64_t, int> cache(100000);
+    mt19937_64 rng(1);
+    auto t0 = chrono::steady_clock::now();
+    for (size_t i = 0; i < OPS; i++)
+    {
+        uint64_t key = rng() % 1000000;
+        if (!cache.get(key))
+            cache.put(key, make_shared<int>(int(i)));
+    }
+    return nsSince(t0, OPS);
+}
+
+// 建树再整棵删除，按节点数计
+static double segmentTree()
+{
+    const int N = 1 << 18, ROUNDS = 8;
+    vector<int> arr(N);
+    for (int i = 0; i < N; i++)
+        arr[i] = i * 7 % N;
+    auto t0 = chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        Node *root = build(arr);
+        delete root;
+    }
+    return nsSince(t0, size_t(ROUNDS) * (2 * N - 1));
+}
+
+// enqueue 分配 packaged_task（make_shared）与 std::function，工作线程执行完后释放，跨线程
+static double threadPool()
+{
+    const size_t TASKS = 200000, BATCH = 1000;
+    ThreadPool pool(4);
+    vector<future<void>> futures;
+    atomic<size_t> sum{0};
+    futures.reserve(BATCH);
+    auto t0 = chrono::steady_clock::now();
+    for (size_t i = 0; i < TASKS; i += BATCH)
+    {
+        for (size_t j = 0; j < BATCH; j++)
+            futures.push_back(pool.enqueue([&sum](size_t x)
+                                           { sum += x; },
+                                           i + j));
+        for (auto &f : futures)
+            f.get();
+        futures.clear();
+    }
+    return nsSince(t0, TASKS);
+}
+
+// 生产者分配、消费者释放：对象在两个线程的缓存之间单向流动，全靠中心链表回流
+static double crossThread()
+{
+    const size_t OBJECTS = 2000000, BATCH = 1024;
+    mutex m;
+    condition_variable cv;
+    deque<vector<char *>> queue;
+    bool done = false;
+    auto t0 = chrono::steady_clock::now();
+    thread consumer([&]()
+                    {
+        for (;;)
+        {
+            vector<char *> batch;
+            {
+                unique_lock<mutex> lock(m);
+                cv.wait(lock, [&]() { return !queue.empty() || done; });
+                if (queue.empty())
+                    return;
+                batch = std::move(queue.front());
+                queue.pop_front();
+            }
+            for (char *p : batch)
+                delete[] p;
+        } });
+    mt19937 rng(2);
+    for (size_t i = 0; i < OBJECTS; i += BATCH)
+    {
+        vector<char *> batch(BATCH);
+        for (auto &p : batch)
+            p = new char[16 + rng() % 240];
+        {
+            lock_guard<mutex> lock(m);
+            queue.push_back(std::move(batch));
+        }
+        cv.notify_one();
+    }
+    {
+        lock_guard<mutex> lock(m);
+        done = true;
+    }
+    cv.notify_one();
+    consumer.join();
+    return nsSince(t0, OBJECTS);
+}
+
+// 每个线程一个 4096 项的滑动窗口，随机大小（多数小于 256 字节，偶尔到 8KB），释放最旧的再分配新的
+static double slidingWindow()
+{
+    const size_t OPS = 4000000, WINDOW = 4096;
+    const unsigned THREADS = 4;
+    auto t0 = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (unsigned t = 0; t < THREADS; t++)
+        threads.emplace_back([&, t]()
+                             {
+            mt19937 rng(t);
+            vector<char *> window(WINDOW, nullptr);
+            for (size_t i = 0; i < OPS / THREADS; i++)
+            {
+                char *&slot = window[i % WINDOW];
+                delete[] slot;
+                uint32_t r = rng();
+                size_t size = r % 16 ? 8 + (r >> 8) % 248 : 256 + (r >> 8) % 7936;
+                slot = new char[size];
+                slot[0] = char(i);
+            }
+            for (char *p : window)
+                delete[] p; });
+    for (auto &th : threads)
+        th.join();
+    return nsSince(t0, OPS);
+}
+
+// 8KB 到 64KB 的大对象（vector 的缓冲区、哈希表的桶数组）：1024 项的滑动窗口，约 37MB，峰值 RSS 出现在这一项。
+// 前面负载留下的 span 不归还，malloc 也用不上，所以 size class 一列的峰值比 glibc 多出这部分
+static double midSize()
+{
+    const size_t OPS = 200000, WINDOW = 1024;
+    mt19937 rng(3);
+    vector<char *> window(WINDOW, nullptr);
+    auto t0 = chrono::steady_clock::now();
+    for (size_t i = 0; i < OPS; i++)
+    {
+        char *&slot = window[i % WINDOW];
+        delete[] slot;
+        size_t size = 8193 + rng() % (56 << 10);
+        slot = new char[size];
+        memset(slot, 1, size);
+    }
+    double ns = nsSince(t0, OPS);
+    for (char *p : window)
+        delete[] p;
+    return ns;
+}
+
+// 不替换全局 new 时也可以只给某个容器用：std::list 节点走 size_class_allocator。
+// size_class_allocator 不看 SIZE_CLASS_ALLOC，所以不放进上面两列对比，而是在 glibc 的子进程中与 std::allocator 并排跑
+template <typename List>
+static double listChurn()
+{
+    const size_t OPS = 4000000;
+    List l;
+    auto t0 = chrono::steady_clock::now();
+    for (size_t i = 0; i < OPS; i++)
+    {
+        l.push_back(i);
+        if (l.size() > 10000)
+            l.pop_front();
+    }
+    return nsSince(t0, OPS);
+}
+#pragma endregion
+
+struct Workload
+{
+    const char *name;
+    double (*run)();
+};
+
+static const Workload WORKLOADS[] = {
+    {"lru_cache churn", lruChurn},
+    {"segment_tree build+delete", segmentTree},
+    {"thread_pool enqueue", threadPool},
+    {"cross-thread free", crossThread},
+    {"sliding window x4", slidingWindow},
+    {"8-64KB window", midSize},
+};
+
+static const Workload LIST_WORKLOADS[] = {
+    {"list std::allocator", listChurn<list<uint64_t>>},
+    {"list size_class_allocator", listChurn<list<uint64_t, size_class_allocator<uint64_t>>>},
+};
+
+// 子进程：每行 "name<TAB>ns/op"，WORKLOADS 之后一行 "rss<TAB>KB"；容器分配器的对比放在 rss 之后，不计入峰值
+static int child()
+{
+    for (const Workload &w : WORKLOADS)
+        cout << w.name << "\t" << w.run() << endl;
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    cout << "rss\t" << usage.ru_maxrss << endl;
+    if (!SizeClassAllocator::enabled())
+        for (const Workload &w : LIST_WORKLOADS)
+            cout << w.name << "\t" << w.run() << endl;
+    return 0;
+}
+
+static map<string, double> runChild(const string &exe, const char *mode)
+{
+    map<string, double> results;
+    string cmd = string("SIZE_CLASS_ALLOC=") + mode + " '" + exe + "' --child";
+    FILE *pipe = popen(cmd.c_str(), "r");
+    if (!pipe)
+        return results;
+    char line[256];
+    while (fgets(line, sizeof(line), pipe))
+    {
+        char *tab = strchr(line, '\t');
+        if (tab)
+            results[string(line, tab)] = atof(tab + 1);
+    }
+    pclose(pipe);
+    return results;
+}
+
+// 在本进程中采样线段树与 LRU_Cache 的分配
+static void profile()
+{
+    if (!SizeClassAllocator::enabled())
+    {
+        cout << "SIZE_CLASS_ALLOC=off, profiler skipped (it samples allocations made through SizeClassAllocator)"
+             << endl;
+        return;
+    }
+    AllocationProfiler::start(64 << 10);
+    segmentTree();
+    lruChurn();
+    AllocationProfiler::stop();
+    AllocationProfiler::report(cout, 4);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && string(argv[1]) == "--child")
+        return child();
+
+    char exe[4096];
+    ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (n <= 0)
+    {
+        cout << "cannot resolve /proc/self/exe" << endl;
+        return 1;
+    }
+    exe[n] = 0;
+    map<string, double> glibc = runChild(exe, "off"), sized = runChild(exe, "on");
+    if (glibc.empty() || sized.empty())
+    {
+        cout << "child process failed" << endl;
+        return 1;
+    }
+
+    cout << left << setw(28) << "ns/op" << right << setw(10) << "glibc" << setw(12) << "size class" << setw(10)
+         << "speedup" << endl;
+    cout << fixed << setprecision(1);
+    for (const Workload &w : WORKLOADS)
+        cout << left << setw(28) << w.name << right << setw(10) << glibc[w.name] << setw(12) << sized[w.name]
+             << setw(9) << glibc[w.name] / sized[w.name] << "x" << endl;
+    cout << left << setw(28) << "peak RSS MB" << right << setw(10) << glibc["rss"] / 1024 << setw(12)
+         << sized["rss"] / 1024 << endl
+         << endl;
+    // 同一个子进程（全局 new 为 glibc）中，只有容器的分配器不同
+    double stdList = glibc[LIST_WORKLOADS[0].name], sizedList = glibc[LIST_WORKLOADS[1].name];
+    cout << "std::list<uint64_t> push_back/pop_front, global new = glibc: std::allocator " << stdList
+         << " ns, size_class_allocator " << sizedList << " ns, speedup " << stdList / sizedList << "x" << endl
+         << defaultfloat << endl;
+
+    profile();
+    return 0;
+}
@@ -0,0 +1,631 @@
+#pragma once
+#include <execinfo.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <vector>
+#include "lookup_tables.h"
+
+/** 按大小分级、带线程缓存的分配器，用法与基准见 size_class_alloc.cc
+ *
+ *      SizeClassAllocator       allocate / deallocate，<= 8KB 的请求按 36 个大小级别分配
+ *      SizeClassAllocated       继承它的类，operator new / delete 走 SizeClassAllocator（类级别的钩子）
+ *      size_class_allocator<T>  标准分配器，给 std::list / std::unordered_map 等容器用
+ *      SIZE_CLASS_GLOBAL_NEW()  在某一个 .cc 中展开，替换全局 operator new / delete；
+ *                               环境变量 SIZE_CLASS_ALLOC=off 时退回 malloc，在进程第一次分配时决定，之后不变
+ *      AllocationProfiler       可选的采样分析：平均每分配 sampleBytes 字节记录一次调用栈，按分配点汇总
+ *
+ * 结构（与 tcmalloc 相同的三层）：
+ *      线程缓存    每个大小级别一个单链表，空闲对象的头 8 字节存 next，分配与释放都不加锁；
+ *      中心链表    每个级别一把锁，线程缓存空了一次取 batch 个，超过 2 * batch 个时一次还回 batch 个，
+ *                  线程退出时线程缓存全部还回，跨线程释放的对象也因此能被别的线程重用；
+ *      span        中心链表空了从 span 切一批对象。span 为 64KB、按 64KB 对齐，开头 64 字节是 SpanHeader，
+ *                  释放时 p & ~(SPAN - 1) 就是它所在 span 的头部，从中读出大小级别。
+ * span 按 4MB 一块（按 4MB 对齐）从 mmap 申请，和 ObjectPool 一样只在进程内循环使用，不归还给操作系统。
+ * 每块在一张两级的位图（ChunkMap）中登记，释放时查它判断指针是否落在这些块中。
+ * 大于 8KB（或对齐超过 16 字节）的请求直接用 malloc / aligned_alloc 分配，只多出对象前面 16 字节的 LargeHeader，
+ * 不再按 64KB 取整、对齐，8KB 到 64KB 之间的对象没有额外的浪费。
+ */
+
+#pragma region AllocationProfiler
+class AllocationProfiler
+{
+public:
+    // 平均每分配 sampleBytes 字节采样一次（间隔服从指数分布，小对象与大对象被采中的概率与字节数成正比）
+    static void start(size_t sampleBytes = 512 << 10)
+    {
+        rate.store(sampleBytes, std::memory_order_relaxed);
+        enabled.store(true, std::memory_order_release);
+    }
+    static void stop() { enabled.store(false, std::memory_order_release); }
+    static void reset()
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        std::memset(static_cast<void *>(sites), 0, sizeof(sites));
+        dropped = 0;
+    }
+
+    // 分配路径上调用，关闭时只有一次 relaxed load
+    static void note(size_t size)
+    {
+        if (__builtin_expect(!enabled.load(std::memory_order_relaxed), 1))
+            return;
+        countdown -= long(size);
+        if (countdown < 0)
+            sample(size);
+    }
+
+    // 按估算的字节数从大到小输出前 top 个分配点
+    static void report(std::ostream &os, size_t top = 10)
+    {
+        Guard reentry;
+        std::vector<Site> copy;
+        size_t lost;
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            for (const Site &s : sites)
+                if (s.samples)
+                    copy.push_back(s);
+            lost = dropped;
+        }
+        std::sort(copy.begin(), copy.end(), [](const Site &a, const Site &b)
+                  { return a.estBytes > b.estBytes; });
+        double total = 0;
+        for (const Site &s : copy)
+            total += s.estBytes;
+        os << copy.size() << " allocation sites, ~" << std::fixed << std::setprecision(1) << total / (1 << 20)
+           << " MB allocated (estimated)";
+        if (lost)
+            os << ", " << lost << " samples dropped (site table full)";
+        os << std::endl;
+        for (size_t i = 0; i < copy.size() && i < top; i++)
+        {
+            const Site &s = copy[i];
+            os << "#" << i << "  ~" << s.estBytes / (1 << 20) << " MB, ~" << std::setprecision(0) << s.estCount
+               << " allocs, avg " << s.sampledBytes / s.samples << " B, " << s.samples << " samples"
+               << std::defaultfloat << std::setprecision(1) << std::fixed << std::endl;
+            char **symbols = backtrace_symbols(s.frames, s.depth);
+            for (int f = 0; f < s.depth; f++)
+                os << "      " << (symbols ? symbols[f] : "?") << std::endl;
+            free(symbols);
+        }
+        os << std::defaultfloat << std::setprecision(6);
+    }
+
+private:
+    static constexpr int DEPTH = 6; // 报告中每个分配点显示的栈深度
+    static constexpr int KEY = 3;   // 按栈顶几帧（分配器自身 + 调用 new 的位置）归并，递归调用（如线段树的 build）不会因调用链不同而分散
+    static constexpr int SKIP = 1; // sample 自己这一帧
+    static constexpr size_t SITES = 1024;
+
+    struct Site
+    {
+        uint64_t hash;
+        int depth;
+        void *frames[DEPTH];
+        uint64_t samples, sampledBytes;
+        double estCount, estBytes;
+    };
+
+    // 采样路径上的 backtrace、report 中的 vector 都可能再次分配，同一线程内不重入
+    struct Guard
+    {
+        bool entered;
+        Guard() : entered(busy) { busy = true; }
+        ~Guard() { busy = entered; }
+    };
+
+    __attribute__((noinline)) static void sample(size_t size)
+    {
+        size_t r = rate.load(std::memory_order_relaxed);
+        countdown = nextInterval(r);
+        if (busy)
+            return;
+        Guard reentry;
+        void *frames[DEPTH + SKIP];
+        int depth = backtrace(frames, DEPTH + SKIP) - SKIP;
+        if (depth <= 0)
+            return;
+        int key = std::min(depth, KEY);
+        uint64_t hash = lookup::crc32c(frames + SKIP, key * sizeof(void *));
+        // 采中一次代表的字节数：P(采中大小为 size 的对象) = 1 - exp(-size / r)
+        double weight = double(size) / -std::expm1(-double(size) / r);
+
+        std::lock_guard<std::mutex> guard(mutex);
+        for (size_t i = hash % SITES, probes = 0; probes < SITES; i = (i + 1) % SITES, probes++)
+        {
+            Site &s = sites[i];
+            if (s.samples && (s.hash != hash || std::min(s.depth, KEY) != key ||
+                              std::memcmp(s.frames, frames + SKIP, key * sizeof(void *))))
+                continue;
+            if (!s.samples)
+            {
+                s.hash = hash;
+                s.depth = depth;
+                std::memcpy(s.frames, frames + SKIP, depth * sizeof(void *));
+            }
+            s.samples++;
+            s.sampledBytes += size;
+            s.estBytes += weight;
+            s.estCount += weight / size;
+            return;
+        }
+        dropped++;
+    }
+
+    // 指数分布的采样间隔，每线程一个 xorshift 状态
+    static long nextInterval(size_t r)
+    {
+        uint64_t x = rng;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        rng = x;
+        double u = (x >> 11) * (1.0 / 9007199254740992.0);
+        return long(-std::log(1 - u) * r) + 1;
+    }
+
+    static inline std::atomic<bool> enabled{false};
+    static inline std::atomic<size_t> rate{512 << 10};
+    static inline std::mutex mutex;
+    static inline Site sites[SITES];
+    static inline size_t dropped = 0;
+    static inline thread_local long countdown = 0;
+    static inline thread_local uint64_t rng = 0x9E3779B97F4A7C15ull;
+    static inline thread_local bool busy = false;
+};
+#pragma endregion
+
+#pragma region SizeClassAllocator
+namespace size_class
+{
+    constexpr size_t SPAN = 64 << 10;
+    constexpr size_t SPAN_HEADER = 64;
+    constexpr size_t CHUNK = 4 << 20; // 一次从 mmap 申请的大小
+    constexpr size_t MAX_SMALL = 8192;
+    constexpr int CLASSES = 1 + 16 + 20; // 0 号不用
+
+    // 1..16：16 字节一级到 256；17..36：每翻一倍分 4 级，到 8192
+    constexpr size_t class_size(int c)
+    {
+        if (c <= 16)
+            return size_t(c) * 16;
+        int i = c - 17;
+        size_t base = size_t(256) << (i / 4);
+        return base + (i % 4 + 1) * base / 4;
+    }
+    static_assert(class_size(CLASSES - 1) == MAX_SMALL, "size classes must end at MAX_SMALL");
+
+    // (size + 127) / 128 -> 级别，覆盖 256 < size <= 8192
+    inline constexpr auto LARGE_CLASS = lookup::make_table<uint8_t, MAX_SMALL / 128 + 1>([](size_t i)
+                                                                                          {
+        int c = 17;
+        while (c < CLASSES - 1 && class_size(c) < i * 128)
+            c++;
+        return uint8_t(c); });
+
+    inline int class_of(size_t size)
+    {
+        if (size <= 256)
+            return size ? int((size + 15) >> 4) : 1;
+        return LARGE_CLASS[(size + 127) >> 7];
+    }
+
+    // 一次在线程缓存与中心链表之间搬动的对象个数，约 32KB
+    constexpr uint32_t batch(int c)
+    {
+        return uint32_t(std::min<size_t>(64, std::max<size_t>(2, (32 << 10) / class_size(c))));
+    }
+
+    struct SpanHeader
+    {
+        uint32_t sizeClass;
+    };
+    static_assert(sizeof(SpanHeader) <= SPAN_HEADER, "span header");
+
+    // 大对象紧挨在对象前面的头部
+    struct LargeHeader
+    {
+        size_t bytes;    // 可用字节数
+        size_t offset;   // 对象相对 malloc 返回的地址的偏移
+    };
+    constexpr size_t LARGE_HEADER = 16;
+    static_assert(sizeof(LargeHeader) == LARGE_HEADER, "large header");
+
+    /**
+     * 哪些 4MB 块属于 span 堆：按地址的第 22..46 位分两级索引（用户态地址不超过 47 位），每块 1 字节。
+     * 第二级按需 mmap，只增不减；登记在 newSpan 持锁时进行，查询不加锁（块在切出 span 之前已登记，
+     * 查询的指针一定来自已经发布的 span，看得到登记）。
+     */
+    struct ChunkMap
+    {
+        static constexpr int LEAF_BITS = 13;
+        static constexpr int ROOT_BITS = 47 - 22 - LEAF_BITS;
+        std::atomic<uint8_t *> root[size_t(1) << ROOT_BITS];
+
+        bool contains(const void *p) const
+        {
+            uintptr_t i = uintptr_t(p) >> 22;
+            if (i >> (ROOT_BITS + LEAF_BITS))
+                return false;
+            uint8_t *leaf = root[i >> LEAF_BITS].load(std::memory_order_acquire);
+            return leaf && leaf[i & ((size_t(1) << LEAF_BITS) - 1)];
+        }
+
+        bool add(const void *chunk)
+        {
+            uintptr_t i = uintptr_t(chunk) >> 22;
+            if (i >> (ROOT_BITS + LEAF_BITS))
+                return false;
+            std::atomic<uint8_t *> &slot = root[i >> LEAF_BITS];
+            uint8_t *leaf = slot.load(std::memory_order_relaxed);
+            if (!leaf)
+            {
+                void *m = mmap(nullptr, size_t(1) << LEAF_BITS, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (m == MAP_FAILED)
+                    return false;
+                leaf = static_cast<uint8_t *>(m);
+                slot.store(leaf, std::memory_order_release);
+            }
+            leaf[i & ((size_t(1) << LEAF_BITS) - 1)] = 1;
+            return true;
+        }
+    };
+
+    struct FreeList
+    {
+        void *head;
+        uint32_t count;
+    };
+
+    struct ThreadCache
+    {
+        FreeList lists[CLASSES];
+    };
+
+    struct Central
+    {
+        std::mutex mutex;
+        void *head = nullptr;
+        size_t count = 0;
+    };
+
+    struct PageHeap
+    {
+        std::mutex mutex;
+        char *cursor = nullptr, *end = nullptr;
+        std::atomic<size_t> mapped{0};
+    };
+}
+
+class SizeClassAllocator
+{
+public:
+    static constexpr size_t SPAN = size_class::SPAN;
+    static constexpr size_t SPAN_HEADER = size_class::SPAN_HEADER;
+    static constexpr size_t MAX_SMALL = size_class::MAX_SMALL;
+
+    // 失败返回 nullptr
+    static void *allocate(size_t size)
+    {
+        AllocationProfiler::note(size);
+        if (size > MAX_SMALL)
+            return allocateLarge(size, 16);
+        int c = size_class::class_of(size);
+        ThreadCache *t = local();
+        if (__builtin_expect(t == nullptr, 0))
+            return centralAllocate(c);
+        FreeList &l = t->lists[c];
+        if (__builtin_expect(l.head != nullptr, 1))
+        {
+            void *p = l.head;
+            l.head = next(p);
+            l.count--;
+            return p;
+        }
+        return refill(c, l);
+    }
+
+    // 对齐超过 16 字节的请求走大对象路径，align 须为 2 的幂
+    static void *allocate(size_t size, size_t align)
+    {
+        if (align <= 16)
+            return allocate(size);
+        AllocationProfiler::note(size);
+        return allocateLarge(size, align);
+    }
+
+    static void deallocate(void *p)
+    {
+        if (!p)
+            return;
+        if (!chunks.contains(p))
+        {
+            LargeHeader *h = largeHeader(p);
+            free(static_cast<char *>(p) - h->offset);
+            return;
+        }
+        int c = header(p)->sizeClass;
+        ThreadCache *t = local();
+        if (__builtin_expect(t == nullptr, 0))
+        {
+            centralFree(c, p, p, 1);
+            return;
+        }
+        FreeList &l = t->lists[c];
+        next(p) = l.head;
+        l.head = p;
+        if (++l.count > 2 * size_class::batch(c))
+            flush(c, l, size_class::batch(c));
+    }
+
+    // 可用字节数，不小于请求的大小
+    static size_t usable_size(void *p)
+    {
+        return chunks.contains(p) ? size_class::class_size(header(p)->sizeClass) : largeHeader(p)->bytes;
+    }
+
+    // 从 mmap 申请的总字节数（不含大对象）
+    static size_t mapped_bytes() { return heap.mapped.load(std::memory_order_relaxed); }
+
+    // 全局 operator new / delete 的实现，见 SIZE_CLASS_GLOBAL_NEW
+    static void *globalAllocate(size_t size, size_t align = 0)
+    {
+        void *p;
+        if (enabled())
+            p = align ? allocate(size, align) : allocate(size);
+        else
+            p = align ? aligned_alloc(align, (size + align - 1) / align * align) : malloc(size);
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+    static void globalDeallocate(void *p)
+    {
+        if (enabled())
+            deallocate(p);
+        else
+            free(p);
+    }
+
+    static bool enabled()
+    {
+        int m = mode.load(std::memory_order_relaxed);
+        if (__builtin_expect(m < 0, 0))
+        {
+            const char *env = getenv("SIZE_CLASS_ALLOC");
+            m = env && (!strcmp(env, "off") || !strcmp(env, "0")) ? 0 : 1;
+            mode.store(m, std::memory_order_relaxed);
+        }
+        return m;
+    }
+
+private:
+    typedef size_class::SpanHeader SpanHeader;
+    typedef size_class::LargeHeader LargeHeader;
+    typedef size_class::FreeList FreeList;
+    typedef size_class::ThreadCache ThreadCache;
+    typedef size_class::Central Central;
+    static constexpr int CLASSES = size_class::CLASSES;
+
+    static void *&next(void *p) { return *static_cast<void **>(p); }
+    static SpanHeader *header(void *p) { return reinterpret_cast<SpanHeader *>(uintptr_t(p) & ~(SPAN - 1)); }
+    static LargeHeader *largeHeader(void *p) { return reinterpret_cast<LargeHeader *>(static_cast<char *>(p) - size_class::LARGE_HEADER); }
+
+    // 线程退出时把线程缓存全部还回中心链表；之后（其他 thread_local 的析构中）的分配直接走中心链表
+    struct Detacher
+    {
+        ~Detacher()
+        {
+            for (int c = 1; c < CLASSES; c++)
+                flush(c, cache.lists[c], cache.lists[c].count);
+            attached = nullptr;
+            detached = true;
+        }
+    };
+
+    static ThreadCache *local()
+    {
+        ThreadCache *t = attached;
+        if (__builtin_expect(t != nullptr, 1))
+            return t;
+        return attach();
+    }
+
+    __attribute__((noinline)) static ThreadCache *attach()
+    {
+        if (detached)
+            return nullptr;
+        static thread_local Detacher detacher;
+        attached = &cache;
+        return attached;
+    }
+
+    static void *refill(int c, FreeList &l)
+    {
+        Central &ce = centrals[c];
+        std::lock_guard<std::mutex> guard(ce.mutex);
+        uint32_t n = size_class::batch(c);
+        if (ce.count < n && !carve(c, ce))
+            return nullptr;
+        // 第一个直接返回，其余 n - 1 个放进线程缓存
+        void *p = ce.head;
+        void *last = p;
+        for (uint32_t i = 1; i < n; i++)
+            last = next(last);
+        ce.head = next(last);
+        ce.count -= n;
+        next(last) = nullptr;
+        l.head = next(p);
+        l.count = n - 1;
+        return p;
+    }
+
+    // 从线程缓存还回 n 个到中心链表
+    static void flush(int c, FreeList &l, uint32_t n)
+    {
+        if (!n)
+            return;
+        void *first = l.head, *last = first;
+        for (uint32_t i = 1; i < n; i++)
+            last = next(last);
+        l.head = next(last);
+        l.count -= n;
+        centralFree(c, first, last, n);
+    }
+
+    static void centralFree(int c, void *first, void *last, size_t n)
+    {
+        Central &ce = centrals[c];
+        std::lock_guard<std::mutex> guard(ce.mutex);
+        next(last) = ce.head;
+        ce.head = first;
+        ce.count += n;
+    }
+
+    static void *centralAllocate(int c)
+    {
+        Central &ce = centrals[c];
+        std::lock_guard<std::mutex> guard(ce.mutex);
+        if (!ce.count && !carve(c, ce))
+            return nullptr;
+        void *p = ce.head;
+        ce.head = next(p);
+        ce.count--;
+        return p;
+    }
+
+    // 切一个新 span 放进中心链表，调用方持有 ce.mutex
+    static bool carve(int c, Central &ce)
+    {
+        char *span = newSpan();
+        if (!span)
+            return false;
+        SpanHeader *h = reinterpret_cast<SpanHeader *>(span);
+        h->sizeClass = uint32_t(c);
+        size_t size = size_class::class_size(c);
+        // 从后往前串，链表顺序与地址顺序一致，连续分配的对象相邻
+        for (char *p = span + SPAN_HEADER + (SPAN - SPAN_HEADER) / size * size - size; p >= span + SPAN_HEADER; p -= size)
+        {
+            next(p) = ce.head;
+            ce.head = p;
+            ce.count++;
+        }
+        return true;
+    }
+
+    static char *newSpan()
+    {
+        std::lock_guard<std::mutex> guard(heap.mutex);
+        if (heap.cursor == heap.end)
+        {
+            // 按 CHUNK 对齐，ChunkMap 中的一项正好对应一块：多申请一个 CHUNK，截掉首尾不对齐的部分
+            const size_t CHUNK = size_class::CHUNK;
+            char *raw = static_cast<char *>(mmap(nullptr, 2 * CHUNK, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if (raw == MAP_FAILED)
+                return nullptr;
+            char *aligned = reinterpret_cast<char *>((uintptr_t(raw) + CHUNK - 1) & ~(CHUNK - 1));
+            if (aligned > raw)
+                munmap(raw, aligned - raw);
+            if (raw + CHUNK > aligned)
+                munmap(aligned + CHUNK, raw + CHUNK - aligned);
+            if (!chunks.add(aligned))
+            {
+                munmap(aligned, CHUNK);
+                return nullptr;
+            }
+            heap.cursor = aligned;
+            heap.end = aligned + size_class::CHUNK;
+            heap.mapped.fetch_add(size_class::CHUNK, std::memory_order_relaxed);
+        }
+        char *span = heap.cursor;
+        heap.cursor += SPAN;
+        return span;
+    }
+
+    // 对象放在 malloc 返回的地址之后 align（>= 16）处，头部在对象前面 16 字节
+    static void *allocateLarge(size_t size, size_t align)
+    {
+        size_t total = (align + size + align - 1) / align * align;
+        if (total < size)
+            return nullptr;
+        char *base = static_cast<char *>(align == 16 ? malloc(total) : aligned_alloc(align, total));
+        if (!base)
+            return nullptr;
+        LargeHeader *h = largeHeader(base + align);
+        h->bytes = size;
+        h->offset = align;
+        return base + align;
+    }
+
+    // 都是常量初始化，不依赖静态初始化顺序，也从不析构（其他全局对象析构时可能还在释放内存）
+    static inline Central centrals[CLASSES];
+    static inline size_class::PageHeap heap;
+    static inline size_class::ChunkMap chunks;
+    static inline std::atomic<int> mode{-1};
+    static inline thread_local ThreadCache cache;
+    static inline thread_local ThreadCache *attached = nullptr;
+    static inline thread_local bool detached = false;
+};
+#pragma endregion
+
+#pragma region 类级别与容器的钩子
+// 继承后该类（及其派生类）的 new / delete 走 SizeClassAllocator
+struct SizeClassAllocated
+{
+    static void *operator new(size_t size)
+    {
+        void *p = SizeClassAllocator::allocate(size);
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+    static void operator delete(void *p) noexcept { SizeClassAllocator::deallocate(p); }
+};
+
+template <typename T>
+struct size_class_allocator
+{
+    typedef T value_type;
+    size_class_allocator() noexcept {}
+    template <typename U>
+    size_class_allocator(const size_class_allocator<U> &) noexcept {}
+
+    T *allocate(size_t n)
+    {
+        void *p = SizeClassAllocator::allocate(n * sizeof(T), alignof(T));
+        if (!p)
+            throw std::bad_alloc();
+        return static_cast<T *>(p);
+    }
+    void deallocate(T *p, size_t) noexcept { SizeClassAllocator::deallocate(p); }
+
+    template <typename U>
+    bool operator==(const size_class_allocator<U> &) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const size_class_allocator<U> &) const noexcept { return false; }
+};
+
+// 在且仅在一个 .cc 的全局作用域展开
+#define SIZE_CLASS_GLOBAL_NEW()                                                                                     \
+    void *operator new(size_t n) { return SizeClassAllocator::globalAllocate(n); }                                   \
+    void *operator new[](size_t n) { return SizeClassAllocator::globalAllocate(n); }                                 \
+    void *operator new(size_t n, std::align_val_t a) { return SizeClassAllocator::globalAllocate(n, size_t(a)); }   \
+    void *operator new[](size_t n, std::align_val_t a) { return SizeClassAllocator::globalAllocate(n, size_t(a)); } \
+    void operator delete(void *p) noexcept { SizeClassAllocator::globalDeallocate(p); }                             \
+    void operator delete[](void *p) noexcept { SizeClassAllocator::globalDeallocate(p); }                           \
+    void operator delete(void *p, size_t) noexcept { SizeClassAllocator::globalDeallocate(p); }                     \
+    void operator delete[](void *p, size_t) noexcept { SizeClassAllocator::globalDeallocate(p); }                   \
+    void operator delete(void *p, std::align_val_t) noexcept { SizeClassAllocator::globalDeallocate(p); }           \
+    void operator delete[](void *p, std::align_val_t) noexcept { SizeClassAllocator::globalDeallocate(p); }         \
+    void operator delete(void *p, size_t, std::align_val_t) noexcept { SizeClassAllocator::globalDeallocate(p); }   \
+    void operator delete[](void *p, size_t, std::align_val_t) noexcept { SizeClassAllocator::globalDeallocate(p); }
+#pragma endregion
@@ -0,0 +1,232 @@
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include "perf_counter.h"
+#include "static_dispatch.h"
+using namespace std;
+
+// 对比 vtable.cc 中三种继承方式的虚调用与 static_dispatch.h 中各种静态分发方式的调用开销
+// 编译：g++ -std=c++17 -O2 static_dispatch.cc -o static_dispatch
+
+// 每个层次都有 4 个具体类型，元素类型随机排列，这样虚调用的目标无法预测
+const int TYPES = 4;
+
+#pragma region 单继承，对应 vtable.cc 中的 Derived_override
+struct SBase
+{
+    int a = 1;
+    virtual ~SBase() {}
+    virtual long f(long x) const { return x + a; }
+};
+template <int K>
+struct SDerived : SBase
+{
+    long f(long x) const override { return x * K + a; }
+};
+#pragma endregion
+
+#pragma region 多继承，对应 Derived_multi_override，通过第二个基类指针调用会经过 non-virtual thunk
+struct MBase1
+{
+    int b1 = 1;
+    virtual ~MBase1() {}
+    virtual long f1(long x) const { return x; }
+};
+struct MBase2
+{
+    int b2 = 2;
+    virtual ~MBase2() {}
+    virtual long f(long x) const { return x + b2; }
+};
+struct MBase3
+{
+    int b3 = 3;
+    virtual ~MBase3() {}
+    virtual long f3(long x) const { return x; }
+};
+template <int K>
+struct MDerived : MBase1, MBase2, MBase3
+{
+    long f(long x) const override { return x * K + b2; }
+};
+#pragma endregion
+
+#pragma region 菱形虚继承，对应 VDerived，通过虚基类指针调用会经过 virtual thunk
+struct VBase
+{
+    int a = 1;
+    virtual ~VBase() {}
+    virtual long f(long x) const { return x + a; }
+};
+struct VMid1 : virtual VBase
+{
+    int v1 = 1;
+};
+struct VMid2 : virtual VBase
+{
+    int v2 = 2;
+};
+template <int K>
+struct VDerived : VMid1, VMid2
+{
+    long f(long x) const override { return x * K + a; }
+};
+#pragma endregion
+
+#pragma region 静态分发使用的类型，没有虚函数
+template <int K>
+struct Plain
+{
+    int a = 1;
+    long f(long x) const { return x * K + a; }
+};
+
+template <int K>
+struct CrtpShape : crtp<CrtpShape<K>>
+{
+    int a = 1;
+    long f_impl(long x) const { return x * K + a; }
+};
+// 通过 CRTP 基类调用，编译期就确定了目标
+template <typename D>
+long callF(const crtp<D> &s, long x) { return s.self().f_impl(x); }
+#pragma endregion
+
+template <typename Base, template <int> class D>
+unique_ptr<Base> makeByKind(int kind)
+{
+    switch (kind)
+    {
+    case 0:
+        return make_unique<D<1>>();
+    case 1:
+        return make_unique<D<2>>();
+    case 2:
+        return make_unique<D<3>>();
+    default:
+        return make_unique<D<4>>();
+    }
+}
+
+static volatile long sink;
+
+// 重复 rounds 轮调用 body，输出调用速率与每次调用的分支预测失败次数
+template <typename Body>
+void run(const string &name, size_t calls, int rounds, Body body)
+{
+    PerfCounter misses = PerfCounter::branchMisses();
+    long sum = 0;
+    auto begin = chrono::steady_clock::now();
+    misses.start();
+    for (int r = 0; r < rounds; r++)
+        sum += body();
+    misses.stop();
+    double t = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    sink = sum;
+    double total = double(calls) * rounds;
+    cout << name << "\t" << total / t / 1e6 << " Mcalls/s\t";
+    if (misses.valid())
+        cout << double(misses.value()) / total << " branch-misses/call" << endl;
+    else
+        cout << "branch-misses n/a" << endl;
+}
+
+template <typename Base>
+long callAll(const vector<Base *> &objs)
+{
+    long sum = 0;
+    for (size_t i = 0; i < objs.size(); i++)
+        sum += objs[i]->f((long)i);
+    return sum;
+}
+
+template <typename Base, template <int> class D>
+void benchVirtual(const string &name, const vector<int> &kinds, int rounds)
+{
+    vector<unique_ptr<Base>> owned;
+    vector<Base *> objs;
+    for (int k : kinds)
+    {
+        owned.push_back(makeByKind<Base, D>(k));
+        objs.push_back(owned.back().get());
+    }
+    run(name + " random", objs.size(), rounds, [&]()
+        { return callAll(objs); });
+    sort_by_dynamic_type(objs);
+    run(name + " sorted", objs.size(), rounds, [&]()
+        { return callAll(objs); });
+}
+
+int main(int argc, char const *argv[])
+{
+    const size_t n = 1 << 20;
+    const int rounds = 10;
+    mt19937 rng(5);
+    vector<int> kinds(n);
+    for (auto &k : kinds)
+        k = rng() % TYPES;
+
+    benchVirtual<SBase, SDerived>("single virtual  ", kinds, rounds);
+    benchVirtual<MBase2, MDerived>("multiple (thunk)", kinds, rounds);
+    benchVirtual<VBase, VDerived>("virtual base    ", kinds, rounds);
+
+    typedef variant<Plain<1>, Plain<2>, Plain<3>, Plain<4>> PlainVariant;
+    vector<PlainVariant> vars;
+    vars.reserve(n);
+    for (int k : kinds)
+    {
+        switch (k)
+        {
+        case 0:
+            vars.emplace_back(Plain<1>());
+            break;
+        case 1:
+            vars.emplace_back(Plain<2>());
+            break;
+        case 2:
+            vars.emplace_back(Plain<3>());
+            break;
+        default:
+            vars.emplace_back(Plain<4>());
+        }
+    }
+    run("variant std::visit     ", n, rounds, [&]()
+        {
+        long sum = 0;
+        for (size_t i = 0; i < vars.size(); i++)
+            sum += visit([i](const auto &p) { return p.f((long)i); }, vars[i]);
+        return sum; });
+    run("variant jump_visit     ", n, rounds, [&]()
+        {
+        long sum = 0;
+        for (size_t i = 0; i < vars.size(); i++)
+            sum += jump_visit([i](const auto &p) { return p.f((long)i); }, vars[i]);
+        return sum; });
+
+    poly_collection<CrtpShape<1>, CrtpShape<2>, CrtpShape<3>, CrtpShape<4>> shapes;
+    for (int k : kinds)
+    {
+        switch (k)
+        {
+        case 0:
+            shapes.emplace<CrtpShape<1>>();
+            break;
+        case 1:
+            shapes.emplace<CrtpShape<2>>();
+            break;
+        case 2:
+            shapes.emplace<CrtpShape<3>>();
+            break;
+        default:
+            shapes.emplace<CrtpShape<4>>();
+        }
+    }
+    run("crtp poly_collection   ", shapes.size(), rounds, [&]()
+        {
+        long sum = 0, i = 0;
+        shapes.for_each([&](const auto &s) { sum += callF(s, i++); });
+        return sum; });
+    return 0;
+}
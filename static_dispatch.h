@@ -0,0 +1,121 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// 虚函数调用的几种替代方案，用法与测试见 static_dispatch.cc
+//
+// vtable.cc 中的每次 Base::f 调用都是：取 vptr -> 取虚表项 ->（多继承/虚继承时还要经过 thunk 调整 this）-> 间接跳转。
+// 间接跳转本身不贵，贵的是目标随元素类型变化时分支预测失败，以及编译器无法内联。
+//
+//      crtp<Derived>            静态多态，类型在编译期确定，调用可以完全内联
+//      jump_visit(vis, var)     封闭类型集合的 variant，按 index() 查函数指针表分发，没有 vptr 与 thunk
+//      sort_by_dynamic_type     异构集合先按动态类型排序，同类型的虚调用连续发生，间接分支总能预测对
+//      poly_collection<Ts...>   每种类型一段连续数组，按段调用，段内是静态调用
+
+#pragma region CRTP
+/**
+ * 基类模板以派生类为参数，基类中通过 static_cast<Derived *>(this) 调用派生类的实现，
+ * 没有虚函数，因此也没有 vptr，对象更小；代价是不同派生类的对象不能放进同一个容器。
+ */
+template <typename Derived>
+struct crtp
+{
+    Derived &self() { return static_cast<Derived &>(*this); }
+    const Derived &self() const { return static_cast<const Derived &>(*this); }
+};
+#pragma endregion
+
+#pragma region variant 跳转表
+/**
+ * 对每个备选类型生成一个普通函数，放进 constexpr 函数指针数组，按 variant::index() 下标调用。
+ * 与 std::visit 的实现思路相同，但只支持单个 variant，生成的代码更直接，便于对比。
+ */
+template <typename Visitor, typename Variant, size_t I>
+decltype(auto) jump_visit_one(Visitor &vis, Variant &v)
+{
+    return vis(*std::get_if<I>(&v));
+}
+
+template <typename Visitor, typename Variant, size_t... I>
+decltype(auto) jump_visit_impl(Visitor &vis, Variant &v, std::index_sequence<I...>)
+{
+    using R = decltype(vis(*std::get_if<0>(&v)));
+    static constexpr R (*table[])(Visitor &, Variant &) = {&jump_visit_one<Visitor, Variant, I>...};
+    return table[v.index()](vis, v);
+}
+
+template <typename Visitor, typename... Ts>
+decltype(auto) jump_visit(Visitor &&vis, std::variant<Ts...> &v)
+{
+    return jump_visit_impl(vis, v, std::index_sequence_for<Ts...>{});
+}
+#pragma endregion
+
+#pragma region 按动态类型排序
+/**
+ * 只改变元素顺序，不改变调用方式：排序后同一类型的对象相邻，
+ * 连续的虚调用目标相同，间接分支预测器几乎不会失败。适合需要反复遍历、很少增删的集合。
+ * 注意排序后按指针访问对象的内存顺序会变差，对象较大时收益可能被 cache miss 抵消，poly_collection 没有这个问题。
+ */
+template <typename Base>
+void sort_by_dynamic_type(std::vector<Base *> &objs)
+{
+    std::vector<std::pair<std::type_index, Base *>> keyed;
+    keyed.reserve(objs.size());
+    for (Base *p : objs)
+        keyed.emplace_back(std::type_index(typeid(*p)), p);
+    std::stable_sort(keyed.begin(), keyed.end(), [](const auto &a, const auto &b)
+                     { return a.first < b.first; });
+    for (size_t i = 0; i < objs.size(); i++)
+        objs[i] = keyed[i].second;
+}
+#pragma endregion
+
+#pragma region poly_collection
+/**
+ * 与 boost::poly_collection 的思路相同：按具体类型分段存储，
+ * for_each 对每一段用具体类型调用 f，编译器可以内联，段内数据连续，也利于预取。
+ * 元素之间原有的插入顺序不保留。
+ */
+template <typename... Ts>
+class poly_collection
+{
+public:
+    template <typename T>
+    void insert(T value) { std::get<std::vector<T>>(segments).push_back(std::move(value)); }
+
+    template <typename T, typename... Args>
+    T &emplace(Args &&...args) { return std::get<std::vector<T>>(segments).emplace_back(std::forward<Args>(args)...); }
+
+    template <typename F>
+    void for_each(F &&f)
+    {
+        std::apply([&](auto &...segs)
+                   { (for_each_segment(segs, f), ...); },
+                   segments);
+    }
+
+    size_t size() const
+    {
+        return std::apply([](const auto &...segs)
+                          { return (segs.size() + ... + size_t(0)); },
+                          segments);
+    }
+
+private:
+    template <typename Seg, typename F>
+    static void for_each_segment(Seg &seg, F &f)
+    {
+        for (auto &x : seg)
+            f(x);
+    }
+
+    std::tuple<std::vector<Ts>...> segments;
+};
+#pragma endregion
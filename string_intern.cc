@@ -0,0 +1,110 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <thread>
+#include "lru_cache.h"
+#include "string_intern.h"
+using namespace std;
+
+// 对比 std::string 与 interned_string 作为 key 时的比较、哈希与 LRU_Cache 查找开销
+// 编译：g++ -std=c++17 -O2 -pthread string_intern.cc -o string_intern
+
+static double nsPer(chrono::steady_clock::time_point begin, double ops)
+{
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count() / ops;
+}
+
+static volatile long sink;
+
+int main(int argc, char const *argv[])
+{
+    const int distinct = 50000, capacity = 40000;
+    const long ops = 2000000;
+
+    // 与 string_literal.cc 对照：相同内容的两个动态字符串驻留后地址相同
+    string a = "Hello World", b = string("Hello ") + "World";
+    interned_string ia(a), ib(b);
+    cout << "a:" << (void *)a.data() << " b:" << (void *)b.data() << "  interned a:" << (void *)ia.c_str()
+         << " b:" << (void *)ib.c_str() << (ia == ib ? "  (same)" : "  (different)") << endl;
+    cout << "interned_string() == intern(\"\"): " << (interned_string() == intern("") ? "yes" : "NO") << endl;
+
+    vector<string> names;
+    for (int i = 0; i < distinct; i++)
+        names.push_back("service.frontend.http.requests.latency." + to_string(i));
+
+    // 并发驻留：4 个线程同时驻留同一批字符串，结果必须一致
+    vector<vector<interned_string>> perThread(4, vector<interned_string>(distinct));
+    auto begin = chrono::steady_clock::now();
+    {
+        vector<thread> threads;
+        for (int t = 0; t < 4; t++)
+            threads.emplace_back([&, t]()
+                                 {
+                for (int i = 0; i < distinct; i++)
+                    perThread[t][i] = intern(names[(i + t * 997) % distinct]); });
+        for (auto &t : threads)
+            t.join();
+    }
+    double internNs = nsPer(begin, 4.0 * distinct);
+    bool consistent = true;
+    for (int t = 1; t < 4; t++)
+        for (int i = 0; i < distinct; i++)
+            consistent = consistent && perThread[t][i] == perThread[0][(i + t * 997) % distinct];
+    vector<interned_string> keys(perThread[0]);
+    cout << "intern: " << internNs << " ns/op, " << StringInternPool::instance().size() << " strings, "
+         << StringInternPool::instance().arenaBytes() << " arena bytes, "
+         << (consistent ? "consistent across threads" : "INCONSISTENT") << endl;
+
+    // 热路径上查询已有的字符串：不加锁
+    begin = chrono::steady_clock::now();
+    for (long i = 0; i < ops; i++)
+        sink += intern(names[i % distinct]).size();
+    cout << "intern (existing): " << nsPer(begin, ops) << " ns/op" << endl;
+
+    mt19937 rng(11);
+    vector<int> order(ops);
+    for (auto &o : order)
+        o = rng() % distinct;
+
+    // 相等比较 + 哈希
+    begin = chrono::steady_clock::now();
+    long hits = 0;
+    for (long i = 0; i < ops; i++)
+    {
+        const string &x = names[order[i]];
+        hits += (x == names[(order[i] + 1) % distinct]) + hash<string>()(x) % 2;
+    }
+    double strCmp = nsPer(begin, ops);
+    begin = chrono::steady_clock::now();
+    for (long i = 0; i < ops; i++)
+    {
+        const interned_string &x = keys[order[i]];
+        hits += (x == keys[(order[i] + 1) % distinct]) + hash<interned_string>()(x) % 2;
+    }
+    double internCmp = nsPer(begin, ops);
+    sink = hits;
+    cout << "compare+hash: std::string " << strCmp << " ns, interned_string " << internCmp << " ns" << endl;
+
+    // LRU_Cache 的 key 类型
+    LRU_Cache<string, long> strCache(capacity);
+    LRU_Cache<interned_string, long> internCache(capacity);
+    begin = chrono::steady_clock::now();
+    for (long i = 0; i < ops; i++)
+    {
+        const string &k = names[order[i]];
+        if (!strCache.get(k))
+            strCache.put(k, make_shared<long>(i));
+    }
+    double strLru = nsPer(begin, ops);
+    begin = chrono::steady_clock::now();
+    for (long i = 0; i < ops; i++)
+    {
+        const interned_string &k = keys[order[i]];
+        if (!internCache.get(k))
+            internCache.put(k, make_shared<long>(i));
+    }
+    double internLru = nsPer(begin, ops);
+    cout << "LRU_Cache get/put: std::string key " << strLru << " ns/op, interned_string key " << internLru
+         << " ns/op" << endl;
+    return 0;
+}
@@ -0,0 +1,211 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/** 运行期的字符串驻留池
+ *
+ * string_literal.cc 中 c == d == f：编译器把相同的字面值合并到 .rodata 的同一个地址上，
+ * 比较两个字面值指针就等于比较内容。这里把同样的效果搬到运行期的动态字符串上：
+ *      intern("cpu.load") 对相同的内容永远返回同一个地址，
+ *      interned_string 只是一个指针，== 是指针比较，hash 在驻留时算好并和字符一起存放。
+ *
+ * 实现：
+ *      按 hash 高 6 位分成 64 个分片，每个分片一张开放寻址表 + 一个只追加的 arena；
+ *      条目一旦写入永不删除、永不移动，因此查找已存在的字符串完全不加锁：
+ *          读者 acquire 读取表指针与槽位，写者在分片锁内写好条目后 release 发布；
+ *      表扩容时新表整体发布，旧表不释放（条目只增不减，旧表最多占新表一半的空间），直到程序退出。
+ * 驻留的字符串在进程生命周期内一直有效，适合取值范围有限的 key（指标名、缓存 key 前缀等）。
+ */
+class StringInternPool
+{
+public:
+    struct Entry
+    {
+        size_t hash;
+        uint32_t len;
+        char data[1]; // 实际长度为 len + 1，以 '\0' 结尾
+    };
+
+    static StringInternPool &instance()
+    {
+        static StringInternPool pool;
+        return pool;
+    }
+
+    const Entry *intern(std::string_view s)
+    {
+        if (s.empty())
+            return empty(); // 与默认构造的 interned_string 是同一个条目
+        size_t h = std::hash<std::string_view>()(s);
+        Shard &shard = shards[h >> (64 - SHARD_BITS)];
+        if (const Entry *e = find(shard.table.load(std::memory_order_acquire), h, s))
+            return e;
+        return insert(shard, h, s);
+    }
+
+    // 已驻留的字符串个数与 arena 占用的字节数
+    size_t size() const
+    {
+        size_t n = 0;
+        for (const Shard &shard : shards)
+            n += shard.count.load(std::memory_order_relaxed);
+        return n;
+    }
+    size_t arenaBytes() const
+    {
+        size_t n = 0;
+        for (const Shard &shard : shards)
+            n += shard.arenaBytes.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    static const Entry *empty()
+    {
+        static const Entry e{std::hash<std::string_view>()(std::string_view()), 0, {0}};
+        return &e;
+    }
+
+private:
+    static const int SHARD_BITS = 6;
+    static const size_t CHUNK = 64 * 1024;
+
+    struct Table
+    {
+        size_t mask;
+        std::unique_ptr<std::atomic<const Entry *>[]> slots;
+        explicit Table(size_t capacity) : mask(capacity - 1), slots(new std::atomic<const Entry *>[capacity])
+        {
+            for (size_t i = 0; i < capacity; i++)
+                slots[i].store(nullptr, std::memory_order_relaxed);
+        }
+    };
+
+    struct alignas(64) Shard
+    {
+        std::atomic<Table *> table{nullptr};
+        std::atomic<size_t> count{0};
+        std::atomic<size_t> arenaBytes{0};
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Table>> tables; // 包含所有历史表，退出时统一释放
+        std::vector<std::unique_ptr<char[]>> chunks;
+        char *cursor = nullptr;
+        size_t left = 0;
+    };
+
+    StringInternPool() = default;
+
+    static const Entry *find(const Table *table, size_t h, std::string_view s)
+    {
+        if (!table)
+            return nullptr;
+        for (size_t i = h & table->mask;; i = (i + 1) & table->mask)
+        {
+            const Entry *e = table->slots[i].load(std::memory_order_acquire);
+            if (!e)
+                return nullptr;
+            if (e->hash == h && e->len == s.size() && memcmp(e->data, s.data(), s.size()) == 0)
+                return e;
+        }
+    }
+
+    static void place(Table *table, const Entry *e)
+    {
+        size_t i = e->hash & table->mask;
+        while (table->slots[i].load(std::memory_order_relaxed))
+            i = (i + 1) & table->mask;
+        table->slots[i].store(e, std::memory_order_release);
+    }
+
+    const Entry *insert(Shard &shard, size_t h, std::string_view s)
+    {
+        std::lock_guard<std::mutex> guard(shard.mutex);
+        Table *table = shard.table.load(std::memory_order_relaxed);
+        if (const Entry *e = find(table, h, s)) // 加锁期间可能已被别的线程插入
+            return e;
+
+        size_t count = shard.count.load(std::memory_order_relaxed);
+        if (!table || (count + 1) * 2 > table->mask + 1)
+        {
+            // 负载因子保持在 1/2 以下，新表填好后整体发布
+            auto bigger = std::make_unique<Table>(table ? (table->mask + 1) * 2 : 64);
+            if (table)
+                for (size_t i = 0; i <= table->mask; i++)
+                    if (const Entry *e = table->slots[i].load(std::memory_order_relaxed))
+                        place(bigger.get(), e);
+            table = bigger.get();
+            shard.tables.push_back(std::move(bigger));
+            shard.table.store(table, std::memory_order_release);
+        }
+
+        Entry *e = allocate(shard, offsetof(Entry, data) + s.size() + 1);
+        e->hash = h;
+        e->len = (uint32_t)s.size();
+        memcpy(e->data, s.data(), s.size());
+        e->data[s.size()] = '\0';
+        place(table, e);
+        shard.count.store(count + 1, std::memory_order_relaxed);
+        return e;
+    }
+
+    static Entry *allocate(Shard &shard, size_t bytes)
+    {
+        bytes = (bytes + alignof(Entry) - 1) & ~(alignof(Entry) - 1);
+        if (bytes > shard.left)
+        {
+            size_t size = bytes > CHUNK ? bytes : CHUNK; // 超长字符串单独占一块
+            shard.chunks.emplace_back(new char[size]);
+            shard.cursor = shard.chunks.back().get();
+            shard.left = size;
+            shard.arenaBytes.fetch_add(size, std::memory_order_relaxed);
+        }
+        Entry *e = reinterpret_cast<Entry *>(shard.cursor);
+        shard.cursor += bytes;
+        shard.left -= bytes;
+        return e;
+    }
+
+    Shard shards[1 << SHARD_BITS];
+};
+
+class interned_string
+{
+public:
+    interned_string() : e(StringInternPool::empty()) {}
+    explicit interned_string(std::string_view s) : e(StringInternPool::instance().intern(s)) {}
+
+    std::string_view view() const { return std::string_view(e->data, e->len); }
+    const char *c_str() const { return e->data; }
+    size_t size() const { return e->len; }
+    bool empty() const { return e->len == 0; }
+    size_t hash() const { return e->hash; }
+
+    // 相同内容一定是同一个条目，因此比较指针即可
+    bool operator==(const interned_string &other) const { return e == other.e; }
+    bool operator!=(const interned_string &other) const { return e != other.e; }
+    // 按内容的字典序，用于有序容器；只需要任意全序时可以直接比较 hash 与地址
+    bool operator<(const interned_string &other) const { return view() < other.view(); }
+
+    friend std::ostream &operator<<(std::ostream &os, const interned_string &s) { return os << s.view(); }
+
+private:
+    const StringInternPool::Entry *e;
+};
+
+inline interned_string intern(std::string_view s) { return interned_string(s); }
+
+namespace std
+{
+    template <>
+    struct hash<interned_string>
+    {
+        size_t operator()(const interned_string &s) const { return s.hash(); }
+    };
+} // namespace std
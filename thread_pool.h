@@ -0,0 +1,123 @@
+#pragma once
+#include <thread>
+#include <future>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include <queue>
+#include "layout.h"
+
+// packaged_task 的分配策略，默认使用 std::make_shared，pool_ptr.h 中提供了从对象池分配的版本
+struct SharedTaskAlloc
+{
+    template <typename T, typename... Args>
+    static std::shared_ptr<T> make(Args &&...args) { return std::make_shared<T>(std::forward<Args>(args)...); }
+};
+
+/**
+ * 任务队列：push 在队列关闭后返回 false，pop 阻塞到有任务为止，队列关闭后返回 false（未执行的任务被丢弃）。
+ * 默认是互斥锁 + 条件变量保护的 std::queue；lockfree_queue.h 中的 blocking_queue 满足同样的接口。
+ */
+template <typename Task>
+class LockedTaskQueue
+{
+public:
+    bool push(Task &&task)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (closed)
+                return false;
+            _tasks.push(std::move(task));
+        }
+        _condition.notify_one();
+        return true;
+    }
+
+    bool pop(Task &task)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (!closed && _tasks.empty())
+        {
+            _condition.wait(lock);
+        }
+        if (closed)
+            return false;
+
+        task = std::move(_tasks.front());
+        _tasks.pop();
+        return true;
+    }
+
+    void close()
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            closed = true;
+        }
+        _condition.notify_all();
+    }
+
+private:
+    std::queue<Task> _tasks;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool closed = false;
+};
+
+template <typename TaskAlloc = SharedTaskAlloc, template <typename> class TaskQueue = LockedTaskQueue>
+class BasicThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+    BasicThreadPool(size_t size) : _size(size)
+    {
+        LAYOUT_SEPARATE_LINES(BasicThreadPool, _size, _tasks);
+        LAYOUT_SEPARATE_LINES(BasicThreadPool, _tasks, _threads);
+        for (size_t i = 0; i < _size; i++)
+        {
+            _threads.emplace_back(new std::thread([this]()
+                                                  {
+                Task task;
+                while (this->_tasks->pop(task))
+                    task(); }));
+        }
+    }
+
+    ~BasicThreadPool()
+    {
+        _tasks->close();
+
+        for (auto &t : _threads)
+        {
+            t->join();
+        }
+    }
+
+    template <typename Func, typename... Args>
+    decltype(auto) enqueue(Func &&func, Args &&...args)
+    {
+        auto task = TaskAlloc::template make<std::packaged_task<void()>>(std::bind(std::forward<Func>(func),
+                                                                                   std::forward<Args>(args)...));
+        auto res = task->get_future();
+
+        if (!_tasks->push(Task([task]()
+                              { (*task)(); })))
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        return res;
+    }
+
+    size_t size() const { return _size; }
+
+private:
+    size_t _size;
+
+    // 每次 enqueue 和每个 worker 取任务都要写队列（锁、条件变量、队首队尾），
+    // 单独占 cache line，不与只读的 _size、_threads 以及相邻的其他对象伪共享
+    cache_padded<TaskQueue<Task>> _tasks;
+    std::vector<std::unique_ptr<std::thread>> _threads;
+};
+
+typedef BasicThreadPool<> ThreadPool;
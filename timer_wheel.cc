@@ -0,0 +1,191 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <vector>
+#include "timer_wheel.h"
+using namespace std;
+
+// 一百万个定时器：分层时间轮与 std::priority_queue 的插入、取消、触发开销；以及 TimerService 的触发延迟
+// 编译：g++ -std=c++17 -O2 -pthread timer_wheel.cc -o timer_wheel
+
+/**
+ * 基线：小顶堆，取消只能打标记（堆中间的元素无法 O(1) 删除），到期弹出时再跳过，
+ * 被取消的定时器一直占着堆直到它原本的到期时刻。插入、弹出都是 O(log n)。
+ */
+class HeapTimer
+{
+public:
+    typedef function<void()> Callback;
+
+    TimerId insert(uint64_t expire, Callback callback)
+    {
+        TimerId id = callbacks.size();
+        callbacks.push_back(std::move(callback));
+        cancelled.push_back(false);
+        heap.push({expire, id});
+        return id;
+    }
+
+    bool cancel(TimerId id)
+    {
+        if (id >= cancelled.size() || cancelled[id] || !callbacks[id])
+            return false;
+        cancelled[id] = true;
+        return true;
+    }
+
+    void advance(uint64_t now, vector<Callback> &due)
+    {
+        while (!heap.empty() && heap.top().first <= now)
+        {
+            TimerId id = heap.top().second;
+            heap.pop();
+            if (!cancelled[id])
+                due.push_back(std::move(callbacks[id]));
+            callbacks[id] = nullptr;
+        }
+    }
+
+private:
+    typedef pair<uint64_t, TimerId> Entry;
+    priority_queue<Entry, vector<Entry>, greater<Entry>> heap;
+    vector<Callback> callbacks;
+    vector<bool> cancelled;
+};
+
+static double elapsedMs(chrono::steady_clock::time_point t0)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+// 插入 n 个到期时刻随机分布在 [1, horizon] 的定时器，取消其中一半，再逐个 tick 推进直到全部触发
+// 回调检查自己是否恰好在到期的 tick 被取出
+template <typename Timer>
+void bench(const char *name, const vector<uint64_t> &expires, uint64_t horizon)
+{
+    Timer timer;
+    uint64_t now = 0;
+    long fired = 0, wrong = 0;
+    vector<TimerId> ids(expires.size());
+
+    auto t0 = chrono::steady_clock::now();
+    for (size_t i = 0; i < expires.size(); i++)
+    {
+        uint64_t expire = expires[i];
+        ids[i] = timer.insert(expire, [&, expire]()
+                              { fired++; wrong += expire != now; });
+    }
+    double insertMs = elapsedMs(t0);
+
+    t0 = chrono::steady_clock::now();
+    for (size_t i = 0; i < ids.size(); i += 2)
+        timer.cancel(ids[i]);
+    double cancelMs = elapsedMs(t0);
+
+    vector<TimerWheel::Callback> due;
+    t0 = chrono::steady_clock::now();
+    for (now = 1; now <= horizon; now++)
+    {
+        timer.advance(now, due);
+        for (auto &callback : due)
+            callback();
+        due.clear();
+    }
+    double fireMs = elapsedMs(t0);
+
+    size_t n = expires.size();
+    cout << left << setw(16) << name << right << fixed << setprecision(1) << setw(12) << insertMs * 1e6 / n
+         << setw(12) << cancelMs * 1e6 / (n / 2) << setw(12) << fireMs * 1e6 / fired << setw(10) << fired
+         << setw(8) << wrong << defaultfloat << endl;
+}
+
+// 在线程池上调度大量一次性定时器与一个周期任务，统计实际触发时刻相对于预定时刻的延迟
+void service()
+{
+    const int N = 100000;
+    const auto SPAN = chrono::milliseconds(300);
+    ThreadPool pool(4);
+    TimerService timers(pool);
+
+    vector<double> lateness(N);
+    atomic<int> fired(0), ticks(0), cancelledFired(0);
+    mt19937_64 rng(7);
+    auto start = chrono::steady_clock::now();
+    vector<TimerId> ids(N);
+    for (int i = 0; i < N; i++)
+    {
+        auto when = start + chrono::microseconds(rng() % chrono::duration_cast<chrono::microseconds>(SPAN).count());
+        ids[i] = timers.schedule_at(when, [&, i, when]()
+                                    {
+                                        lateness[i] = chrono::duration<double, milli>(chrono::steady_clock::now() - when).count();
+                                        fired++; });
+    }
+    // 取消 1/10
+    int cancelled = 0;
+    for (int i = 0; i < N; i += 10)
+        cancelled += timers.cancel(ids[i]);
+    TimerId periodic = timers.schedule_every(chrono::milliseconds(20), [&]()
+                                             { ticks++; });
+    // 周期不是 tick 的整数倍：第 k 次不能早于 k * 1.5ms（回调在线程池上执行，记录时刻时加锁）
+    const auto FINE = chrono::microseconds(1500);
+    mutex fineMutex;
+    vector<chrono::steady_clock::time_point> fineTimes;
+    auto fineStart = chrono::steady_clock::now();
+    TimerId fine = timers.schedule_every(FINE, [&]()
+                                         {
+                                             lock_guard<mutex> guard(fineMutex);
+                                             fineTimes.push_back(chrono::steady_clock::now()); });
+    TimerId never = timers.schedule_after(chrono::seconds(10), [&]()
+                                          { cancelledFired++; });
+
+    this_thread::sleep_for(SPAN + chrono::milliseconds(100));
+    timers.cancel(periodic);
+    timers.cancel(fine);
+    timers.cancel(never);
+
+    vector<double> late;
+    for (int i = 0; i < N; i++)
+        if (i % 10)
+            late.push_back(lateness[i]);
+    sort(late.begin(), late.end());
+    auto pct = [&](double p)
+    { return late[size_t(p * (late.size() - 1))]; };
+    cout << "TimerService: " << N << " timers over " << SPAN.count() << "ms on " << pool.size() << " workers, "
+         << cancelled << " cancelled, fired " << fired << ", pending " << timers.pending() << endl;
+    cout << fixed << setprecision(2) << "  lateness ms: min " << late.front() << "  p50 " << pct(0.5) << "  p99 "
+         << pct(0.99) << "  max " << late.back() << defaultfloat << endl;
+    cout << "  every 20ms over " << (SPAN + chrono::milliseconds(100)).count() << "ms: " << ticks
+         << " runs; cancelled 10s timer fired " << cancelledFired << " times" << endl;
+    // 回调并发执行，记录的顺序不一定是触发顺序，排序后第 k 个与第 k 个截止时刻比较
+    lock_guard<mutex> guard(fineMutex);
+    sort(fineTimes.begin(), fineTimes.end());
+    int early = 0;
+    for (size_t k = 0; k < fineTimes.size(); k++)
+        early += fineTimes[k] < fineStart + FINE * (k + 1);
+    cout << "  every 1.5ms on a 1ms tick: " << fineTimes.size() << " runs (" << (SPAN + chrono::milliseconds(100)) / FINE
+         << " expected), fired early " << early << " times" << endl;
+}
+
+int main()
+{
+    const size_t N = 1000000;
+    const uint64_t HORIZON = 1 << 20; // 1ms 一个 tick 时约 17 分钟，覆盖时间轮的前三层
+    mt19937_64 rng(42);
+    vector<uint64_t> expires(N);
+    for (auto &e : expires)
+        e = 1 + rng() % HORIZON;
+
+    cout << N << " timers, expiry uniform in [1, " << HORIZON << "] ticks, half cancelled" << endl;
+    cout << left << setw(16) << "" << right << setw(12) << "insert ns" << setw(12) << "cancel ns" << setw(12)
+         << "fire ns" << setw(10) << "fired" << setw(8) << "wrong" << endl;
+    bench<TimerWheel>("timer wheel", expires, HORIZON);
+    bench<HeapTimer>("priority_queue", expires, HORIZON);
+    cout << endl;
+
+    service();
+    return 0;
+}
@@ -0,0 +1,396 @@
+#pragma once
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "thread_pool.h"
+
+// 分层时间轮与基于它的定时任务调度，用法与基准见 timer_wheel.cc
+//
+//      TimerWheel               纯数据结构（不加锁），插入、取消 O(1)，每个 tick 摊还 O(1)
+//      BasicTimerService<Pool>  一个定时线程（timerfd 驱动）推进时间轮，把到期的任务成批提交给线程池，
+//                               提供 schedule_after / schedule_at / schedule_every / cancel
+
+typedef uint64_t TimerId;
+
+#pragma region TimerWheel
+/**
+ * 4 层，每层 256 个槽，第 L 层的一个槽跨 256^L 个 tick，总共覆盖 2^32 个 tick（1ms 一个 tick 约 49 天），更远的放进 overflow。
+ * 插入时按与当前 tick 的距离选择层：距离 < 256 放第 0 层，槽号就是到期 tick 的低 8 位；
+ * 第 0 层转满一圈（tick 低 8 位回到 0）时，把第 1 层当前槽中的定时器重新插入（cascade），它们会落到第 0 层，依此类推。
+ *
+ * 周期定时器记录下一次的截止时刻（以 unit 为单位，一个 tick 包含 unit 个单位），每次触发后加上周期、再向上取整到 tick，
+ * 周期不是 tick 的整数倍时（1ms 一个 tick 上每 1.5ms 一次）既不会早于截止时刻触发，也不会累积漂移。
+ *
+ * 定时器存放在 slab（vector + 空闲链表）中，槽内是以下标相连的双向链表，取消时直接摘链。
+ * TimerId 的高 32 位是代数，节点被回收后旧的 id 自动失效，对已触发或已取消的定时器调用 cancel 是安全的。
+ */
+class TimerWheel
+{
+public:
+    typedef std::function<void()> Callback;
+
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 8;
+    static constexpr int SLOTS = 1 << SLOT_BITS;
+
+    explicit TimerWheel(uint64_t now = 0, uint64_t unit = 1) : current(now), unit(unit ? unit : 1)
+    {
+        heads.assign(LEVELS * SLOTS + 1, NIL);
+    }
+
+    // 在第 expire 个 tick 触发；period 不为 0 时每隔 period 个 tick 重复
+    TimerId insert(uint64_t expire, Callback callback, uint64_t period = 0)
+    {
+        return insert_at(expire * unit, std::move(callback), period * unit);
+    }
+
+    // 截止时刻与周期以 unit 为单位：在 deadline 向上取整的 tick 触发，第 k 次重复的截止时刻为 deadline + k * period
+    TimerId insert_at(uint64_t deadline, Callback callback, uint64_t period = 0)
+    {
+        uint32_t index = allocate();
+        Node &n = nodes[index];
+        n.deadline = deadline;
+        n.expire = expireOf(deadline);
+        n.period = period;
+        n.callback = std::move(callback);
+        link(index);
+        count++;
+        return TimerId(n.generation) << 32 | index;
+    }
+
+    bool cancel(TimerId id)
+    {
+        uint32_t index = uint32_t(id);
+        if (index >= nodes.size() || nodes[index].generation != uint32_t(id >> 32) || nodes[index].list == FREE)
+            return false;
+        unlink(index);
+        release(index);
+        count--;
+        return true;
+    }
+
+    /**
+     * 推进到第 now 个 tick，把到期的回调追加到 due；周期定时器复制回调并重新插入，id 保持不变。
+     * 时间轮为空时直接跳到 now。
+     */
+    void advance(uint64_t now, std::vector<Callback> &due)
+    {
+        while (current < now)
+        {
+            if (count == 0)
+            {
+                current = now;
+                break;
+            }
+            current++;
+            // 从低层到高层检查是否转满一圈，高层的槽先下放，最后处理第 0 层当前槽
+            for (int level = 1; level <= LEVELS; level++)
+            {
+                if ((current >> (SLOT_BITS * (level - 1))) & (SLOTS - 1))
+                    break;
+                cascade(level == LEVELS ? OVERFLOW_LIST : listOf(level, slotOf(level, current)));
+            }
+            uint32_t list = listOf(0, current & (SLOTS - 1));
+            while (heads[list] != NIL)
+            {
+                uint32_t index = heads[list];
+                Node &n = nodes[index];
+                unlink(index);
+                if (n.period)
+                {
+                    due.push_back(n.callback);
+                    n.deadline += n.period;
+                    n.expire = expireOf(n.deadline);
+                    link(index);
+                }
+                else
+                {
+                    due.push_back(std::move(n.callback));
+                    release(index);
+                    count--;
+                }
+            }
+        }
+    }
+
+    /**
+     * 下一次需要调用 advance 的 tick：第 0 层中最早到期的定时器，或第 0 层转满一圈、需要把高层下放的 tick，取较早者；
+     * 时间轮为空时为 UINT64_MAX。第 0 层中的定时器都在 256 个 tick 之内，槽号就是到期 tick 的低 8 位，
+     * 所以从下一个 tick 起按顺序找到的第一个非空槽就是最早的，最多检查 256 个槽。
+     */
+    uint64_t next_expire() const
+    {
+        if (count == 0)
+            return UINT64_MAX;
+        uint64_t wrap = (current | (SLOTS - 1)) + 1;
+        for (uint64_t t = current + 1; t < wrap; t++)
+            if (heads[listOf(0, t & (SLOTS - 1))] != NIL)
+                return t;
+        return wrap;
+    }
+
+    uint64_t now() const { return current; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+    static constexpr uint32_t FREE = UINT32_MAX;
+    static constexpr uint32_t OVERFLOW_LIST = LEVELS * SLOTS;
+
+    struct Node
+    {
+        uint64_t expire;
+        uint64_t deadline, period; // 以 unit 为单位
+        uint32_t prev, next;
+        uint32_t list = FREE; // 所在的槽，FREE 表示在空闲链表中
+        uint32_t generation = 0;
+        Callback callback;
+    };
+
+    // 已经过去的 tick 不会再处理，放到下一个 tick
+    uint64_t expireOf(uint64_t deadline) const { return std::max(deadline / unit + (deadline % unit != 0), current + 1); }
+
+    static uint32_t slotOf(int level, uint64_t tick) { return (tick >> (SLOT_BITS * level)) & (SLOTS - 1); }
+    static uint32_t listOf(int level, uint32_t slot) { return level * SLOTS + slot; }
+
+    void link(uint32_t index)
+    {
+        Node &n = nodes[index];
+        uint64_t delta = n.expire - current;
+        uint32_t list = OVERFLOW_LIST;
+        for (int level = 0; level < LEVELS; level++)
+            if (delta < (uint64_t(1) << (SLOT_BITS * (level + 1))))
+            {
+                list = listOf(level, slotOf(level, n.expire));
+                break;
+            }
+        n.list = list;
+        n.prev = NIL;
+        n.next = heads[list];
+        if (n.next != NIL)
+            nodes[n.next].prev = index;
+        heads[list] = index;
+    }
+
+    void unlink(uint32_t index)
+    {
+        Node &n = nodes[index];
+        if (n.prev != NIL)
+            nodes[n.prev].next = n.next;
+        else
+            heads[n.list] = n.next;
+        if (n.next != NIL)
+            nodes[n.next].prev = n.prev;
+    }
+
+    void cascade(uint32_t list)
+    {
+        uint32_t index = heads[list];
+        heads[list] = NIL;
+        while (index != NIL)
+        {
+            uint32_t next = nodes[index].next;
+            link(index);
+            index = next;
+        }
+    }
+
+    uint32_t allocate()
+    {
+        if (freeHead != NIL)
+        {
+            uint32_t index = freeHead;
+            freeHead = nodes[index].next;
+            return index;
+        }
+        if (nodes.size() >= NIL)
+            throw std::length_error("too many timers");
+        nodes.emplace_back();
+        return uint32_t(nodes.size() - 1);
+    }
+
+    void release(uint32_t index)
+    {
+        Node &n = nodes[index];
+        n.callback = nullptr;
+        n.list = FREE;
+        n.generation++;
+        n.next = freeHead;
+        freeHead = index;
+    }
+
+    uint64_t current;
+    uint64_t unit;
+    size_t count = 0;
+    std::vector<uint32_t> heads;
+    std::vector<Node> nodes;
+    uint32_t freeHead = NIL;
+};
+#pragma endregion
+
+#pragma region BasicTimerService
+/**
+ * 定时线程 poll 一个 timerfd 与一个 eventfd：
+ *      timerfd 是单次的绝对定时，定在 next_expire 对应的时刻（最早到期的定时器，或至多 256 个 tick 后的下一次 cascade），
+ *      插入更早的定时器时提前，时间轮为空时解除，没有定时器到期的 tick 不会被唤醒；
+ *      eventfd 用于析构时通知线程退出。
+ * 每次唤醒把时间轮推进到当前 tick，到期的回调按线程池大小分成若干批，每批作为一个任务提交，
+ * 大量定时器同时到期时不会为每个定时器各提交一次任务。回调在线程池中执行，不会阻塞定时线程。
+ * 精度为一个 tick（默认 1ms），回调最早在到期时刻触发，最晚约晚一个 tick 加上线程池的排队时间。
+ */
+template <typename Pool = ThreadPool>
+class BasicTimerService
+{
+public:
+    typedef std::chrono::steady_clock clock;
+    typedef TimerWheel::Callback Callback;
+
+    explicit BasicTimerService(Pool &pool, std::chrono::nanoseconds tick = std::chrono::milliseconds(1))
+        : pool(pool), tick(tick), origin(clock::now()), wheel(0, uint64_t(tick.count()))
+    {
+        timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+        wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (timerFd < 0 || wakeFd < 0)
+            throw std::runtime_error("timerfd/eventfd unavailable");
+        worker = std::thread([this]()
+                             { loop(); });
+    }
+
+    ~BasicTimerService()
+    {
+        stop.store(true);
+        uint64_t one = 1;
+        (void)!write(wakeFd, &one, sizeof(one));
+        worker.join();
+        close(timerFd);
+        close(wakeFd);
+    }
+
+    template <typename Rep, typename Period>
+    TimerId schedule_after(std::chrono::duration<Rep, Period> delay, Callback callback)
+    {
+        return schedule_at(clock::now() + delay, std::move(callback));
+    }
+
+    TimerId schedule_at(clock::time_point when, Callback callback)
+    {
+        return add(nsAt(when), std::move(callback), 0);
+    }
+
+    // 第 k 次在开始后 k * interval 的时刻触发（k 从 1 开始），直到 cancel；interval 不必是 tick 的整数倍
+    template <typename Rep, typename Period>
+    TimerId schedule_every(std::chrono::duration<Rep, Period> interval, Callback callback)
+    {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(interval);
+        return add(nsAt(clock::now() + ns), std::move(callback), uint64_t(std::max<int64_t>(1, ns.count())));
+    }
+
+    bool cancel(TimerId id)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        return wheel.cancel(id);
+    }
+
+    size_t pending()
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        return wheel.size();
+    }
+
+private:
+    // 时间轮以纳秒为单位记录截止时刻（到期 tick 向上取整），推进时向下取整，保证不会早于预定时刻触发
+    uint64_t nsAt(clock::time_point when) const
+    {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(when - origin);
+        return ns.count() <= 0 ? 0 : uint64_t(ns.count());
+    }
+
+    uint64_t ticksAt(clock::time_point when) const { return nsAt(when) / uint64_t(tick.count()); }
+
+    TimerId add(uint64_t deadline, Callback callback, uint64_t period)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        TimerId id = wheel.insert_at(deadline, std::move(callback), period);
+        rearm();
+        return id;
+    }
+
+    // 持有 mutex 时调用：timerfd 定在下一次需要推进的 tick 开始的时刻，时间轮为空时解除
+    void rearm()
+    {
+        uint64_t next = wheel.next_expire();
+        if (next == armedAt)
+            return;
+        itimerspec spec{};
+        if (next != UINT64_MAX)
+        {
+            // steady_clock 即 CLOCK_MONOTONIC
+            auto at = std::chrono::duration_cast<std::chrono::nanoseconds>(origin.time_since_epoch()) + tick * next;
+            spec.it_value = {time_t(at.count() / 1000000000), long(at.count() % 1000000000)};
+        }
+        timerfd_settime(timerFd, next == UINT64_MAX ? 0 : TFD_TIMER_ABSTIME, &spec, nullptr);
+        armedAt = next;
+    }
+
+    void loop()
+    {
+        pollfd fds[2] = {{timerFd, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+        std::vector<Callback> due;
+        while (!stop.load())
+        {
+            if (poll(fds, 2, -1) < 0)
+                continue;
+            uint64_t expirations;
+            bool fired = read(timerFd, &expirations, sizeof(expirations)) == sizeof(expirations);
+            {
+                std::lock_guard<std::mutex> guard(mutex);
+                if (fired)
+                    armedAt = UINT64_MAX; // 单次定时已经用掉，rearm 必须重新设置
+                wheel.advance(ticksAt(clock::now()), due);
+                rearm();
+            }
+            dispatch(due);
+        }
+    }
+
+    void dispatch(std::vector<Callback> &due)
+    {
+        if (due.empty())
+            return;
+        size_t batch = std::max<size_t>(64, (due.size() + pool.size() - 1) / pool.size());
+        for (size_t i = 0; i < due.size(); i += batch)
+        {
+            auto chunk = std::make_shared<std::vector<Callback>>(std::make_move_iterator(due.begin() + i),
+                                                                 std::make_move_iterator(due.begin() + std::min(due.size(), i + batch)));
+            pool.enqueue([chunk]()
+                         { for (auto &callback : *chunk) callback(); });
+        }
+        due.clear();
+    }
+
+    Pool &pool;
+    std::chrono::nanoseconds tick;
+    clock::time_point origin;
+
+    std::mutex mutex;
+    TimerWheel wheel;
+    uint64_t armedAt = UINT64_MAX; // timerfd 当前定在的 tick
+
+    int timerFd, wakeFd;
+    std::atomic<bool> stop{false};
+    std::thread worker;
+};
+
+typedef BasicTimerService<> TimerService;
+#pragma endregion